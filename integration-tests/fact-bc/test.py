@@ -0,0 +1,23 @@
+import os
+import sys
+
+# Import common functions from ../common
+current_dir = os.path.dirname(__file__)
+sys.path.append(os.path.dirname(current_dir))
+from common.etc import *
+
+# As fact, but with the input in bitcode form
+name = os.path.basename(current_dir)
+src = os.path.join(current_dir, name + ".c")
+
+# Compile to .bc
+clang("-emit-llvm -c " + src)
+
+# Process
+olivine(name + ".bc")
+
+# Compile to an executable
+clang("a.ll")
+
+# Check result
+check_return_code("a", (), 7)
@@ -20,24 +20,60 @@ static char* optArg(int argc, char** argv, int& i, char* s) {
 	return argv[i];
 }
 
-static string readFile(string filename) {
-	std::ifstream file(filename, std::ios::binary | std::ios::ate);
-	if (!file) {
-		// Get the error code and create a system_error with the OS error message
-		std::error_code ec(errno, std::system_category());
-		throw std::system_error(ec, "Failed to open file: " + filename);
+// More threads than the machine can run at once would only contend with each other
+// and a huge number would exhaust memory, so -j is limited to this
+static size_t maxJobs() {
+	auto n = std::thread::hardware_concurrency();
+	return n ? n : 64;
+}
+
+// Read an input file, as bitcode or text according to its magic number
+// With caching, the module is also written next to the input, and read from there next time if the input has not changed
+// A cache that cannot be read is ignored, and replaced
+static Module* readInput(const string& file, size_t threads, bool cache) {
+	InputFile input(file);
+	auto text = input.text();
+	auto cacheFile = file + ".olivine";
+	uint64_t hash = 0;
+	if (cache) {
+		hash = contentHash(text);
+		std::unique_ptr<InputFile> cached;
+		try {
+			cached = std::make_unique<InputFile>(cacheFile);
+		} catch (const std::system_error&) {
+		}
+		if (cached && isCache(cached->text(), hash)) {
+			try {
+				return readCache(cacheFile, cached->text());
+			} catch (const runtime_error&) {
+			}
+		}
 	}
 
-	std::streamsize size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	auto module = isBitcode(text) ? readBitcode(file, text) : parse(file, text, threads);
 
-	string content(size, '\0');
-	if (!file.read(&content[0], size)) {
-		std::error_code ec(errno, std::system_category());
-		throw std::system_error(ec, "Failed to read file: " + filename);
+	// The cache is written under a temporary name and then renamed
+	// so an interrupted run, or another one reading the same input, never sees it partly written
+	// The name is random, so runs caching the same input at once do not write, remove or rename each other's files
+	// Failure to write it, for example because the directory is read-only or the disk is full, only means it will not be there next time
+	if (cache) {
+		std::random_device rd;
+		std::ostringstream name;
+		name << cacheFile << '.' << std::hex << rd() << rd() << ".tmp";
+		auto tmp = name.str();
+		std::ofstream os(tmp, std::ios::binary);
+		writeCache(os, *module, hash);
+		os.close();
+		if (!os) {
+			std::remove(tmp.c_str());
+			return module;
+		}
+		std::remove(cacheFile.c_str());
+		if (std::rename(tmp.c_str(), cacheFile.c_str())) {
+			std::remove(tmp.c_str());
+		}
 	}
-
-	return content;
+	return module;
 }
 
 int main(int argc, char** argv) {
@@ -46,7 +82,10 @@ int main(int argc, char** argv) {
 		SetUnhandledExceptionFilter(unhandledExceptionFilter);
 #endif
 		vector<string> files;
-		auto outFile = "a.ll";
+		string outFile;
+		size_t jobs = 1;
+		auto cache = false;
+		auto bitcode = false;
 		for (int i = 1; i < argc; i++) {
 			auto s = argv[i];
 			if (*s == '-') {
@@ -58,13 +97,32 @@ int main(int argc, char** argv) {
 				case 'v':
 					cout << "Olivine 0\n";
 					return 0;
+				case 'b':
+					bitcode = true;
+					continue;
+				case 'c':
+					cache = true;
+					continue;
 				case 'h':
-					cout << "Usage: olivine [options] file.ll ...\n";
+					cout << "Usage: olivine [options] file.ll|file.bc ...\n";
 					cout << "\n";
+					cout << "-b          Write bitcode, as does an output file name ending in .bc\n";
+					cout << "-c          Cache parsed input files next to them\n";
 					cout << "-h          Show help\n";
 					cout << "-V          Show version\n";
-					cout << "-o file.ll  Name output file\n";
+					cout << "-j N        Parse and print on N threads\n";
+					cout << "-o file     Name output file\n";
 					return 0;
+				case 'j': {
+					std::string_view n = optArg(argc, argv, i, s);
+					size_t k;
+					auto [end, ec] = std::from_chars(n.data(), n.data() + n.size(), k);
+					if (n.empty() || ec != std::errc() || end != n.data() + n.size()) {
+						throw runtime_error(string(argv[i]) + ": expected number of threads");
+					}
+					jobs = std::clamp(k, size_t(1), maxJobs());
+					continue;
+				}
 				case 'o':
 					outFile = optArg(argc, argv, i, s);
 					continue;
@@ -76,13 +134,38 @@ int main(int argc, char** argv) {
 		if (files.empty()) {
 			throw runtime_error("No input files");
 		}
-		for (auto file : files) {
-			auto text = readFile(file);
-			modules.push_back(parse(file, text));
-		}
+
+		// Each file is parsed independently, into its own slot
+		// so the modules are linked in command line order, however the parsing was scheduled
+		// Threads not needed for separate files are used to parse parts of each file
+		modules.resize(files.size());
+		auto threadsPerFile = std::max(jobs / files.size(), size_t(1));
+		parallelFor(files.size(), jobs, [&](size_t i) { modules[i] = readInput(files[i], threadsPerFile, cache); });
 		link();
+
+		// The input modules are no longer needed once linked
+		for (auto module : modules) {
+			delete module;
+		}
+		modules.clear();
+		collect();
+
+		if (outFile.size() > 3 && outFile.substr(outFile.size() - 3) == ".bc") {
+			bitcode = true;
+		}
+		if (outFile.empty()) {
+			outFile = bitcode ? "a.bc" : "a.ll";
+		}
+		// Bitcode is built in full before the output file is opened
+		// so a module the writer does not support does not leave an empty file behind
+		if (bitcode) {
+			auto s = writeBitcode(context);
+			std::ofstream os(outFile, std::ios::binary);
+			os.write(s.data(), s.size());
+			return 0;
+		}
 		std::ofstream os(outFile, std::ios::binary);
-		os << context;
+		Writer(os).write(context, jobs);
 		return 0;
 	} catch (const std::exception& e) {
 		cerr << e.what() << '\n';
@@ -2,15 +2,25 @@
 
 // C++ standard library
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <set>
+#include <shared_mutex>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
@@ -36,9 +46,18 @@ using boost::multiprecision::cpp_int;
 
 // Project header files
 #include "etc.h"
+
+#include "arena.h"
+#include "input.h"
+#include "interner.h"
+#include "parallel.h"
+#include "pvector.h"
 #include "queue.h"
+#include "scan.h"
+#include "smallvec.h"
 
 // Data structures
+#include "integer.h"
 #include "ref.h"
 #include "type.h"
 
@@ -57,7 +76,11 @@ using boost::multiprecision::cpp_int;
 // Algorithms
 #include "check.h"
 #include "fixed.h"
+#include "gc.h"
+#include "layout.h"
+#include "linearize.h"
 #include "link.h"
+#include "numbering.h"
 #include "replace.h"
 #include "simplify.h"
 #include "ssa.h"
@@ -67,3 +90,9 @@ using boost::multiprecision::cpp_int;
 #include "printer.h"
 
 #include "parser.h"
+
+#include "bitstream.h"
+
+#include "bitcode.h"
+
+#include "cache.h"
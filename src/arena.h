@@ -0,0 +1,98 @@
+// Storage for IR nodes
+// Nodes are allocated from large blocks, rather than one at a time from the general heap
+// Since the IR is purely functional, a pass produces new nodes and leaves the old ones behind
+// These are never freed individually; instead, between passes, everything still reachable is marked
+// and the rest is reclaimed in bulk by sweep, with the freed slots reused by later allocations
+// make and destroy may be called from several threads at once; sweep, like the rest of garbage collection, may not
+template <class T> class Arena {
+	struct Slot {
+		alignas(T) unsigned char data[sizeof(T)];
+		bool live;
+	};
+
+	static constexpr size_t blockSize = 4096;
+
+	vector<Slot*> blocks;
+
+	// Number of slots handed out from the last block
+	size_t used = blockSize;
+
+	vector<Slot*> freeList;
+
+	std::mutex mutex;
+
+	static Slot* slot(T* p) {
+		return reinterpret_cast<Slot*>(p);
+	}
+
+public:
+	// Arenas live for the duration of the process, and are never copied
+	// Nodes still live at exit are not destroyed, as that would only waste time
+	Arena() = default;
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// SORT FUNCTIONS
+
+	// Return a node to the arena immediately
+	// Used when a newly made node turns out to be a duplicate of one that already exists
+	void destroy(T* p) {
+		auto s = slot(p);
+		ASSERT(s->live);
+		p->~T();
+		std::lock_guard<std::mutex> lock(mutex);
+		s->live = false;
+		freeList.push_back(s);
+	}
+
+	template <class... Args> T* make(Args&&... args) {
+		Slot* s;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (freeList.size()) {
+				s = freeList.back();
+				freeList.pop_back();
+			} else {
+				if (used == blockSize) {
+					blocks.push_back(new Slot[blockSize]());
+					used = 0;
+				}
+				s = blocks.back() + used++;
+			}
+		}
+		auto p = new (s->data) T(std::forward<Args>(args)...);
+		s->live = true;
+		return p;
+	}
+
+	// Number of live nodes
+	size_t size() const {
+		size_t n = blockSize * blocks.size();
+		if (blocks.size()) {
+			n -= blockSize - used;
+		}
+		return n - freeList.size();
+	}
+
+	// Destroy every node for which the predicate returns false
+	// Returns the number of nodes reclaimed
+	template <class F> size_t sweep(F keep) {
+		size_t n = 0;
+		for (size_t i = 0; i < blocks.size(); i++) {
+			auto end = i + 1 == blocks.size() ? used : blockSize;
+			for (size_t j = 0; j < end; j++) {
+				auto s = blocks[i] + j;
+				if (!s->live) {
+					continue;
+				}
+				auto p = reinterpret_cast<T*>(s->data);
+				if (keep(p)) {
+					continue;
+				}
+				destroy(p);
+				n++;
+			}
+		}
+		return n;
+	}
+};
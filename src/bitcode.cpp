@@ -0,0 +1,2111 @@
+#include "all.h"
+
+namespace {
+// Block IDs
+enum {
+	ModuleBlock = 8,
+	ConstantsBlock = 11,
+	FunctionBlock = 12,
+	ValueSymtabBlock = 14,
+	TypeBlock = 17,
+	StrtabBlock = 23,
+};
+
+// Module records
+enum {
+	VersionCode = 1,
+	TripleCode = 2,
+	DatalayoutCode = 3,
+	GlobalVarCode = 7,
+	FunctionCode = 8,
+	ComdatCode = 12,
+};
+
+// Type records
+enum {
+	NumEntryType = 1,
+	VoidType = 2,
+	FloatType = 3,
+	DoubleType = 4,
+	IntegerType = 7,
+	PointerType = 8,
+	ArrayType = 11,
+	VectorType = 12,
+	StructAnonType = 18,
+	StructNameType = 19,
+	StructNamedType = 20,
+	FunctionType = 21,
+	OpaquePointerType = 25,
+};
+
+// Constant records
+enum {
+	SetTypeConst = 1,
+	NullConst = 2,
+	IntegerConst = 4,
+	WideIntegerConst = 5,
+	FloatConst = 6,
+	AggregateConst = 7,
+	StringConst = 8,
+	CStringConst = 9,
+	DataConst = 22,
+};
+
+// Instruction records
+enum {
+	DeclareBlocksInst = 1,
+	BinopInst = 2,
+	CastInst = 3,
+	RetInst = 10,
+	BrInst = 11,
+	SwitchInst = 12,
+	UnreachableInst = 15,
+	PhiInst = 16,
+	AllocaInst = 19,
+	LoadInst = 20,
+	Cmp2Inst = 28,
+	DebugLocAgainInst = 33,
+	CallInst = 34,
+	DebugLocInst = 35,
+	GepInst = 43,
+	StoreInst = 44,
+	OperandBundleInst = 55,
+	UnopInst = 56,
+	BlockAddrUsersInst = 60,
+	DebugRecordValueInst = 61,
+	DebugRecordDeclareInst = 62,
+	DebugRecordAssignInst = 63,
+	DebugRecordValueSimpleInst = 64,
+	DebugRecordLabelInst = 65,
+};
+
+// Value symbol table records
+enum {
+	EntryCode = 1,
+	BlockEntryCode = 2,
+};
+
+// String table records
+enum {
+	StrtabBlobCode = 1,
+};
+
+// Bit of the alignment field of an alloca record
+constexpr unsigned allocaExplicitType = 6;
+
+// Bits of the calling convention field of a call record
+constexpr unsigned callExplicitType = 15;
+constexpr unsigned callFastMath = 17;
+
+// An operand that needs no instruction of its own
+bool atomic(Term a) {
+	return !a.size() || a.constant();
+}
+
+// The opcode of a binary operator record, or -1 if the operation is not one
+int binaryOpcode(Tag tag) {
+	switch (tag) {
+	case Add:
+	case FAdd:
+		return 0;
+	case FSub:
+	case Sub:
+		return 1;
+	case FMul:
+	case Mul:
+		return 2;
+	case UDiv:
+		return 3;
+	case FDiv:
+	case SDiv:
+		return 4;
+	case URem:
+		return 5;
+	case FRem:
+	case SRem:
+		return 6;
+	case Shl:
+		return 7;
+	case LShr:
+		return 8;
+	case AShr:
+		return 9;
+	case And:
+		return 10;
+	case Or:
+		return 11;
+	case Xor:
+		return 12;
+	}
+	return -1;
+}
+
+// The opcode of a cast record
+// Cast is the unsigned or bitwise conversion between the types, and SCast the signed one, as in the parser
+unsigned castOpcode(Term a) {
+	auto from = a[0].ty();
+	auto to = a.ty();
+	auto s = a.tag() == SCast;
+	if (isInt(from) && isInt(to)) {
+		if (from.len() < to.len()) {
+			return s ? 2 : 1;
+		}
+		if (from.len() > to.len()) {
+			return 0;
+		}
+	}
+	if (isFloat(from) && isInt(to)) {
+		return s ? 4 : 3;
+	}
+	if (isInt(from) && isFloat(to)) {
+		return s ? 6 : 5;
+	}
+	if (from.kind() == FloatKind && to.kind() == DoubleKind) {
+		return 8;
+	}
+	if (from.kind() == DoubleKind && to.kind() == FloatKind) {
+		return 7;
+	}
+	if (from.kind() == PtrKind && isInt(to)) {
+		return 9;
+	}
+	if (isInt(from) && to.kind() == PtrKind) {
+		return 10;
+	}
+	return 11;
+}
+
+vector<uint64_t> charCodes(const string& s) {
+	vector<uint64_t> v;
+	for (auto c : s) {
+		v.push_back(uint8_t(c));
+	}
+	return v;
+}
+
+string chars(const vector<uint64_t>& ops, size_t i = 0) {
+	string s;
+	for (; i < ops.size(); i++) {
+		s += char(ops[i]);
+	}
+	return s;
+}
+
+// The predicate of a comparison record
+uint64_t cmpPredicate(Tag tag) {
+	switch (tag) {
+	case Eq:
+		return 32;
+	case FEq:
+		return 1;
+	case FLe:
+		return 5;
+	case FLt:
+		return 4;
+	case SLe:
+		return 41;
+	case SLt:
+		return 40;
+	case ULe:
+		return 37;
+	case ULt:
+		return 36;
+	}
+	ASSERT(false && "Not a comparison");
+	return 0;
+}
+
+// Signed integers are stored with the sign in the lowest bit
+int64_t decodeSigned(uint64_t x) {
+	if (!(x & 1)) {
+		return x >> 1;
+	}
+	if (x != 1) {
+		return -int64_t(x >> 1);
+	}
+
+	// There is no negative zero, so this stands for the most negative value
+	return (std::numeric_limits<int64_t>::min)();
+}
+
+uint64_t encodeSigned(int64_t x) {
+	auto u = uint64_t(x);
+	if (x >= 0) {
+		return u << 1;
+	}
+	return (0 - u) << 1 | 1;
+}
+
+// The bits of a floating-point constant, as spelled in the textual form
+// in decimal, or in hexadecimal as the bits of the value widened to double
+uint64_t floatBits(Term a) {
+	auto& s = a.ref().str();
+	double x;
+	if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+		auto bits = std::strtoull(s.c_str() + 2, 0, 16);
+		memcpy(&x, &bits, sizeof x);
+	} else {
+		x = std::strtod(s.c_str(), 0);
+	}
+	if (a.ty().kind() == FloatKind) {
+		auto y = float(x);
+		uint32_t bits;
+		memcpy(&bits, &y, sizeof bits);
+		return bits;
+	}
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof bits);
+	return bits;
+}
+
+// LLVM writes floating-point constants that cannot be written exactly in decimal, in this format
+// Single precision values are widened to double first
+string hexFloat(double x) {
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof bits);
+	std::ostringstream os;
+	os << "0x" << std::hex << std::uppercase << std::setw(16) << std::setfill('0') << bits;
+	return os.str();
+}
+
+runtime_error invalid(const string& msg) {
+	return runtime_error("invalid bitcode: " + msg);
+}
+
+// Arrays and vectors of plain numbers are written as a list of their bits, without a separate constant for each element
+// LLVM accepts this only for integers of 8, 16, 32 or 64 bits, and floating point
+bool isData(Term a) {
+	if ((a.tag() != Array && a.tag() != Vec) || !a.size()) {
+		return false;
+	}
+	auto element = a.ty()[0];
+	if (isInt(element)) {
+		switch (element.len()) {
+		case 8:
+		case 16:
+		case 32:
+		case 64:
+			break;
+		default:
+			return false;
+		}
+	} else if (!isFloat(element)) {
+		return false;
+	}
+	for (auto b : a) {
+		if (b.tag() != Int && b.tag() != Float) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Zero, null and aggregates of them are all written as a null constant
+bool isZero(Term a) {
+	switch (a.tag()) {
+	case Array:
+	case Tuple:
+	case Vec:
+		for (auto b : a) {
+			if (!isZero(b)) {
+				return false;
+			}
+		}
+		return true;
+	case Float:
+		return !floatBits(a);
+	case Int:
+		return !a.intVal();
+	case NullPtr:
+		return true;
+	}
+	return false;
+}
+
+uint32_t load32(std::string_view data, size_t i) {
+	uint32_t r = 0;
+	for (size_t j = 0; j < 4; j++) {
+		r |= uint32_t(uint8_t(data[i + j])) << (j * 8);
+	}
+	return r;
+}
+
+// The low 64 bits of an integer, in two's complement
+uint64_t lowBits(const Integer& a) {
+	if (a.isSmall()) {
+		return a.toSmall();
+	}
+	cpp_int m = 1;
+	m <<= 64;
+	cpp_int x = a.toCppInt() % m;
+	if (x < 0) {
+		x += m;
+	}
+	return x.convert_to<uint64_t>();
+}
+
+int64_t signExtend(uint64_t x, size_t bits) {
+	if (bits >= 64) {
+		return x;
+	}
+	return int64_t(x << (64 - bits)) >> (64 - bits);
+}
+
+runtime_error unsupported(const string& msg) {
+	return runtime_error("unsupported in bitcode: " + msg);
+}
+
+// Instruction records are read in full before any are decoded
+// as their operands may refer to values whose names are only given by the symbol table at the end of the function
+struct InstRecord {
+	unsigned code;
+	vector<uint64_t> ops;
+
+	// The ID that will be given to the next value defined, which operands are relative to
+	uint32_t next = 0;
+
+	// Which basic block the instruction is in
+	size_t block = 0;
+
+	bool defines = false;
+};
+
+class BitcodeReader {
+	BitstreamReader in;
+	std::string_view strtab;
+	Module* module = new Module;
+
+	// The type table
+	// Types are resolved on first use, as named structures may refer to types defined after them
+	// Types that cannot be represented are an error only if used
+	struct TypeEntry {
+		unsigned code = 0;
+		vector<uint64_t> ops;
+		bool resolving = false;
+		bool done = false;
+		Type ty;
+		bool vararg = false;
+	};
+	vector<TypeEntry> types;
+
+	// The value table, numbered as in LLVM: global variables and functions, then module-level constants
+	// and while a function is being read, its arguments, constants and instruction results
+	// Constants are resolved on first use, as they may refer to each other in any order
+	struct Value {
+		Type ty;
+		Term term;
+		bool done = false;
+
+		// For a constant not yet resolved
+		unsigned code = 0;
+		vector<uint64_t> ops;
+		bool resolving = false;
+	};
+	vector<Value> values;
+
+	// Global variables, which are built once their initializers are available
+	struct GlobalVar {
+		Ref ref;
+		Type ty;
+		uint64_t init;
+	};
+	vector<GlobalVar> globalVars;
+
+	// Functions with bodies, in the order in which their bodies appear
+	struct FunctionEntry {
+		Ref ref;
+		size_t ty;
+	};
+	vector<FunctionEntry> bodies;
+	size_t nextBody = 0;
+
+	// Unnamed global variables and functions are numbered in order
+	size_t globalNum = 0;
+
+	// SORT FUNCTIONS
+
+	// The function type of a call, after skipping the attributes and calling convention
+	Type callType(const InstRecord& r, size_t& i) {
+		// Attributes
+		op(r, i);
+
+		auto cc = op(r, i);
+		if (cc >> callFastMath & 1) {
+			op(r, i);
+		}
+		if (!(cc >> callExplicitType & 1)) {
+			throw unsupported("call without explicit function type");
+		}
+		auto fty = type(op(r, i));
+		if (fty.kind() != FuncKind) {
+			throw invalid("call type");
+		}
+		return fty;
+	}
+
+	// Comparisons are expressed with the same operations the parser uses for each predicate
+	Term compare(Term a, Term b, uint64_t predicate) {
+		switch (predicate) {
+		// fcmp
+		case 1:
+			return cmp(FEq, a, b);
+		case 2:
+			return cmp(FLt, b, a);
+		case 3:
+			return cmp(FLe, b, a);
+		case 4:
+			return cmp(FLt, a, b);
+		case 5:
+			return cmp(FLe, a, b);
+		case 10:
+			return not1(cmp(FLe, a, b));
+		case 11:
+			return not1(cmp(FLt, a, b));
+		case 12:
+			return not1(cmp(FLe, b, a));
+		case 13:
+			return not1(cmp(FLt, b, a));
+		case 14:
+			return not1(cmp(FEq, b, a));
+
+		// icmp
+		case 32:
+			return cmp(Eq, a, b);
+		case 33:
+			return not1(cmp(Eq, b, a));
+		case 34:
+			return cmp(ULt, b, a);
+		case 35:
+			return cmp(ULe, b, a);
+		case 36:
+			return cmp(ULt, a, b);
+		case 37:
+			return cmp(ULe, a, b);
+		case 38:
+			return cmp(SLt, b, a);
+		case 39:
+			return cmp(SLe, b, a);
+		case 40:
+			return cmp(SLt, a, b);
+		case 41:
+			return cmp(SLe, a, b);
+		}
+		throw unsupported("comparison predicate " + to_string(predicate));
+	}
+
+	Term constant(size_t id) {
+		auto& v = values[id];
+		if (v.done) {
+			return v.term;
+		}
+		if (v.resolving) {
+			throw invalid("constant refers to itself");
+		}
+		v.resolving = true;
+		auto term = constant1(v.ty, v.code, v.ops);
+
+		// The table may have moved
+		auto& w = values[id];
+		w.term = term;
+		w.done = true;
+		w.ops.clear();
+		return term;
+	}
+
+	Term constant1(Type ty, unsigned code, const vector<uint64_t>& ops) {
+		switch (code) {
+		case AggregateConst: {
+			vector<Term> v;
+			for (auto id : ops) {
+				v.push_back(term(id));
+			}
+			switch (ty.kind()) {
+			case ArrayKind:
+				return array(ty[0], v);
+			case StructKind:
+				return tuple(v);
+			case VecKind:
+				return vec(ty[0], v);
+			}
+			break;
+		}
+		case CStringConst:
+		case StringConst: {
+			string s = chars(ops);
+			if (code == CStringConst) {
+				s += '\0';
+			}
+			return arrayBytes((unsigned char*)s.data(), s.size());
+		}
+		case DataConst: {
+			// Elements of simple type, written as plain numbers
+			if (ty.kind() != ArrayKind && ty.kind() != VecKind) {
+				break;
+			}
+			auto element = ty[0];
+			vector<Term> v;
+			for (auto x : ops) {
+				if (isInt(element)) {
+					v.push_back(intConst(element, signExtend(x, element.len())));
+				} else {
+					v.push_back(constant1(element, FloatConst, {x}));
+				}
+			}
+			return ty.kind() == ArrayKind ? array(element, v) : vec(element, v);
+		}
+		case FloatConst:
+			if (ops.empty()) {
+				throw invalid("float constant");
+			}
+			switch (ty.kind()) {
+			case DoubleKind: {
+				double x;
+				memcpy(&x, &ops[0], sizeof x);
+				return floatConst(ty, hexFloat(x));
+			}
+			case FloatKind: {
+				auto bits = uint32_t(ops[0]);
+				float x;
+				memcpy(&x, &bits, sizeof x);
+				return floatConst(ty, hexFloat(x));
+			}
+			}
+			break;
+		case IntegerConst: {
+			if (!isInt(ty) || ops.empty()) {
+				break;
+			}
+
+			// Values are sign-extended, but bool constants are written as true and false
+			auto x = decodeSigned(ops[0]);
+			if (ty == boolTy()) {
+				return x ? trueConst : falseConst;
+			}
+			return intConst(ty, signExtend(x, ty.len()));
+		}
+		case NullConst:
+			if (ty.kind() == PtrKind) {
+				return nullPtrConst;
+			}
+			return zeroVal(ty);
+		case WideIntegerConst: {
+			if (!isInt(ty)) {
+				break;
+			}
+
+			// Words, least significant first, each written as a signed value
+			cpp_int x;
+			for (size_t i = ops.size(); i--;) {
+				x <<= 64;
+				x |= uint64_t(decodeSigned(ops[i]));
+			}
+			cpp_int bit = 1;
+			bit <<= ty.len();
+			x &= bit - 1;
+			if (x >> (ty.len() - 1)) {
+				x -= bit;
+			}
+			return intConst(ty, x);
+		}
+		}
+		throw unsupported("constant (code " + to_string(code) + ')');
+	}
+
+	Fn function(const FunctionEntry& f) {
+		auto fty = type(f.ty);
+		if (fty.kind() != FuncKind) {
+			throw invalid("function type");
+		}
+		auto rty = fty[0];
+		auto base = values.size();
+
+		// Arguments
+		for (size_t i = 1; i < fty.size(); i++) {
+			Value v;
+			v.ty = fty[i];
+			v.done = true;
+			values.push_back(v);
+		}
+
+		// Read the whole function, before decoding any instructions
+		vector<InstRecord> insts;
+		size_t blocks = 0;
+		unordered_map<size_t, string> names;
+		unordered_map<size_t, string> blockNames;
+		vector<uint64_t> ops;
+		for (;;) {
+			unsigned id;
+			auto entry = in.advance(id);
+			if (entry == BitstreamReader::End) {
+				break;
+			}
+			if (entry == BitstreamReader::Block) {
+				switch (id) {
+				case ConstantsBlock:
+					in.enterBlock(id);
+					readConstants();
+					break;
+				case ValueSymtabBlock:
+					in.enterBlock(id);
+					readSymtab(names, blockNames);
+					break;
+				default:
+					in.skipBlock();
+				}
+				continue;
+			}
+			auto code = in.readRecord(ops);
+			switch (code) {
+			case BlockAddrUsersInst:
+			case DebugLocAgainInst:
+			case DebugLocInst:
+			case DebugRecordAssignInst:
+			case DebugRecordDeclareInst:
+			case DebugRecordLabelInst:
+			case DebugRecordValueInst:
+			case DebugRecordValueSimpleInst:
+			case OperandBundleInst:
+				break;
+			case DeclareBlocksInst:
+				if (ops.empty() || !ops[0]) {
+					throw invalid("DECLAREBLOCKS");
+				}
+				blocks = ops[0];
+				break;
+			default:
+				insts.push_back({code, ops});
+			}
+		}
+		if (!blocks) {
+			throw invalid("function without blocks");
+		}
+
+		// Work out which instructions define values, and their types
+		size_t block = 0;
+		for (auto& r : insts) {
+			if (block == blocks) {
+				throw invalid("instruction after last block");
+			}
+			r.next = values.size();
+			r.block = block;
+			auto ty = resultType(r);
+			if (ty.kind() != VoidKind) {
+				r.defines = true;
+				Value v;
+				v.ty = ty;
+				v.done = true;
+				values.push_back(v);
+			}
+			switch (r.code) {
+			case BrInst:
+			case RetInst:
+			case SwitchInst:
+			case UnreachableInst:
+				block++;
+			}
+		}
+
+		// Number the unnamed values in the order they would be numbered in the textual form
+		// arguments, then each block label followed by the results of the instructions in that block
+		size_t num = 0;
+		auto name = [&](const unordered_map<size_t, string>& names, size_t i) {
+			auto j = names.find(i);
+			if (j == names.end()) {
+				return Ref(num++);
+			}
+			return Ref(j->second);
+		};
+		vector<Term> params;
+		for (size_t i = 1; i < fty.size(); i++) {
+			auto id = base + i - 1;
+			auto& v = values[id];
+			v.term = var(v.ty, name(names, id));
+			params.push_back(v.term);
+		}
+		if (types[f.ty].vararg) {
+			params.push_back(Term(Array));
+		}
+		vector<Ref> blockRefs;
+		for (auto& r : insts) {
+			while (blockRefs.size() <= r.block) {
+				blockRefs.push_back(name(blockNames, blockRefs.size()));
+			}
+			if (r.defines) {
+				auto& v = values[r.next];
+				v.term = var(v.ty, name(names, r.next));
+			}
+		}
+		while (blockRefs.size() < blocks) {
+			blockRefs.push_back(name(blockNames, blockRefs.size()));
+		}
+
+		// The entry block only has a label if it is named
+		vector<Inst> body;
+		for (size_t i = 0; i < insts.size(); i++) {
+			auto& r = insts[i];
+			if (i ? insts[i - 1].block != r.block : blockNames.count(0)) {
+				body.push_back(::block(blockRefs[r.block]));
+			}
+			body.push_back(inst(r, blockRefs));
+		}
+
+		values.resize(base);
+		return Fn(rty, f.ref, params, body);
+	}
+
+	// Global variables and functions are named from the string table, or numbered if they have no name
+	Ref globalName(const vector<uint64_t>& ops) {
+		auto s = name(ops);
+		if (s.empty()) {
+			return Ref(globalNum++);
+		}
+		return Ref(s);
+	}
+
+	Inst inst(const InstRecord& r, const vector<Ref>& blockRefs) {
+		auto& ops = r.ops;
+		size_t i = 0;
+		auto label1 = [&]() {
+			auto b = op(r, i);
+			if (b >= blockRefs.size()) {
+				throw invalid("block number");
+			}
+			return label(blockRefs[b]);
+		};
+		auto lval = [&]() { return values[r.next].term; };
+
+		switch (r.code) {
+		case AllocaInst: {
+			if (ops.size() < 3) {
+				throw invalid("alloca");
+			}
+			auto ty = type(ops[0]);
+			auto n = term(ops[2]);
+
+			// The textual form omits the usual count of one
+			if (n == intConst(intTy(32), 1)) {
+				n = intConst(1);
+			}
+			return alloca(lval(), ty, n);
+		}
+		case BinopInst: {
+			auto a = term(valueType(r, i).first);
+			auto b = term(value(r, i));
+			auto ty = a.ty();
+			auto fp = isFloat(ty) || (ty.kind() == VecKind && isFloat(ty[0]));
+			Tag tag;
+			switch (op(r, i)) {
+			case 0:
+				tag = fp ? FAdd : Add;
+				break;
+			case 1:
+				tag = fp ? FSub : Sub;
+				break;
+			case 2:
+				tag = fp ? FMul : Mul;
+				break;
+			case 3:
+				tag = UDiv;
+				break;
+			case 4:
+				tag = fp ? FDiv : SDiv;
+				break;
+			case 5:
+				tag = URem;
+				break;
+			case 6:
+				tag = fp ? FRem : SRem;
+				break;
+			case 7:
+				tag = Shl;
+				break;
+			case 8:
+				tag = LShr;
+				break;
+			case 9:
+				tag = AShr;
+				break;
+			case 10:
+				tag = And;
+				break;
+			case 11:
+				tag = Or;
+				break;
+			case 12:
+				tag = Xor;
+				break;
+			default:
+				throw invalid("binary operator");
+			}
+			return assign(lval(), Term(tag, ty, a, b));
+		}
+		case BrInst: {
+			auto yes = label1();
+			if (i == ops.size()) {
+				return jmp(yes);
+			}
+			auto no = label1();
+			auto cond = term(value(r, i));
+			return br(cond, yes, no);
+		}
+		case CallInst: {
+			auto fty = callType(r, i);
+			auto f = term(valueType(r, i).first);
+			if (f.tag() != GlobalRef) {
+				throw unsupported("indirect call");
+			}
+			vector<Term> args;
+			for (size_t j = 1; j < fty.size(); j++) {
+				args.push_back(term(value(r, i)));
+			}
+			while (i < ops.size()) {
+				args.push_back(term(valueType(r, i).first));
+			}
+			auto rty = fty[0];
+			auto params = map(args, [](Term a) { return a.ty(); });
+			auto a = call(rty, globalRef(fnTy(rty, params), f.ref()), args);
+			if (rty.kind() == VoidKind) {
+				return Inst(Drop, a);
+			}
+			return assign(lval(), a);
+		}
+		case CastInst: {
+			auto a = term(valueType(r, i).first);
+			auto ty = type(op(r, i));
+			switch (op(r, i)) {
+			// sext, fptosi, sitofp
+			case 2:
+			case 4:
+			case 6:
+				return assign(lval(), Term(SCast, ty, a));
+			}
+			return assign(lval(), Term(Cast, ty, a));
+		}
+		case Cmp2Inst: {
+			auto a = term(valueType(r, i).first);
+			auto b = term(value(r, i));
+			return assign(lval(), compare(a, b, op(r, i)));
+		}
+		case GepInst: {
+			// Flags such as inbounds
+			op(r, i);
+
+			auto ty = type(op(r, i));
+			auto p = term(valueType(r, i).first);
+			vector<Term> idxs;
+			while (i < ops.size()) {
+				idxs.push_back(term(valueType(r, i).first));
+			}
+			return assign(lval(), getElementPtr(ty, p, idxs));
+		}
+		case LoadInst: {
+			auto p = term(valueType(r, i).first);
+			auto ty = values[r.next].ty;
+			return assign(lval(), Term(Load, ty, p));
+		}
+		case PhiInst: {
+			// The type was already read, to give the result its type
+			type(op(r, i));
+			vector<Term> v{lval()};
+
+			// A trailing operand holds fast-math flags
+			while (i + 1 < ops.size()) {
+				auto id = uint32_t(r.next - decodeSigned(op(r, i)));
+				v.push_back(term(id));
+				v.push_back(label1());
+			}
+			return Inst(Phi, v);
+		}
+		case RetInst:
+			if (ops.empty()) {
+				return ret();
+			}
+			return ret(term(valueType(r, i).first));
+		case StoreInst: {
+			auto p = term(valueType(r, i).first);
+			auto a = term(valueType(r, i).first);
+			return store(a, p);
+		}
+		case SwitchInst: {
+			auto ty = type(op(r, i));
+			vector<Term> v;
+			v.push_back(term(value(r, i)));
+			v.push_back(label1());
+			while (i < ops.size()) {
+				// Case values are absolute IDs of constants
+				auto x = term(op(r, i));
+				if (x.ty() != ty) {
+					throw invalid("switch case type");
+				}
+				v.push_back(x);
+				v.push_back(label1());
+			}
+			return Inst(Switch, v);
+		}
+		case UnopInst: {
+			auto a = term(valueType(r, i).first);
+			if (op(r, i)) {
+				throw invalid("unary operator");
+			}
+			return assign(lval(), Term(FNeg, a.ty(), a));
+		}
+		case UnreachableInst:
+			return unreachable();
+		}
+		throw unsupported("instruction (code " + to_string(r.code) + ')');
+	}
+
+	string name(const vector<uint64_t>& ops) {
+		if (ops.size() < 2) {
+			throw invalid("name");
+		}
+		auto offset = ops[0];
+		auto size = ops[1];
+		if (offset + size > strtab.size()) {
+			throw invalid("string table offset");
+		}
+		return string(strtab.substr(offset, size));
+	}
+
+	uint64_t op(const InstRecord& r, size_t& i) {
+		if (i >= r.ops.size()) {
+			throw invalid("too few operands (code " + to_string(r.code) + ')');
+		}
+		return r.ops[i++];
+	}
+
+	void readConstants() {
+		vector<uint64_t> ops;
+		Type ty;
+		for (;;) {
+			unsigned id;
+			auto entry = in.advance(id);
+			if (entry == BitstreamReader::End) {
+				return;
+			}
+			if (entry == BitstreamReader::Block) {
+				in.skipBlock();
+				continue;
+			}
+			auto code = in.readRecord(ops);
+			if (code == SetTypeConst) {
+				if (ops.empty()) {
+					throw invalid("SETTYPE");
+				}
+				ty = type(ops[0]);
+				continue;
+			}
+			Value v;
+			v.ty = ty;
+			v.code = code;
+			v.ops = ops;
+			values.push_back(v);
+		}
+	}
+
+	void readModule() {
+		vector<uint64_t> ops;
+		vector<Fn> defs;
+		for (;;) {
+			unsigned id;
+			auto entry = in.advance(id);
+			if (entry == BitstreamReader::End) {
+				break;
+			}
+			if (entry == BitstreamReader::Block) {
+				switch (id) {
+				case ConstantsBlock:
+					in.enterBlock(id);
+					readConstants();
+					break;
+				case FunctionBlock:
+					if (nextBody == bodies.size()) {
+						throw invalid("more function bodies than definitions");
+					}
+					in.enterBlock(id);
+					defs.push_back(function(bodies[nextBody++]));
+					break;
+				case TypeBlock:
+					in.enterBlock(id);
+					readTypes();
+					break;
+				default:
+					in.skipBlock();
+				}
+				continue;
+			}
+			auto code = in.readRecord(ops);
+			switch (code) {
+			case ComdatCode:
+				module->comdats.push_back(Ref(name(ops)));
+				break;
+			case DatalayoutCode:
+				module->datalayout = chars(ops);
+				break;
+			case FunctionCode: {
+				// [strtab offset, strtab size, type, calling convention, is declaration, ...]
+				if (ops.size() < 5) {
+					throw invalid("function record");
+				}
+				FunctionEntry f{globalName(ops), ops[2]};
+				if (ops[4]) {
+					auto fty = type(f.ty);
+					if (fty.kind() != FuncKind) {
+						throw invalid("function type");
+					}
+					vector<Term> params;
+					for (size_t i = 1; i < fty.size(); i++) {
+						params.push_back(none(fty[i]));
+					}
+					if (types[f.ty].vararg) {
+						params.push_back(Term(Array));
+					}
+					module->decls.push_back(Fn(fty[0], f.ref, params));
+				} else {
+					bodies.push_back(f);
+				}
+				Value v;
+				v.ty = ptrTy();
+				v.term = globalRef(ptrTy(), f.ref);
+				v.done = true;
+				values.push_back(v);
+				break;
+			}
+			case GlobalVarCode: {
+				// [strtab offset, strtab size, type, constant | explicit type << 1 | address space << 2, initializer + 1, ...]
+				if (ops.size() < 5) {
+					throw invalid("global variable record");
+				}
+				if (!(ops[3] & 2)) {
+					throw unsupported("global variable without explicit type");
+				}
+				if (ops[3] >> 2) {
+					throw unsupported("address space");
+				}
+				globalVars.push_back({globalName(ops), type(ops[2]), ops[4]});
+				Value v;
+				v.ty = ptrTy();
+				v.term = globalRef(ptrTy(), globalVars.back().ref);
+				v.done = true;
+				values.push_back(v);
+				break;
+			}
+			case TripleCode:
+				module->triple = chars(ops);
+				break;
+			case VersionCode:
+				// Version 2 keeps names in the string table, and uses relative value IDs
+				if (ops.empty() || ops[0] != 2) {
+					throw unsupported("bitcode version");
+				}
+				break;
+			}
+		}
+		if (nextBody != bodies.size()) {
+			throw invalid("missing function bodies");
+		}
+
+		for (auto& g : globalVars) {
+			if (g.init) {
+				module->globals.push_back(Global(g.ty, g.ref, term(g.init - 1)));
+			} else {
+				module->globals.push_back(Global(g.ty, g.ref));
+			}
+		}
+		module->defs = defs;
+	}
+
+	void readSymtab(unordered_map<size_t, string>& names, unordered_map<size_t, string>& blockNames) {
+		vector<uint64_t> ops;
+		for (;;) {
+			unsigned id;
+			auto entry = in.advance(id);
+			if (entry == BitstreamReader::End) {
+				return;
+			}
+			if (entry == BitstreamReader::Block) {
+				in.skipBlock();
+				continue;
+			}
+			auto code = in.readRecord(ops);
+			if (ops.empty()) {
+				continue;
+			}
+			switch (code) {
+			case BlockEntryCode:
+				blockNames[ops[0]] = chars(ops, 1);
+				break;
+			case EntryCode:
+				names[ops[0]] = chars(ops, 1);
+				break;
+			}
+		}
+	}
+
+	void readTypes() {
+		vector<uint64_t> ops;
+		for (;;) {
+			unsigned id;
+			auto entry = in.advance(id);
+			if (entry == BitstreamReader::End) {
+				return;
+			}
+			if (entry == BitstreamReader::Block) {
+				in.skipBlock();
+				continue;
+			}
+			auto code = in.readRecord(ops);
+			switch (code) {
+			case NumEntryType:
+				if (ops.size()) {
+					types.reserve(ops[0]);
+				}
+				continue;
+			case StructNameType:
+				// Structures are identified by their fields
+				continue;
+			}
+			TypeEntry t;
+			t.code = code;
+			t.ops = ops;
+			types.push_back(t);
+		}
+	}
+
+	// The type of the value an instruction defines, or void if it does not define one
+	Type resultType(const InstRecord& r) {
+		size_t i = 0;
+		switch (r.code) {
+		case AllocaInst:
+		case GepInst:
+			return ptrTy();
+		case BinopInst:
+		case UnopInst:
+			return valueType(r, i).second;
+		case CallInst:
+			return callType(r, i)[0];
+		case CastInst:
+			valueType(r, i);
+			return type(op(r, i));
+		case Cmp2Inst: {
+			auto ty = valueType(r, i).second;
+			if (ty.kind() == VecKind) {
+				return vecTy(ty.len(), boolTy());
+			}
+			return boolTy();
+		}
+		case LoadInst:
+			valueType(r, i);
+			if (i + 3 != r.ops.size()) {
+				throw unsupported("load without explicit type");
+			}
+			return type(op(r, i));
+		case PhiInst:
+			return type(op(r, i));
+		}
+		return voidTy();
+	}
+
+	Term term(size_t id) {
+		if (id >= values.size()) {
+			throw invalid("value ID " + to_string(id));
+		}
+		return constant(id);
+	}
+
+	Type type(size_t id) {
+		if (id >= types.size()) {
+			throw invalid("type ID " + to_string(id));
+		}
+		auto& t = types[id];
+		if (t.done) {
+			return t.ty;
+		}
+		if (t.resolving) {
+			throw unsupported("recursive type");
+		}
+		t.resolving = true;
+		auto ty = type1(id);
+
+		// The table does not grow while types are resolved, so the reference is still valid
+		t.ty = ty;
+		t.done = true;
+		return ty;
+	}
+
+	Type type1(size_t id) {
+		auto& t = types[id];
+		auto& ops = t.ops;
+		switch (t.code) {
+		case ArrayType:
+			if (ops.size() < 2) {
+				throw invalid("array type");
+			}
+			return arrayTy(ops[0], type(ops[1]));
+		case DoubleType:
+			return doubleTy();
+		case FloatType:
+			return floatTy();
+		case FunctionType: {
+			// [vararg, return type, parameter types...]
+			if (ops.size() < 2) {
+				throw invalid("function type");
+			}
+			t.vararg = ops[0];
+			vector<Type> params;
+			for (size_t i = 2; i < ops.size(); i++) {
+				params.push_back(type(ops[i]));
+			}
+			return fnTy(type(ops[1]), params);
+		}
+		case IntegerType:
+			if (ops.empty() || !ops[0]) {
+				throw invalid("integer type");
+			}
+			return intTy(ops[0]);
+		case OpaquePointerType:
+		case PointerType: {
+			// Typed pointers have the pointee type first
+			size_t space = t.code == OpaquePointerType ? 0 : 1;
+			if (space < ops.size() && ops[space]) {
+				throw unsupported("address space");
+			}
+			return ptrTy();
+		}
+		case StructAnonType:
+		case StructNamedType: {
+			// [packed, field types...]
+			if (ops.empty()) {
+				throw unsupported("opaque structure");
+			}
+			if (ops[0]) {
+				throw unsupported("packed structure");
+			}
+			vector<Type> fields;
+			for (size_t i = 1; i < ops.size(); i++) {
+				fields.push_back(type(ops[i]));
+			}
+			return structTy(fields);
+		}
+		case VectorType:
+			// A third operand indicates a scalable vector
+			if (ops.size() < 2 || (ops.size() > 2 && ops[2])) {
+				throw unsupported("vector type");
+			}
+			return vecTy(ops[0], type(ops[1]));
+		case VoidType:
+			return voidTy();
+		}
+		throw unsupported("type (code " + to_string(t.code) + ')');
+	}
+
+	// An operand given as an ID relative to the instruction
+	size_t value(const InstRecord& r, size_t& i) {
+		return uint32_t(r.next - uint32_t(op(r, i)));
+	}
+
+	// An operand given as a relative ID, followed by its type if it is a forward reference
+	pair<size_t, Type> valueType(const InstRecord& r, size_t& i) {
+		auto id = value(r, i);
+		if (id < r.next) {
+			if (id >= values.size()) {
+				throw invalid("value ID " + to_string(id));
+			}
+			return {id, values[id].ty};
+		}
+		return {id, type(op(r, i))};
+	}
+
+public:
+	explicit BitcodeReader(std::string_view data): in(data) {
+	}
+
+	Module* read() {
+		// Names are in the string table, which comes after the module, so find that first
+		{
+			BitstreamReader scan = in;
+			vector<uint64_t> ops;
+			unsigned id;
+			while (scan.advance(id) == BitstreamReader::Block) {
+				if (id != StrtabBlock) {
+					scan.skipBlock();
+					continue;
+				}
+				scan.enterBlock(id);
+				while (scan.advance(id) == BitstreamReader::Record) {
+					scan.readRecord(ops, &strtab);
+				}
+			}
+		}
+
+		unsigned id;
+		while (in.advance(id) == BitstreamReader::Block) {
+			if (id != ModuleBlock) {
+				in.skipBlock();
+				continue;
+			}
+			in.enterBlock(id);
+			readModule();
+			return module;
+		}
+		throw invalid("no module");
+	}
+};
+// The function type of a function, and whether it is variadic, which LLVM distinguishes but Olivine types do not
+pair<Type, bool> fnType(const Fn& f) {
+	vector<Type> params;
+	auto vararg = false;
+	for (auto a : f.params()) {
+		if (a.tag() == Array) {
+			vararg = true;
+			continue;
+		}
+		params.push_back(a.ty());
+	}
+	return {fnTy(f.rty(), params), vararg};
+}
+
+class BitcodeWriter {
+	const Module& module;
+	BitstreamWriter out;
+
+	// Function bodies, linearized so that each operation is one instruction
+	vector<Fn> defs;
+
+	// The type table, in which each type comes after those it refers to
+	// Variadic function types are entered separately from others with the same parameters
+	unordered_map<Type, size_t> types;
+	unordered_map<Type, size_t> varargTypes;
+	vector<pair<Type, bool>> typeList;
+
+	// Functions by name, so that calls to them use their declared types
+	unordered_map<Ref, pair<Type, bool>> fnTypes;
+
+	// The value table, numbered as in LLVM: global variables and functions, then module-level constants
+	// and while a function is being written, its arguments, constants and instruction results
+	unordered_map<Ref, size_t> globals;
+	unordered_map<Term, size_t> values;
+	unordered_map<Term, size_t> locals;
+	size_t nextValue = 0;
+
+	// While a function is being written, the block numbers of its labels
+	// and the ID of the value the current instruction defines, which operands are relative to
+	unordered_map<Ref, size_t> blocks;
+	size_t next = 0;
+
+	// Names of global variables and functions
+	string strtab;
+
+	// SORT FUNCTIONS
+
+	// Add a constant to a value table, after the constants it refers to
+	void addConstant(Term a, unordered_map<Term, size_t>& table, vector<Term>& list) {
+		if (a.tag() == GlobalRef || values.count(a) || table.count(a)) {
+			return;
+		}
+		if (!isZero(a) && !isData(a)) {
+			for (auto b : a) {
+				addConstant(b, table, list);
+			}
+		}
+		table.emplace(a, nextValue++);
+		list.push_back(a);
+	}
+
+	void addFnType(pair<Type, bool> fty) {
+		auto [ty, vararg] = fty;
+		if (!vararg) {
+			addType(ty);
+			return;
+		}
+		if (varargTypes.count(ty)) {
+			return;
+		}
+		for (auto t : ty) {
+			addType(t);
+		}
+		varargTypes.emplace(ty, typeList.size());
+		typeList.emplace_back(ty, true);
+	}
+
+	void addType(Type ty) {
+		if (types.count(ty)) {
+			return;
+		}
+		for (auto t : ty) {
+			addType(t);
+		}
+		types.emplace(ty, typeList.size());
+		typeList.emplace_back(ty, false);
+	}
+
+	// The types of a term and its subterms
+	void addTypes(Term a) {
+		addType(a.ty());
+		for (auto b : a) {
+			addTypes(b);
+		}
+	}
+
+	// A direct call has the type of the function called, which may be variadic
+	pair<Type, bool> callType(Term a) {
+		if (a[0].tag() == GlobalRef) {
+			auto i = fnTypes.find(a[0].ref());
+			if (i != fnTypes.end()) {
+				return i->second;
+			}
+		}
+		vector<Type> params;
+		for (size_t i = 1; i < a.size(); i++) {
+			params.push_back(a[i].ty());
+		}
+		return {fnTy(a.ty(), params), false};
+	}
+
+	// A local variable is defined, as an instruction result
+	void define(Term v, vector<pair<size_t, Ref>>& names) {
+		if (locals.count(v)) {
+			throw unsupported("variable assigned more than once");
+		}
+		if (!v.ref().numeric()) {
+			names.emplace_back(nextValue, v.ref());
+		}
+		locals.emplace(v, nextValue++);
+	}
+
+	uint64_t fnTypeId(pair<Type, bool> fty) {
+		auto [ty, vararg] = fty;
+		return vararg ? varargTypes.at(ty) : types.at(ty);
+	}
+
+	// The absolute ID of an operand
+	uint64_t id(Term a) {
+		if (a.tag() == GlobalRef) {
+			auto i = globals.find(a.ref());
+			if (i == globals.end()) {
+				throw unsupported("reference to undeclared global");
+			}
+			return i->second;
+		}
+		auto i = locals.find(a);
+		if (i != locals.end()) {
+			return i->second;
+		}
+		i = values.find(a);
+		if (i != values.end()) {
+			return i->second;
+		}
+		throw unsupported("operand that is neither a value nor a constant");
+	}
+
+	uint64_t label(Term a) {
+		auto i = blocks.find(a.ref());
+		if (i == blocks.end()) {
+			throw invalid("undefined label");
+		}
+		return i->second;
+	}
+
+	// Global variables and functions are named in the string table, or numbered if they have no name
+	void name(vector<uint64_t>& ops, const Ref& ref) {
+		if (ref.numeric()) {
+			ops.push_back(0);
+			ops.push_back(0);
+			return;
+		}
+		auto& s = ref.str();
+		ops.push_back(strtab.size());
+		ops.push_back(s.size());
+		strtab += s;
+	}
+
+	uint64_t typeId(Type ty) {
+		return types.at(ty);
+	}
+
+	// An operand given as an ID relative to the instruction
+	void value(vector<uint64_t>& ops, Term a) {
+		ops.push_back(uint32_t(next - id(a)));
+	}
+
+	// An operand given as a relative ID, followed by its type if it is a forward reference
+	void valueType(vector<uint64_t>& ops, Term a) {
+		auto x = id(a);
+		ops.push_back(uint32_t(next - x));
+		if (x >= next) {
+			ops.push_back(typeId(a.ty()));
+		}
+	}
+
+	void writeCall(Term a) {
+		auto fty = callType(a);
+		vector<uint64_t> ops{0, uint64_t(1) << callExplicitType, fnTypeId(fty)};
+		valueType(ops, a[0]);
+
+		// Arguments beyond the fixed parameters carry their types
+		auto params = fty.first.size() - 1;
+		for (size_t i = 1; i < a.size(); i++) {
+			if (i <= params) {
+				value(ops, a[i]);
+			} else {
+				valueType(ops, a[i]);
+			}
+		}
+		out.writeRecord(CallInst, ops);
+	}
+
+	void writeConstant(Term a) {
+		if (isZero(a)) {
+			out.writeRecord(NullConst, {});
+			return;
+		}
+		vector<uint64_t> ops;
+		switch (a.tag()) {
+		case Array:
+		case Tuple:
+		case Vec:
+			if (isData(a)) {
+				auto element = a.ty()[0];
+				for (auto b : a) {
+					if (isInt(element)) {
+						auto x = lowBits(b.intVal());
+						if (element.len() < 64) {
+							x &= (uint64_t(1) << element.len()) - 1;
+						}
+						ops.push_back(x);
+					} else {
+						ops.push_back(floatBits(b));
+					}
+				}
+				out.writeRecord(DataConst, ops);
+				return;
+			}
+			for (auto b : a) {
+				ops.push_back(id(b));
+			}
+			out.writeRecord(AggregateConst, ops);
+			return;
+		case Float:
+			out.writeRecord(FloatConst, {floatBits(a)});
+			return;
+		case Int: {
+			auto len = a.ty().len();
+			if (len <= 64) {
+				out.writeRecord(IntegerConst, {encodeSigned(signExtend(lowBits(a.intVal()), len))});
+				return;
+			}
+
+			// Words of the two's complement value, least significant first, each written as a signed value
+			cpp_int bit = 1;
+			bit <<= len;
+			cpp_int x = a.intVal().toCppInt() % bit;
+			if (x < 0) {
+				x += bit;
+			}
+			for (size_t i = 0; i < (len + 63) / 64; i++) {
+				ops.push_back(encodeSigned(lowBits(Integer(cpp_int(x >> (i * 64))))));
+			}
+			out.writeRecord(WideIntegerConst, ops);
+			return;
+		}
+		}
+		throw unsupported("constant expression");
+	}
+
+	void writeConstants(const vector<Term>& list) {
+		if (list.empty()) {
+			return;
+		}
+		out.enterBlock(ConstantsBlock, 4);
+		Type ty;
+		for (size_t i = 0; i < list.size(); i++) {
+			auto a = list[i];
+			if (!i || a.ty() != ty) {
+				ty = a.ty();
+				out.writeRecord(SetTypeConst, {typeId(ty)});
+			}
+			writeConstant(a);
+		}
+		out.endBlock();
+	}
+
+	// The right-hand side of an assignment, being one operation on atoms and constants
+	void writeExpr(Term a) {
+		vector<uint64_t> ops;
+		switch (a.tag()) {
+		case Call:
+			writeCall(a);
+			return;
+		case Cast:
+		case SCast:
+			valueType(ops, a[0]);
+			ops.push_back(typeId(a.ty()));
+			ops.push_back(castOpcode(a));
+			out.writeRecord(CastInst, ops);
+			return;
+		case ElementPtr:
+			ops = {0, typeId(a[0].ty())};
+			valueType(ops, a[1]);
+			valueType(ops, a[2]);
+			out.writeRecord(GepInst, ops);
+			return;
+		case Eq:
+		case FEq:
+		case FLe:
+		case FLt:
+		case SLe:
+		case SLt:
+		case ULe:
+		case ULt:
+			valueType(ops, a[0]);
+			value(ops, a[1]);
+			ops.push_back(cmpPredicate(a.tag()));
+			out.writeRecord(Cmp2Inst, ops);
+			return;
+		case FNeg:
+			valueType(ops, a[0]);
+			ops.push_back(0);
+			out.writeRecord(UnopInst, ops);
+			return;
+		case FieldPtr:
+			// Structure field indexes are 32 bits
+			ops = {0, typeId(a[0].ty())};
+			valueType(ops, a[1]);
+			valueType(ops, intConst(intTy(32), 0));
+			valueType(ops, intConst(intTy(32), a[2].intVal()));
+			out.writeRecord(GepInst, ops);
+			return;
+		case Load:
+			valueType(ops, a[0]);
+			ops.push_back(typeId(a.ty()));
+
+			// Alignment and volatility
+			ops.push_back(0);
+			ops.push_back(0);
+			out.writeRecord(LoadInst, ops);
+			return;
+		case Not:
+			// Exclusive or with all ones
+			if (!isInt(a.ty())) {
+				throw unsupported("not on non-integer type");
+			}
+			valueType(ops, a[0]);
+			value(ops, intConst(a.ty(), -1));
+			ops.push_back(binaryOpcode(Xor));
+			out.writeRecord(BinopInst, ops);
+			return;
+		}
+		auto opcode = binaryOpcode(a.tag());
+		if (opcode < 0 || a.size() != 2) {
+			std::ostringstream os;
+			os << a.tag();
+			throw unsupported("operation " + os.str());
+		}
+		valueType(ops, a[0]);
+		value(ops, a[1]);
+		ops.push_back(opcode);
+		out.writeRecord(BinopInst, ops);
+	}
+
+	void writeFunction(const Fn& f) {
+		auto base = nextValue;
+		locals.clear();
+		blocks.clear();
+		vector<pair<size_t, Ref>> names;
+		vector<pair<size_t, Ref>> blockNames;
+
+		// Arguments
+		for (auto a : f.params()) {
+			if (a.tag() == Array) {
+				continue;
+			}
+			if (a.tag() == Var) {
+				define(a, names);
+				continue;
+			}
+			nextValue++;
+		}
+
+		// Constants, including those implied by operations that have no direct equivalent
+		vector<Term> constants;
+		auto add = [&](Term a) {
+			if (a.constant() && a.tag() != None && a.tag() != Label) {
+				addConstant(a, locals, constants);
+			}
+		};
+		for (auto inst : f) {
+			for (auto a : inst) {
+				add(a);
+				if (a.constant()) {
+					continue;
+				}
+				for (auto b : a) {
+					add(b);
+				}
+				switch (a.tag()) {
+				case FieldPtr:
+					add(intConst(intTy(32), 0));
+					add(intConst(intTy(32), a[2].intVal()));
+					break;
+				case Not:
+					if (isInt(a.ty())) {
+						add(intConst(a.ty(), -1));
+					}
+					break;
+				}
+			}
+		}
+
+		// Blocks, of which the entry block has no label unless it is named
+		// but can still be referred to by the number it implicitly takes, after any unnamed parameters
+		size_t nblocks = 0;
+		if (f[0].opcode() != Block) {
+			size_t n = 0;
+			for (auto a : f.params()) {
+				if (a.tag() == None || (a.tag() == Var && a.ref().numeric())) {
+					n++;
+				}
+			}
+			blocks.emplace(Ref(n), nblocks++);
+		}
+		for (auto inst : f) {
+			if (inst.opcode() == Block) {
+				auto ref = inst[0].ref();
+				if (!ref.numeric()) {
+					blockNames.emplace_back(nblocks, ref);
+				}
+				blocks.emplace(ref, nblocks++);
+			}
+		}
+
+		// Instruction results are numbered before any are written, as operands may refer forward to them
+		auto first = nextValue;
+		for (auto inst : f) {
+			switch (inst.opcode()) {
+			case Alloca:
+			case Phi:
+				define(inst[0], names);
+				break;
+			case Assign:
+				if (atomic(inst[1])) {
+					break;
+				}
+				define(inst[0], names);
+				break;
+			case Drop:
+				if (inst[0].ty() != voidTy()) {
+					nextValue++;
+				}
+				break;
+			}
+		}
+
+		// A copy defines no value of its own; the variable is another name for the value copied
+		for (auto inst : f) {
+			if (inst.opcode() == Assign && atomic(inst[1])) {
+				if (locals.count(inst[0])) {
+					throw unsupported("variable assigned more than once");
+				}
+				locals.emplace(inst[0], id(inst[1]));
+			}
+		}
+
+		out.enterBlock(FunctionBlock, 4);
+		out.writeRecord(DeclareBlocksInst, {nblocks});
+		writeConstants(constants);
+		next = first;
+		for (auto inst : f) {
+			writeInst(inst);
+		}
+
+		if (names.size() || blockNames.size()) {
+			out.enterBlock(ValueSymtabBlock, 4);
+			for (auto& [i, ref] : names) {
+				auto ops = charCodes(ref.str());
+				ops.insert(ops.begin(), i);
+				out.writeRecord(EntryCode, ops);
+			}
+			for (auto& [i, ref] : blockNames) {
+				auto ops = charCodes(ref.str());
+				ops.insert(ops.begin(), i);
+				out.writeRecord(BlockEntryCode, ops);
+			}
+			out.endBlock();
+		}
+		out.endBlock();
+		nextValue = base;
+	}
+
+	void writeInst(Inst inst) {
+		vector<uint64_t> ops;
+		switch (inst.opcode()) {
+		case Alloca: {
+			auto n = inst[2];
+			out.writeRecord(AllocaInst, {typeId(inst[1].ty()), typeId(n.ty()), id(n), uint64_t(1) << allocaExplicitType});
+			next++;
+			return;
+		}
+		case Assign:
+			if (atomic(inst[1])) {
+				return;
+			}
+			writeExpr(inst[1]);
+			next++;
+			return;
+		case Block:
+			return;
+		case Br:
+			ops = {label(inst[1]), label(inst[2])};
+			value(ops, inst[0]);
+			out.writeRecord(BrInst, ops);
+			return;
+		case Drop:
+			writeCall(inst[0]);
+			if (inst[0].ty() != voidTy()) {
+				next++;
+			}
+			return;
+		case Jmp:
+			out.writeRecord(BrInst, {label(inst[0])});
+			return;
+		case Phi:
+			// Values are given as signed relative IDs, as they may refer forward
+			ops.push_back(typeId(inst[0].ty()));
+			for (size_t i = 1; i < inst.size(); i += 2) {
+				ops.push_back(encodeSigned(int64_t(next) - int64_t(id(inst[i]))));
+				ops.push_back(label(inst[i + 1]));
+			}
+			out.writeRecord(PhiInst, ops);
+			next++;
+			return;
+		case Ret:
+			valueType(ops, inst[0]);
+			out.writeRecord(RetInst, ops);
+			return;
+		case RetVoid:
+			out.writeRecord(RetInst, {});
+			return;
+		case Store:
+			valueType(ops, inst[1]);
+			valueType(ops, inst[0]);
+
+			// Alignment and volatility
+			ops.push_back(0);
+			ops.push_back(0);
+			out.writeRecord(StoreInst, ops);
+			return;
+		case Switch:
+			// Case values are absolute IDs of constants
+			ops.push_back(typeId(inst[0].ty()));
+			value(ops, inst[0]);
+			ops.push_back(label(inst[1]));
+			for (size_t i = 2; i < inst.size(); i += 2) {
+				ops.push_back(id(inst[i]));
+				ops.push_back(label(inst[i + 1]));
+			}
+			out.writeRecord(SwitchInst, ops);
+			return;
+		case Unreachable:
+			out.writeRecord(UnreachableInst, {});
+			return;
+		}
+		throw unsupported("instruction");
+	}
+
+	void writeTypes() {
+		out.enterBlock(TypeBlock, 4);
+		out.writeRecord(NumEntryType, {typeList.size()});
+		for (auto [ty, vararg] : typeList) {
+			vector<uint64_t> ops;
+			switch (ty.kind()) {
+			case ArrayKind:
+				out.writeRecord(ArrayType, {ty.len(), typeId(ty[0])});
+				break;
+			case DoubleKind:
+				out.writeRecord(DoubleType, {});
+				break;
+			case FloatKind:
+				out.writeRecord(FloatType, {});
+				break;
+			case FuncKind:
+				// [vararg, return type, parameter types...]
+				ops.push_back(vararg);
+				for (auto t : ty) {
+					ops.push_back(typeId(t));
+				}
+				out.writeRecord(FunctionType, ops);
+				break;
+			case IntKind:
+				out.writeRecord(IntegerType, {ty.len()});
+				break;
+			case PtrKind:
+				// Address space
+				out.writeRecord(OpaquePointerType, {0});
+				break;
+			case StructKind:
+				// Not packed
+				ops.push_back(0);
+				for (auto t : ty) {
+					ops.push_back(typeId(t));
+				}
+				out.writeRecord(StructAnonType, ops);
+				break;
+			case VecKind:
+				out.writeRecord(VectorType, {ty.len(), typeId(ty[0])});
+				break;
+			case VoidKind:
+				out.writeRecord(VoidType, {});
+				break;
+			}
+		}
+		out.endBlock();
+	}
+
+public:
+	explicit BitcodeWriter(const Module& module): module(module) {
+	}
+
+	string write() {
+		// Global variables and functions are numbered in the order of their records
+		for (auto& g : module.globals) {
+			addType(g.ty());
+			globals.emplace(g.ref(), nextValue++);
+		}
+		for (auto& f : module.decls) {
+			fnTypes.emplace(f.ref(), fnType(f));
+			addFnType(fnType(f));
+			globals.emplace(f.ref(), nextValue++);
+		}
+		for (auto& f : module.defs) {
+			fnTypes.emplace(f.ref(), fnType(f));
+			addFnType(fnType(f));
+			globals.emplace(f.ref(), nextValue++);
+			defs.push_back(linearize(f));
+		}
+
+		// Module-level constants are the initializers of global variables
+		vector<Term> constants;
+		for (auto& g : module.globals) {
+			if (g.val().tag() != None) {
+				addTypes(g.val());
+				addConstant(g.val(), values, constants);
+			}
+		}
+
+		// Types used in function bodies
+		for (auto& f : defs) {
+			for (auto inst : f) {
+				for (auto a : inst) {
+					addTypes(a);
+					switch (a.tag()) {
+					case Call:
+						addFnType(callType(a));
+						break;
+					case FieldPtr:
+						addType(intTy(32));
+						break;
+					}
+				}
+			}
+		}
+
+		out.writeBytes("BC\xc0\xde");
+		out.enterBlock(ModuleBlock, 3);
+
+		// Version 2 keeps names in the string table, and uses relative value IDs
+		out.writeRecord(VersionCode, {2});
+		writeTypes();
+		if (module.triple.size()) {
+			out.writeRecord(TripleCode, charCodes(module.triple));
+		}
+		if (module.datalayout.size()) {
+			out.writeRecord(DatalayoutCode, charCodes(module.datalayout));
+		}
+		for (auto& ref : module.comdats) {
+			// Selection kind any
+			vector<uint64_t> ops;
+			name(ops, ref);
+			ops.push_back(1);
+			out.writeRecord(ComdatCode, ops);
+		}
+
+		// External linkage throughout, as in the textual form
+		for (auto& g : module.globals) {
+			// [strtab offset, strtab size, type, explicit type, initializer + 1, linkage, alignment, section]
+			vector<uint64_t> ops;
+			name(ops, g.ref());
+			ops.push_back(typeId(g.ty()));
+			ops.push_back(2);
+			ops.push_back(g.val().tag() == None ? 0 : id(g.val()) + 1);
+			for (int i = 0; i < 3; i++) {
+				ops.push_back(0);
+			}
+			out.writeRecord(GlobalVarCode, ops);
+		}
+		auto fnRecord = [&](const Fn& f, bool declaration) {
+			// [strtab offset, strtab size, type, calling convention, is declaration, linkage, attributes, alignment, section,
+			// visibility]
+			vector<uint64_t> ops;
+			name(ops, f.ref());
+			ops.push_back(fnTypeId(fnType(f)));
+			ops.push_back(0);
+			ops.push_back(declaration);
+			for (int i = 0; i < 5; i++) {
+				ops.push_back(0);
+			}
+			out.writeRecord(FunctionCode, ops);
+		};
+		for (auto& f : module.decls) {
+			fnRecord(f, true);
+		}
+		for (auto& f : module.defs) {
+			fnRecord(f, false);
+		}
+
+		writeConstants(constants);
+		for (auto& f : defs) {
+			writeFunction(f);
+		}
+		out.endBlock();
+
+		out.enterBlock(StrtabBlock, 3);
+		auto blob = out.defineAbbrev({{AbbrevOp::Literal, StrtabBlobCode}, {AbbrevOp::Blob, 0}});
+		out.writeRecord(blob, StrtabBlobCode, {}, strtab);
+		out.endBlock();
+		return out.str();
+	}
+};
+} // namespace
+
+bool isBitcode(std::string_view data) {
+	if (data.size() < 4) {
+		return false;
+	}
+	return data.substr(0, 4) == "BC\xc0\xde" || load32(data, 0) == 0x0b17c0de;
+}
+
+Module* readBitcode(string file, std::string_view data) {
+	try {
+		// The wrapper header gives the offset and size of the bitcode proper
+		if (data.size() >= 20 && load32(data, 0) == 0x0b17c0de) {
+			auto offset = load32(data, 8);
+			auto size = load32(data, 12);
+			if (size_t(offset) + size > data.size()) {
+				throw invalid("wrapper header");
+			}
+			data = data.substr(offset, size);
+		}
+		if (data.substr(0, 4) != "BC\xc0\xde") {
+			throw invalid("magic number");
+		}
+		BitcodeReader reader(data.substr(4));
+		return reader.read();
+	} catch (const runtime_error& e) {
+		throw runtime_error(file + ": " + e.what());
+	}
+}
+
+string writeBitcode(const Module& module) {
+	BitcodeWriter writer(module);
+	return writer.write();
+}
@@ -0,0 +1,16 @@
+// LLVM bitcode
+// https://llvm.org/docs/BitCodeFormat.html
+// Covers the same subset of LLVM IR as the parser for `.ll` files
+// Reading a bitcode file gives the same module as parsing its disassembly
+// except that floating-point constants are spelled in hexadecimal
+
+// Does the data begin with the bitcode magic number, either directly or in a wrapper header?
+bool isBitcode(std::string_view data);
+
+// The data need only remain valid during the call, as nothing in the resulting module refers to it
+Module* readBitcode(string file, std::string_view data);
+
+// Writes the same subset, with nested operands linearized as for printing
+// Values keep their names, but a variable assigned a copy of another value becomes another name for that value
+// The whole file is built in memory, so a module the writer does not support leaves no partial output
+string writeBitcode(const Module& module);
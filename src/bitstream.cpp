@@ -0,0 +1,451 @@
+#include "all.h"
+
+namespace {
+runtime_error invalid(const string& msg) {
+	return runtime_error("invalid bitcode: " + msg);
+}
+
+uint64_t char6(uint64_t x) {
+	if (x < 26) {
+		return 'a' + x;
+	}
+	if (x < 52) {
+		return 'A' + x - 26;
+	}
+	if (x < 62) {
+		return '0' + x - 52;
+	}
+	return x == 62 ? '.' : '_';
+}
+
+uint64_t encodeChar6(uint64_t c) {
+	if ('a' <= c && c <= 'z') {
+		return c - 'a';
+	}
+	if ('A' <= c && c <= 'Z') {
+		return c - 'A' + 26;
+	}
+	if ('0' <= c && c <= '9') {
+		return c - '0' + 52;
+	}
+	ASSERT(c == '.' || c == '_');
+	return c == '.' ? 62 : 63;
+}
+} // namespace
+
+BitstreamReader::Entry BitstreamReader::advance(unsigned& id) {
+	for (;;) {
+		if (atEnd()) {
+			if (scopes.size()) {
+				throw invalid("unterminated block");
+			}
+			return End;
+		}
+		switch (read(abbrevWidth())) {
+		case EndBlockAbbrev:
+			// At the top level, this can only be padding at the end of the stream
+			if (scopes.empty()) {
+				bit = data.size() * 8;
+				return End;
+			}
+			skipToWord();
+			scopes.pop_back();
+			return End;
+		case EnterBlockAbbrev:
+			id = readVBR(8);
+			if (id == blockInfoBlock) {
+				readBlockInfo();
+				continue;
+			}
+			return Block;
+		case DefineAbbrev:
+			if (scopes.empty()) {
+				throw invalid("abbreviation at top level");
+			}
+			scopes.back().abbrevs.push_back(readAbbrev());
+			continue;
+		default:
+			// The abbreviation ID is needed to read the record, so put it back
+			bit -= abbrevWidth();
+			recordAbbrev = read(abbrevWidth());
+			return Record;
+		}
+	}
+}
+
+void BitstreamReader::enterBlock(unsigned id) {
+	auto width = readVBR(4);
+	skipToWord();
+
+	// Length in words, which is only needed to skip the block
+	read(32);
+
+	if (!width || width > 32) {
+		throw invalid("abbreviation width");
+	}
+	Scope scope{id, unsigned(width), {}};
+	auto i = blockAbbrevs.find(id);
+	if (i != blockAbbrevs.end()) {
+		scope.abbrevs = i->second;
+	}
+	scopes.push_back(scope);
+}
+
+uint64_t BitstreamReader::read(unsigned width) {
+	ASSERT(width <= 64);
+	uint64_t r = 0;
+	unsigned n = 0;
+	while (n < width) {
+		auto i = bit / 8;
+		if (i >= data.size()) {
+			throw invalid("unexpected end of data");
+		}
+		auto offset = bit % 8;
+		auto m = std::min(8 - unsigned(offset), width - n);
+		r |= uint64_t((uint8_t(data[i]) >> offset) & ((1u << m) - 1)) << n;
+		n += m;
+		bit += m;
+	}
+	return r;
+}
+
+std::shared_ptr<const Abbrev> BitstreamReader::readAbbrev() {
+	auto abbrev = std::make_shared<Abbrev>();
+	auto n = readVBR(5);
+	for (size_t i = 0; i < n; i++) {
+		AbbrevOp op;
+		if (read(1)) {
+			op.encoding = AbbrevOp::Literal;
+			op.value = readVBR(8);
+		} else {
+			auto encoding = read(3);
+			switch (encoding) {
+			case 1:
+				op.encoding = AbbrevOp::Fixed;
+				op.value = readVBR(5);
+				break;
+			case 2:
+				op.encoding = AbbrevOp::VBR;
+				op.value = readVBR(5);
+				break;
+			case 3:
+				op.encoding = AbbrevOp::Array;
+				break;
+			case 4:
+				op.encoding = AbbrevOp::Char6;
+				break;
+			case 5:
+				op.encoding = AbbrevOp::Blob;
+				break;
+			default:
+				throw invalid("abbreviation encoding");
+			}
+			// A variable-width field needs a continuation bit and at least one data bit
+			// and its chunks are read as at most 32 bits
+			if ((op.encoding == AbbrevOp::Fixed && op.value > 64) ||
+				(op.encoding == AbbrevOp::VBR && (op.value < 2 || op.value > 32))) {
+				throw invalid("abbreviation field width");
+			}
+		}
+		abbrev->push_back(op);
+	}
+	return abbrev;
+}
+
+void BitstreamReader::readBlockInfo() {
+	enterBlock(blockInfoBlock);
+
+	// Abbreviations defined here are for the block most recently named by SETBID
+	vector<std::shared_ptr<const Abbrev>>* target = nullptr;
+	for (;;) {
+		switch (read(abbrevWidth())) {
+		case EndBlockAbbrev:
+			skipToWord();
+			scopes.pop_back();
+			return;
+		case EnterBlockAbbrev:
+			readVBR(8);
+			skipBlock();
+			continue;
+		case DefineAbbrev:
+			if (!target) {
+				throw invalid("abbreviation in BLOCKINFO before SETBID");
+			}
+			target->push_back(readAbbrev());
+			continue;
+		default: {
+			bit -= abbrevWidth();
+			recordAbbrev = read(abbrevWidth());
+			vector<uint64_t> ops;
+
+			// SETBID
+			if (readRecord(ops) == 1) {
+				if (ops.empty()) {
+					throw invalid("SETBID");
+				}
+				target = &blockAbbrevs[ops[0]];
+			}
+		}
+		}
+	}
+}
+
+uint64_t BitstreamReader::readField(const AbbrevOp& op) {
+	switch (op.encoding) {
+	case AbbrevOp::Char6:
+		return char6(read(6));
+	case AbbrevOp::Fixed:
+		return read(op.value);
+	case AbbrevOp::Literal:
+		return op.value;
+	case AbbrevOp::VBR:
+		return readVBR(op.value);
+	}
+	throw invalid("abbreviation field");
+}
+
+unsigned BitstreamReader::readRecord(vector<uint64_t>& ops, std::string_view* blob) {
+	ops.clear();
+	if (recordAbbrev == UnabbrevRecordAbbrev) {
+		auto code = readVBR(6);
+		auto n = readVBR(6);
+		for (size_t i = 0; i < n; i++) {
+			ops.push_back(readVBR(6));
+		}
+		return code;
+	}
+
+	if (scopes.empty()) {
+		throw invalid("record at top level");
+	}
+	auto& abbrevs = scopes.back().abbrevs;
+	auto i = recordAbbrev - FirstAbbrev;
+	if (i >= abbrevs.size()) {
+		throw invalid("undefined abbreviation");
+	}
+	auto& abbrev = *abbrevs[i];
+
+	// The first field is the code, the rest are operands
+	for (size_t j = 0; j < abbrev.size(); j++) {
+		auto& op = abbrev[j];
+		switch (op.encoding) {
+		case AbbrevOp::Array: {
+			// The element encoding is the next and last operand of the abbreviation
+			if (j + 2 != abbrev.size()) {
+				throw invalid("array abbreviation");
+			}
+			auto n = readVBR(6);
+			auto& element = abbrev[++j];
+			for (size_t k = 0; k < n; k++) {
+				ops.push_back(readField(element));
+			}
+			break;
+		}
+		case AbbrevOp::Blob: {
+			auto n = readVBR(6);
+			skipToWord();
+			auto begin = bit / 8;
+			if (begin + n > data.size()) {
+				throw invalid("unexpected end of data");
+			}
+			auto s = data.substr(begin, n);
+			if (blob) {
+				*blob = s;
+			} else {
+				for (auto c : s) {
+					ops.push_back(uint8_t(c));
+				}
+			}
+			bit += n * 8;
+			skipToWord();
+			break;
+		}
+		default:
+			ops.push_back(readField(op));
+		}
+	}
+	if (ops.empty()) {
+		throw invalid("record without code");
+	}
+	auto code = ops[0];
+	ops.erase(ops.begin());
+	return code;
+}
+
+uint64_t BitstreamReader::readVBR(unsigned width) {
+	ASSERT(2 <= width && width <= 32);
+	auto hi = uint64_t(1) << (width - 1);
+	uint64_t r = 0;
+	for (unsigned shift = 0;; shift += width - 1) {
+		auto x = read(width);
+		if (shift < 64) {
+			r |= (x & (hi - 1)) << shift;
+		}
+		if (!(x & hi)) {
+			return r;
+		}
+		if (shift > 64) {
+			throw invalid("variable-width integer too long");
+		}
+	}
+}
+
+void BitstreamReader::skipBlock() {
+	readVBR(4);
+	skipToWord();
+	auto words = read(32);
+	if (bit / 8 + words * 4 > data.size()) {
+		throw invalid("unexpected end of data");
+	}
+	bit += words * 32;
+}
+
+void BitstreamReader::skipToWord() {
+	bit = (bit + 31) / 32 * 32;
+}
+
+unsigned BitstreamWriter::defineAbbrev(const Abbrev& abbrev) {
+	ASSERT(scopes.size());
+	write(DefineAbbrev, abbrevWidth());
+	writeVBR(abbrev.size(), 5);
+	for (auto& op : abbrev) {
+		if (op.encoding == AbbrevOp::Literal) {
+			write(1, 1);
+			writeVBR(op.value, 8);
+			continue;
+		}
+
+		// The encodings are numbered as in the format
+		write(0, 1);
+		write(op.encoding, 3);
+		if (op.encoding == AbbrevOp::Fixed || op.encoding == AbbrevOp::VBR) {
+			writeVBR(op.value, 5);
+		}
+	}
+	auto& abbrevs = scopes.back().abbrevs;
+	abbrevs.push_back(abbrev);
+	return FirstAbbrev + abbrevs.size() - 1;
+}
+
+void BitstreamWriter::endBlock() {
+	ASSERT(scopes.size());
+	write(EndBlockAbbrev, abbrevWidth());
+	padToWord();
+	auto begin = scopes.back().begin;
+	auto words = (out.size() - begin) / 4;
+	for (size_t j = 0; j < 4; j++) {
+		out[begin - 4 + j] = char(words >> (j * 8));
+	}
+	scopes.pop_back();
+}
+
+void BitstreamWriter::enterBlock(unsigned id, unsigned abbrevWidth) {
+	ASSERT(2 <= abbrevWidth && abbrevWidth <= 32);
+	write(EnterBlockAbbrev, this->abbrevWidth());
+	writeVBR(id, 8);
+	writeVBR(abbrevWidth, 4);
+	padToWord();
+
+	// Length in words, filled in by endBlock
+	write(0, 32);
+	scopes.push_back({abbrevWidth, out.size(), {}});
+}
+
+void BitstreamWriter::padToWord() {
+	bit = (bit + 31) / 32 * 32;
+	out.resize(bit / 8);
+}
+
+void BitstreamWriter::write(uint64_t x, unsigned width) {
+	ASSERT(width <= 64);
+	unsigned n = 0;
+	while (n < width) {
+		auto offset = bit % 8;
+		if (!offset) {
+			out += '\0';
+		}
+		auto m = std::min(8 - unsigned(offset), width - n);
+		out.back() |= char(((x >> n) & ((1u << m) - 1)) << offset);
+		n += m;
+		bit += m;
+	}
+}
+
+void BitstreamWriter::writeBytes(std::string_view s) {
+	ASSERT(bit % 8 == 0);
+	out += s;
+	bit += s.size() * 8;
+}
+
+void BitstreamWriter::writeField(const AbbrevOp& op, uint64_t x) {
+	switch (op.encoding) {
+	case AbbrevOp::Char6:
+		write(encodeChar6(x), 6);
+		return;
+	case AbbrevOp::Fixed:
+		write(x, op.value);
+		return;
+	case AbbrevOp::Literal:
+		ASSERT(x == op.value);
+		return;
+	case AbbrevOp::VBR:
+		writeVBR(x, op.value);
+		return;
+	}
+	ASSERT(false && "Unknown abbreviation field");
+}
+
+void BitstreamWriter::writeRecord(unsigned code, const vector<uint64_t>& ops) {
+	write(UnabbrevRecordAbbrev, abbrevWidth());
+	writeVBR(code, 6);
+	writeVBR(ops.size(), 6);
+	for (auto x : ops) {
+		writeVBR(x, 6);
+	}
+}
+
+void BitstreamWriter::writeRecord(unsigned abbrev, unsigned code, const vector<uint64_t>& ops, std::string_view blob) {
+	ASSERT(scopes.size());
+	auto& abbrevs = scopes.back().abbrevs;
+	ASSERT(FirstAbbrev <= abbrev && abbrev - FirstAbbrev < abbrevs.size());
+	auto& a = abbrevs[abbrev - FirstAbbrev];
+	write(abbrev, abbrevWidth());
+
+	// The first field is the code, the rest are operands
+	size_t i = 0;
+	auto field = [&]() { return i++ ? ops[i - 2] : code; };
+	for (size_t j = 0; j < a.size(); j++) {
+		auto& op = a[j];
+		switch (op.encoding) {
+		case AbbrevOp::Array: {
+			ASSERT(j + 2 == a.size());
+			auto& element = a[++j];
+			writeVBR(ops.size() + 1 - i, 6);
+			while (i <= ops.size()) {
+				writeField(element, field());
+			}
+			break;
+		}
+		case AbbrevOp::Blob:
+			writeVBR(blob.size(), 6);
+			padToWord();
+			writeBytes(blob);
+			padToWord();
+			break;
+		default:
+			ASSERT(i <= ops.size());
+			writeField(op, field());
+		}
+	}
+	ASSERT(i == ops.size() + 1);
+}
+
+void BitstreamWriter::writeVBR(uint64_t x, unsigned width) {
+	ASSERT(2 <= width && width <= 32);
+	auto hi = uint64_t(1) << (width - 1);
+	while (x >= hi) {
+		write((x & (hi - 1)) | hi, width);
+		x >>= width - 1;
+	}
+	write(x, width);
+}
@@ -0,0 +1,161 @@
+// The container format of LLVM bitcode
+// https://llvm.org/docs/BitCodeFormat.html
+// A stream of bits, packed into 32-bit little-endian words, least significant bit first
+// organized into nested blocks, each containing records
+// Records may be written in full, or compressed according to abbreviations that specify the width and encoding of each field
+
+// How one field of an abbreviated record is encoded
+struct AbbrevOp {
+	enum Encoding {
+		Literal,
+		Fixed,
+		VBR,
+		Array,
+		Char6,
+		Blob,
+	};
+
+	Encoding encoding;
+
+	// The value of a literal, or the width of a fixed or variable-width field
+	uint64_t value;
+};
+
+using Abbrev = vector<AbbrevOp>;
+
+// Abbreviation IDs with fixed meanings; those defined by the stream are numbered from 4
+enum {
+	EndBlockAbbrev,
+	EnterBlockAbbrev,
+	DefineAbbrev,
+	UnabbrevRecordAbbrev,
+	FirstAbbrev,
+};
+
+// Block ID 0 is reserved for the BLOCKINFO block, which defines abbreviations for other blocks
+constexpr unsigned blockInfoBlock = 0;
+
+class BitstreamReader {
+	std::string_view data;
+	size_t bit = 0;
+
+	struct Scope {
+		unsigned id;
+		unsigned abbrevWidth;
+		vector<std::shared_ptr<const Abbrev>> abbrevs;
+	};
+
+	// The blocks currently entered, innermost last
+	vector<Scope> scopes;
+
+	// Abbreviations defined in the BLOCKINFO block, for each block ID
+	unordered_map<unsigned, vector<std::shared_ptr<const Abbrev>>> blockAbbrevs;
+
+	// The abbreviation ID of the record found by the last call to advance
+	unsigned recordAbbrev = 0;
+
+	unsigned abbrevWidth() const {
+		return scopes.empty() ? 2 : scopes.back().abbrevWidth;
+	}
+
+	std::shared_ptr<const Abbrev> readAbbrev();
+	void readBlockInfo();
+	uint64_t readField(const AbbrevOp& op);
+
+public:
+	explicit BitstreamReader(std::string_view data): data(data) {
+	}
+
+	// Each call to advance moves to the next entry in the current block
+	// Abbreviation definitions and BLOCKINFO blocks are handled internally
+	// End means the end of the current block, or of the stream
+	enum Entry {
+		End,
+		Block,
+		Record,
+	};
+
+	// SORT FUNCTIONS
+
+	// For a Block, the block ID is stored in id
+	Entry advance(unsigned& id);
+
+	bool atEnd() const {
+		return bit >= data.size() * 8;
+	}
+
+	// After advance returns a Block, either enter or skip it
+	void enterBlock(unsigned id);
+
+	// Fixed-width field of up to 64 bits
+	uint64_t read(unsigned width);
+
+	// Read the record found by advance, returning its code
+	// Array and character operands are expanded into the list, one element per operand
+	// A blob is returned separately, if the caller asks for it
+	unsigned readRecord(vector<uint64_t>& ops, std::string_view* blob = nullptr);
+
+	uint64_t readVBR(unsigned width);
+
+	void skipBlock();
+
+	void skipToWord();
+};
+
+class BitstreamWriter {
+	string out;
+	size_t bit = 0;
+
+	struct Scope {
+		unsigned abbrevWidth;
+
+		// Where the block's contents begin, after its length word
+		size_t begin;
+
+		vector<Abbrev> abbrevs;
+	};
+
+	// The blocks currently entered, innermost last
+	vector<Scope> scopes;
+
+	unsigned abbrevWidth() const {
+		return scopes.empty() ? 2 : scopes.back().abbrevWidth;
+	}
+
+	void writeField(const AbbrevOp& op, uint64_t x);
+
+public:
+	// SORT FUNCTIONS
+
+	// Abbreviations apply to the rest of the current block
+	// Returns the abbreviation ID to pass to writeRecord
+	unsigned defineAbbrev(const Abbrev& abbrev);
+
+	// The length of the block is filled in when it ends
+	void endBlock();
+
+	void enterBlock(unsigned id, unsigned abbrevWidth);
+
+	// Zero bits up to the next 32-bit boundary
+	void padToWord();
+
+	// The stream so far, which is complete once all blocks have ended
+	const string& str() const {
+		return out;
+	}
+
+	// Fixed-width field of up to 64 bits
+	void write(uint64_t x, unsigned width);
+
+	// Bytes written directly, at the current position, which must be on a byte boundary
+	void writeBytes(std::string_view s);
+
+	// Unabbreviated record
+	void writeRecord(unsigned code, const vector<uint64_t>& ops);
+
+	// Record abbreviated as previously defined in this block
+	// An array takes the rest of the operands, a blob takes the separate argument
+	void writeRecord(unsigned abbrev, unsigned code, const vector<uint64_t>& ops, std::string_view blob = {});
+
+	void writeVBR(uint64_t x, unsigned width);
+};
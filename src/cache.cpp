@@ -0,0 +1,629 @@
+#include "all.h"
+
+namespace {
+// Magic number, format version and content hash, each eight bytes
+const char magic[] = "olivine\x1a";
+constexpr size_t headerSize = 24;
+
+// Kinds, tags and opcodes are written as their raw values
+// so the format version is derived from the numbering of all of them
+// Each value is paired with its name, so adding, removing or reordering any of them changes the version
+// and a cache written by a build that numbered them differently is rejected rather than misread
+// A value added after the last one listed here is out of range for the reader, so is rejected as well
+// The revision covers everything else about the layout, and changes with the writer and reader code
+constexpr uint64_t revision = 2;
+
+struct Enumerator {
+	const char* name;
+	unsigned val;
+};
+
+const Enumerator schema[] = {
+	{"ArrayKind", ArrayKind},
+	{"DoubleKind", DoubleKind},
+	{"FloatKind", FloatKind},
+	{"FuncKind", FuncKind},
+	{"IntKind", IntKind},
+	{"PtrKind", PtrKind},
+	{"StructKind", StructKind},
+	{"VecKind", VecKind},
+	{"VoidKind", VoidKind},
+
+	{"AShr", AShr},
+	{"Add", Add},
+	{"And", And},
+	{"Array", Array},
+	{"Call", Call},
+	{"Cast", Cast},
+	{"ElementPtr", ElementPtr},
+	{"Eq", Eq},
+	{"FAdd", FAdd},
+	{"FDiv", FDiv},
+	{"FEq", FEq},
+	{"FLe", FLe},
+	{"FLt", FLt},
+	{"FMul", FMul},
+	{"FNeg", FNeg},
+	{"FRem", FRem},
+	{"FSub", FSub},
+	{"FieldPtr", FieldPtr},
+	{"Float", Float},
+	{"GlobalRef", GlobalRef},
+	{"Int", Int},
+	{"LShr", LShr},
+	{"Label", Label},
+	{"Load", Load},
+	{"Mul", Mul},
+	{"None", None},
+	{"Not", Not},
+	{"NullPtr", NullPtr},
+	{"Or", Or},
+	{"SCast", SCast},
+	{"SDiv", SDiv},
+	{"SLe", SLe},
+	{"SLt", SLt},
+	{"SRem", SRem},
+	{"Shl", Shl},
+	{"Sub", Sub},
+	{"Tuple", Tuple},
+	{"UDiv", UDiv},
+	{"ULe", ULe},
+	{"ULt", ULt},
+	{"URem", URem},
+	{"Var", Var},
+	{"Vec", Vec},
+	{"Xor", Xor},
+
+	{"Alloca", Alloca},
+	{"Assign", Assign},
+	{"Block", Block},
+	{"Br", Br},
+	{"Drop", Drop},
+	{"Jmp", Jmp},
+	{"Phi", Phi},
+	{"Ret", Ret},
+	{"RetVoid", RetVoid},
+	{"Store", Store},
+	{"Switch", Switch},
+	{"Unreachable", Unreachable},
+};
+
+uint64_t version() {
+	static auto v = []() {
+		string s = to_string(revision);
+		for (auto& e : schema) {
+			s += ' ';
+			s += e.name;
+			s += '=';
+			s += to_string(e.val);
+		}
+		return contentHash(s);
+	}();
+	return v;
+}
+
+runtime_error invalid() {
+	return runtime_error("invalid cache");
+}
+
+uint64_t load64(std::string_view data, size_t i) {
+	uint64_t r = 0;
+	for (size_t j = 0; j < 8; j++) {
+		r |= uint64_t(uint8_t(data[i + j])) << (j * 8);
+	}
+	return r;
+}
+
+void store64(string& out, uint64_t x) {
+	for (size_t j = 0; j < 8; j++) {
+		out += char(x >> (j * 8));
+	}
+}
+
+class CacheWriter {
+	string out;
+
+	unordered_map<Ref, size_t> names;
+	vector<Ref> nameList;
+
+	unordered_map<Type, size_t> types;
+	vector<Type> typeList;
+
+	unordered_map<Term, size_t> terms;
+	vector<Term> termList;
+
+	// SORT FUNCTIONS
+
+	// Add everything a term refers to, to the tables, followed by the term itself
+	// so every entry only refers to entries before it
+	void add(Term a) {
+		if (terms.count(a)) {
+			return;
+		}
+		add(a.ty());
+		for (auto b : a) {
+			add(b);
+		}
+		if (!a.size()) {
+			add(a.ref());
+		}
+		terms.emplace(a, termList.size());
+		termList.push_back(a);
+	}
+
+	void add(Type ty) {
+		if (types.count(ty)) {
+			return;
+		}
+		for (auto t : ty) {
+			add(t);
+		}
+		types.emplace(ty, typeList.size());
+		typeList.push_back(ty);
+	}
+
+	void add(const Ref& ref) {
+		if (ref.numeric() || names.count(ref)) {
+			return;
+		}
+		names.emplace(ref, nameList.size());
+		nameList.push_back(ref);
+	}
+
+	void add(const Fn& f) {
+		add(f.rty());
+		add(f.ref());
+		for (auto a : f.params()) {
+			add(a);
+		}
+		for (auto inst : f) {
+			for (auto a : inst) {
+				add(a);
+			}
+		}
+	}
+
+	void fn(const Fn& f) {
+		num(types.at(f.rty()));
+		ref(f.ref());
+		auto params = f.params();
+		num(params.size());
+		for (auto a : params) {
+			num(terms.at(a));
+		}
+	}
+
+	void integer(const Integer& a) {
+		if (a.isSmall()) {
+			// Zigzag encoding keeps small negative numbers short
+			auto x = a.toSmall();
+			out += '\0';
+			num(uint64_t(x) << 1 ^ uint64_t(x >> 63));
+			return;
+		}
+		std::ostringstream os;
+		os << a;
+		out += '\1';
+		str(os.str());
+	}
+
+	// Unsigned LEB128
+	void num(uint64_t x) {
+		while (x >= 0x80) {
+			out += char(x | 0x80);
+			x >>= 7;
+		}
+		out += char(x);
+	}
+
+	void ref(const Ref& ref) {
+		if (ref.numeric()) {
+			num(ref.num() << 1);
+			return;
+		}
+		num(names.at(ref) << 1 | 1);
+	}
+
+	void str(const string& s) {
+		num(s.size());
+		out += s;
+	}
+
+public:
+	explicit CacheWriter(uint64_t hash) {
+		out.append(magic, 8);
+		store64(out, version());
+		store64(out, hash);
+	}
+
+	string write(const Module& module) {
+		// Fill the tables
+		for (auto& ref : module.comdats) {
+			add(ref);
+		}
+		for (auto& g : module.globals) {
+			add(g.ty());
+			add(g.ref());
+			add(g.val());
+		}
+		for (auto& f : module.decls) {
+			add(f);
+		}
+		for (auto& f : module.defs) {
+			add(f);
+		}
+
+		// Externals are unordered in memory, so sort them to make the output deterministic
+		vector<Ref> externals(module.externals.begin(), module.externals.end());
+		std::sort(externals.begin(), externals.end());
+		for (auto& ref : externals) {
+			add(ref);
+		}
+
+		// Tables
+		num(nameList.size());
+		for (auto& ref : nameList) {
+			str(ref.str());
+		}
+
+		num(typeList.size());
+		for (auto ty : typeList) {
+			num(ty.kind());
+			switch (ty.kind()) {
+			case ArrayKind:
+			case IntKind:
+			case VecKind:
+				num(ty.len());
+				break;
+			case FuncKind:
+			case StructKind:
+				num(ty.size());
+				break;
+			}
+			for (auto t : ty) {
+				num(types.at(t));
+			}
+		}
+
+		num(termList.size());
+		for (auto a : termList) {
+			num(a.tag());
+			num(types.at(a.ty()));
+			num(a.size());
+			if (a.size()) {
+				for (auto b : a) {
+					num(terms.at(b));
+				}
+				continue;
+			}
+			if (a.tag() == Int) {
+				integer(a.intVal());
+				continue;
+			}
+			ref(a.ref());
+		}
+
+		// Module
+		str(module.datalayout);
+		str(module.triple);
+
+		num(module.comdats.size());
+		for (auto& r : module.comdats) {
+			ref(r);
+		}
+
+		num(module.globals.size());
+		for (auto& g : module.globals) {
+			num(types.at(g.ty()));
+			ref(g.ref());
+			num(terms.at(g.val()));
+		}
+
+		num(module.decls.size());
+		for (auto& f : module.decls) {
+			fn(f);
+		}
+
+		num(module.defs.size());
+		for (auto& f : module.defs) {
+			fn(f);
+			num(f.size());
+			for (auto inst : f) {
+				num(inst.opcode());
+				num(inst.size());
+				for (auto a : inst) {
+					num(terms.at(a));
+				}
+			}
+		}
+
+		num(externals.size());
+		for (auto& r : externals) {
+			ref(r);
+		}
+		return out;
+	}
+};
+
+class CacheReader {
+	std::string_view data;
+	size_t i = headerSize;
+
+	vector<Ref> names;
+	vector<Type> types;
+	vector<Term> terms;
+
+	// SORT FUNCTIONS
+
+	// The number of elements that follow, each of which takes at least one byte
+	size_t count() {
+		auto n = num();
+		if (n > data.size() - i) {
+			throw invalid();
+		}
+		return n;
+	}
+
+	Fn fn(bool def) {
+		auto rty = type();
+		auto ref = this->ref();
+		auto params = termVector();
+		if (!def) {
+			return Fn(rty, ref, params);
+		}
+		auto n = count();
+		vector<Inst> body;
+		for (size_t j = 0; j < n; j++) {
+			auto opcode = num();
+			if (opcode > Unreachable) {
+				throw invalid();
+			}
+			body.push_back(Inst(Opcode(opcode), termVector()));
+		}
+		return Fn(rty, ref, params, body);
+	}
+
+	Integer integer() {
+		if (i == data.size()) {
+			throw invalid();
+		}
+		if (!data[i++]) {
+			auto x = num();
+			return int64_t(x >> 1 ^ -(x & 1));
+		}
+		return parseInt(str());
+	}
+
+	uint64_t num() {
+		uint64_t x = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			if (i == data.size()) {
+				throw invalid();
+			}
+			auto c = uint8_t(data[i++]);
+			x |= uint64_t(c & 0x7f) << shift;
+			if (!(c & 0x80)) {
+				return x;
+			}
+		}
+		throw invalid();
+	}
+
+	Ref ref() {
+		auto x = num();
+		if (!(x & 1)) {
+			return Ref(size_t(x >> 1));
+		}
+		x >>= 1;
+		if (x >= names.size()) {
+			throw invalid();
+		}
+		return names[x];
+	}
+
+	std::string_view str() {
+		auto n = num();
+		if (n > data.size() - i) {
+			throw invalid();
+		}
+		auto s = data.substr(i, n);
+		i += n;
+		return s;
+	}
+
+	Term term() {
+		auto x = num();
+		if (x >= terms.size()) {
+			throw invalid();
+		}
+		return terms[x];
+	}
+
+	vector<Term> termVector() {
+		vector<Term> v(count());
+		for (auto& a : v) {
+			a = term();
+		}
+		return v;
+	}
+
+	Type type() {
+		auto x = num();
+		if (x >= types.size()) {
+			throw invalid();
+		}
+		return types[x];
+	}
+
+	// The element or field types of compound types, and the parameter types of functions, cannot be void
+	Type valueType() {
+		auto ty = type();
+		if (ty == voidTy()) {
+			throw invalid();
+		}
+		return ty;
+	}
+
+	Type type1() {
+		auto kind = num();
+		switch (kind) {
+		case ArrayKind: {
+			auto len = num();
+			return arrayTy(len, valueType());
+		}
+		case DoubleKind:
+			return doubleTy();
+		case FloatKind:
+			return floatTy();
+		case FuncKind: {
+			vector<Type> v(count());
+			if (v.empty()) {
+				throw invalid();
+			}
+			v[0] = type();
+			for (size_t j = 1; j < v.size(); j++) {
+				v[j] = valueType();
+			}
+			return fnTy(v);
+		}
+		case IntKind: {
+			auto len = num();
+			if (!len) {
+				throw invalid();
+			}
+			return intTy(len);
+		}
+		case PtrKind:
+			return ptrTy();
+		case StructKind: {
+			vector<Type> v(count());
+			for (auto& t : v) {
+				t = valueType();
+			}
+			return structTy(v);
+		}
+		case VecKind: {
+			auto len = num();
+			return vecTy(len, valueType());
+		}
+		case VoidKind:
+			return voidTy();
+		}
+		throw invalid();
+	}
+
+public:
+	explicit CacheReader(std::string_view data): data(data) {
+	}
+
+	Module* read() {
+		// Tables
+		names.resize(count());
+		for (auto& ref : names) {
+			ref = Ref(str());
+		}
+
+		auto n = count();
+		types.reserve(n);
+		while (types.size() < n) {
+			types.push_back(type1());
+		}
+
+		n = count();
+		terms.reserve(n);
+		while (terms.size() < n) {
+			auto tag = num();
+			if (tag > Xor) {
+				throw invalid();
+			}
+			auto ty = type();
+			auto size = count();
+			if (size) {
+				vector<Term> v(size);
+				for (auto& a : v) {
+					a = term();
+				}
+				terms.push_back(Term(Tag(tag), ty, v));
+				continue;
+			}
+			if (tag == Int) {
+				if (ty.kind() != IntKind) {
+					throw invalid();
+				}
+				terms.push_back(intConst(ty, integer()));
+				continue;
+			}
+			terms.push_back(Term(Tag(tag), ty, ref()));
+		}
+
+		// Module
+		auto module = std::make_unique<Module>();
+		module->datalayout = str();
+		module->triple = str();
+
+		module->comdats.resize(count());
+		for (auto& r : module->comdats) {
+			r = ref();
+		}
+
+		n = count();
+		for (size_t j = 0; j < n; j++) {
+			auto ty = type();
+			auto ref = this->ref();
+			module->globals.push_back(Global(ty, ref, term()));
+		}
+
+		n = count();
+		for (size_t j = 0; j < n; j++) {
+			module->decls.push_back(fn(false));
+		}
+
+		n = count();
+		for (size_t j = 0; j < n; j++) {
+			module->defs.push_back(fn(true));
+		}
+
+		n = count();
+		for (size_t j = 0; j < n; j++) {
+			module->externals.insert(ref());
+		}
+
+		if (i != data.size()) {
+			throw invalid();
+		}
+		return module.release();
+	}
+};
+} // namespace
+
+uint64_t contentHash(std::string_view data) {
+	// FNV-1a, which is fixed, unlike std::hash, so a cache remains valid across builds of the program
+	uint64_t h = 0xcbf29ce484222325;
+	for (auto c : data) {
+		h ^= uint8_t(c);
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
+bool isCache(std::string_view data, uint64_t hash) {
+	return data.size() >= headerSize && data.substr(0, 8) == std::string_view(magic, 8) && load64(data, 8) == version() &&
+		   load64(data, 16) == hash;
+}
+
+void writeCache(ostream& os, const Module& module, uint64_t hash) {
+	CacheWriter writer(hash);
+	os << writer.write(module);
+}
+
+Module* readCache(string file, std::string_view data) {
+	try {
+		if (data.size() < headerSize || data.substr(0, 8) != std::string_view(magic, 8)) {
+			throw invalid();
+		}
+		CacheReader reader(data);
+		return reader.read();
+	} catch (const runtime_error& e) {
+		throw runtime_error(file + ": " + e.what());
+	}
+}
@@ -0,0 +1,22 @@
+// Binary image of a module, written next to an input file so that if the file has not changed, it need not be parsed again
+// Names, types and terms are each written once, in tables, and referred to by index
+// Each table only refers to entries before it, so loading builds each distinct type and term with a single interning
+// and everything else is built directly from the indexes, without lookahead or fixups
+// The format is specific to this version of the program, including the numbering of kinds, tags and opcodes
+
+// Loading is not zero-copy: the module is rebuilt from the mapped file rather than used in place
+// Types, terms and names are hash-consed, so a loaded node must be the same object as any equal node built otherwise
+// and IR nodes live in arenas that the collector sweeps, so they cannot point into a file mapping
+// Instead the file is read in a single sequential pass over the mapping, interning each distinct node once
+// and names are interned straight from the mapped bytes without an intermediate string
+
+// Identifies the contents of an input file
+uint64_t contentHash(std::string_view data);
+
+// Is this a cache made by this version of the program, from input with the given hash?
+bool isCache(std::string_view data, uint64_t hash);
+
+void writeCache(ostream& os, const Module& module, uint64_t hash);
+
+// The data need only remain valid during the call, as nothing in the resulting module refers to it
+Module* readCache(string file, std::string_view data);
@@ -22,7 +22,7 @@ template <typename T> vector<T> cons(const T& x, const vector<T>& xs) {
 template <typename Iterator> size_t hashRange(Iterator first, Iterator last) {
 	size_t h = 0;
 	for (; first != last; ++first) {
-		hash_combine(h, hash<typename Iterator::value_type>()(*first));
+		hash_combine(h, hash<typename std::iterator_traits<Iterator>::value_type>()(*first));
 	}
 	return h;
 }
@@ -42,6 +42,177 @@ inline void validate_bits(std::size_t bits) {
 }
 } // namespace detail
 
+/**
+ * The same operations on machine words, with the width known at compile time.
+ * Operands must already be in the range [0, 2^bits).
+ */
+namespace native_width_ops {
+template <unsigned bits> constexpr uint64_t mask() {
+	static_assert(0 < bits && bits <= 64);
+	if constexpr (bits == 64) {
+		return ~uint64_t(0);
+	} else {
+		return (uint64_t(1) << bits) - 1;
+	}
+}
+
+template <unsigned bits> constexpr int64_t to_signed(uint64_t a) {
+	if constexpr (bits == 64) {
+		return (int64_t)a;
+	} else {
+		constexpr uint64_t sign_bit = uint64_t(1) << (bits - 1);
+		return (int64_t)((a ^ sign_bit) - sign_bit);
+	}
+}
+
+template <unsigned bits> constexpr uint64_t add(uint64_t a, uint64_t b) {
+	return (a + b) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t sub(uint64_t a, uint64_t b) {
+	return (a - b) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t mul(uint64_t a, uint64_t b) {
+	return (a * b) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t udiv(uint64_t a, uint64_t b) {
+	return a / b;
+}
+
+template <unsigned bits> constexpr uint64_t sdiv(uint64_t a, uint64_t b) {
+	auto sa = to_signed<bits>(a);
+	auto sb = to_signed<bits>(b);
+	// The most negative value divided by -1 overflows, and wraps back to itself
+	if (sb == -1) {
+		return (0 - a) & mask<bits>();
+	}
+	return (uint64_t)(sa / sb) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t urem(uint64_t a, uint64_t b) {
+	return a % b;
+}
+
+template <unsigned bits> constexpr uint64_t srem(uint64_t a, uint64_t b) {
+	auto sa = to_signed<bits>(a);
+	auto sb = to_signed<bits>(b);
+	if (sb == -1) {
+		return 0;
+	}
+	return (uint64_t)(sa % sb) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t and_(uint64_t a, uint64_t b) {
+	return a & b;
+}
+
+template <unsigned bits> constexpr uint64_t or_(uint64_t a, uint64_t b) {
+	return a | b;
+}
+
+template <unsigned bits> constexpr uint64_t xor_(uint64_t a, uint64_t b) {
+	return a ^ b;
+}
+
+template <unsigned bits> constexpr uint64_t shl(uint64_t a, uint64_t b) {
+	if (b >= bits) {
+		return 0;
+	}
+	return (a << b) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t lshr(uint64_t a, uint64_t b) {
+	if (b >= bits) {
+		return 0;
+	}
+	return a >> b;
+}
+
+template <unsigned bits> constexpr uint64_t ashr(uint64_t a, uint64_t b) {
+	auto sa = to_signed<bits>(a);
+	if (b >= bits) {
+		return sa < 0 ? mask<bits>() : 0;
+	}
+	return (uint64_t)(sa >> b) & mask<bits>();
+}
+
+template <unsigned bits> constexpr uint64_t eq(uint64_t a, uint64_t b) {
+	return a == b;
+}
+
+template <unsigned bits> constexpr uint64_t ne(uint64_t a, uint64_t b) {
+	return a != b;
+}
+
+template <unsigned bits> constexpr uint64_t ult(uint64_t a, uint64_t b) {
+	return a < b;
+}
+
+template <unsigned bits> constexpr uint64_t ule(uint64_t a, uint64_t b) {
+	return a <= b;
+}
+
+template <unsigned bits> constexpr uint64_t slt(uint64_t a, uint64_t b) {
+	return to_signed<bits>(a) < to_signed<bits>(b);
+}
+
+template <unsigned bits> constexpr uint64_t sle(uint64_t a, uint64_t b) {
+	return to_signed<bits>(a) <= to_signed<bits>(b);
+}
+} // namespace native_width_ops
+
+namespace detail {
+// If the width is one of the common ones, and the operands are in range
+// perform the operation on machine words, with the width known at compile time
+// Otherwise return false, and the caller falls back to arbitrary precision
+template <class F> bool native(const cpp_int& a, const cpp_int& b, std::size_t bits, F f, cpp_int& r) {
+	if (bits > 64 || a < 0 || b < 0) {
+		return false;
+	}
+	if (bits < 64) {
+		auto limit = uint64_t(1) << bits;
+		if (a >= limit || b >= limit) {
+			return false;
+		}
+	} else if (a > (std::numeric_limits<uint64_t>::max)() || b > (std::numeric_limits<uint64_t>::max)()) {
+		return false;
+	}
+	auto x = a.convert_to<uint64_t>();
+	auto y = b.convert_to<uint64_t>();
+	switch (bits) {
+	case 1:
+		r = f(std::integral_constant<unsigned, 1>(), x, y);
+		return true;
+	case 8:
+		r = f(std::integral_constant<unsigned, 8>(), x, y);
+		return true;
+	case 16:
+		r = f(std::integral_constant<unsigned, 16>(), x, y);
+		return true;
+	case 32:
+		r = f(std::integral_constant<unsigned, 32>(), x, y);
+		return true;
+	case 64:
+		r = f(std::integral_constant<unsigned, 64>(), x, y);
+		return true;
+	}
+	return false;
+}
+} // namespace detail
+
+// Each fixed-width operation first tries the native version
+#define FIXED_WIDTH_NATIVE(op)                                                                                       \
+	do {                                                                                                             \
+		cpp_int r;                                                                                                   \
+		if (detail::native(                                                                                          \
+				a, b, bits, [](auto w, uint64_t x, uint64_t y) { return native_width_ops::op<decltype(w)::value>(x, y); }, \
+				r)) {                                                                                                \
+			return r;                                                                                                \
+		}                                                                                                            \
+	} while (0)
+
 /**
  * Fixed-width arithmetic operations following LLVM semantics.
  * All values are stored as unsigned integers internally.
@@ -50,16 +221,19 @@ namespace fixed_width_ops {
 // Arithmetic operations
 static cpp_int add(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(add);
 	return (a + b) & detail::create_mask(bits);
 }
 
 static cpp_int sub(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(sub);
 	return (a - b) & detail::create_mask(bits);
 }
 
 static cpp_int mul(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(mul);
 	return (a * b) & detail::create_mask(bits);
 }
 
@@ -68,6 +242,7 @@ static cpp_int udiv(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	if (b == 0) {
 		throw std::domain_error("Division by zero");
 	}
+	FIXED_WIDTH_NATIVE(udiv);
 	return (a / b) & detail::create_mask(bits);
 }
 
@@ -76,6 +251,7 @@ static cpp_int sdiv(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	if (b == 0) {
 		throw std::domain_error("Division by zero");
 	}
+	FIXED_WIDTH_NATIVE(sdiv);
 
 	// Convert to signed, perform division, convert back
 	cpp_int sa = detail::to_signed(a, bits);
@@ -89,6 +265,7 @@ static cpp_int urem(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	if (b == 0) {
 		throw std::domain_error("Division by zero");
 	}
+	FIXED_WIDTH_NATIVE(urem);
 	return (a % b) & detail::create_mask(bits);
 }
 
@@ -97,6 +274,7 @@ static cpp_int srem(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	if (b == 0) {
 		throw std::domain_error("Division by zero");
 	}
+	FIXED_WIDTH_NATIVE(srem);
 
 	// Convert to signed, perform remainder, convert back
 	cpp_int sa = detail::to_signed(a, bits);
@@ -108,22 +286,26 @@ static cpp_int srem(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 // Bitwise operations
 static cpp_int and_(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(and_);
 	return (a & b) & detail::create_mask(bits);
 }
 
 static cpp_int or_(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(or_);
 	return (a | b) & detail::create_mask(bits);
 }
 
 static cpp_int xor_(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(xor_);
 	return (a ^ b) & detail::create_mask(bits);
 }
 
 // Shift operations
 static cpp_int shl(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(shl);
 	// Convert shift amount to size_t
 	std::size_t shift = static_cast<std::size_t>(b);
 	// LLVM treats shifts >= width as producing poison
@@ -135,6 +317,7 @@ static cpp_int shl(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 
 static cpp_int lshr(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(lshr);
 	unsigned long shift = b.convert_to<unsigned long>();
 	if (shift >= bits) {
 		return 0;
@@ -144,6 +327,7 @@ static cpp_int lshr(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 
 static cpp_int ashr(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(ashr);
 	unsigned long shift = b.convert_to<unsigned long>();
 	if (shift >= bits) {
 		// Arithmetic shift fills with sign bit
@@ -160,26 +344,31 @@ static cpp_int ashr(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 // Comparison operations (return 1 for true, 0 for false)
 static cpp_int eq(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(eq);
 	return cpp_int(a == b);
 }
 
 static cpp_int ne(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(ne);
 	return cpp_int(a != b);
 }
 
 static cpp_int ult(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(ult);
 	return cpp_int(a < b);
 }
 
 static cpp_int ule(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(ule);
 	return cpp_int(a <= b);
 }
 
 static cpp_int slt(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(slt);
 	cpp_int sa = detail::to_signed(a, bits);
 	cpp_int sb = detail::to_signed(b, bits);
 	return cpp_int(sa < sb);
@@ -187,8 +376,11 @@ static cpp_int slt(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 
 static cpp_int sle(const cpp_int& a, const cpp_int& b, std::size_t bits) {
 	detail::validate_bits(bits);
+	FIXED_WIDTH_NATIVE(sle);
 	cpp_int sa = detail::to_signed(a, bits);
 	cpp_int sb = detail::to_signed(b, bits);
 	return cpp_int(sa <= sb);
 }
 }; // namespace fixed_width_ops
+
+#undef FIXED_WIDTH_NATIVE
@@ -4,23 +4,28 @@ struct FnImpl {
 	const Type rty;
 	const Ref ref;
 	const vector<Term> params;
-	const vector<Inst> body;
+	const PVector<Inst> body;
 
-	FnImpl(Type rty, const Ref& ref, const vector<Term>& params, const vector<Inst>& body)
+	// Reachable in the current garbage collection cycle
+	bool mark = false;
+
+	FnImpl(Type rty, const Ref& ref, const vector<Term>& params, const PVector<Inst>& body)
 		: rty(rty), ref(ref), params(params), body(body) {
 	}
 };
 
+Arena<FnImpl> fnArena;
+
 Fn::Fn() {
-	p = new FnImpl(voidTy(), (size_t)0, {}, {});
+	p = fnArena.make(voidTy(), (size_t)0, vector<Term>(), PVector<Inst>());
 }
 
 Fn::Fn(Type rty, const Ref& ref, const vector<Term>& params) {
-	p = new FnImpl(rty, ref, params, {});
+	p = fnArena.make(rty, ref, params, PVector<Inst>());
 }
 
-Fn::Fn(Type rty, const Ref& ref, const vector<Term>& params, const vector<Inst>& body) {
-	p = new FnImpl(rty, ref, params, body);
+Fn::Fn(Type rty, const Ref& ref, const vector<Term>& params, const PVector<Inst>& body) {
+	p = fnArena.make(rty, ref, params, body);
 }
 
 Type Fn::rty() const {
@@ -31,10 +36,14 @@ Ref Fn::ref() const {
 	return p->ref;
 }
 
-vector<Term> Fn::params() const {
+const vector<Term>& Fn::params() const {
 	return p->params;
 }
 
+PVector<Inst> Fn::body() const {
+	return p->body;
+}
+
 size_t Fn::size() const {
 	return p->body.size();
 }
@@ -44,6 +53,24 @@ Inst Fn::operator[](size_t i) const {
 	return p->body[i];
 }
 
+Fn Fn::set(size_t i, Inst inst) const {
+	ASSERT(i < size());
+	return Fn(p->rty, p->ref, p->params, p->body.set(i, inst));
+}
+
+void Fn::mark() const {
+	if (p->mark) {
+		return;
+	}
+	p->mark = true;
+	for (auto a : p->params) {
+		a.mark();
+	}
+	for (auto inst : p->body) {
+		inst.mark();
+	}
+}
+
 Fn::const_iterator Fn::begin() const {
 	return p->body.begin();
 }
@@ -53,9 +80,17 @@ Fn::const_iterator Fn::end() const {
 }
 
 Fn::const_iterator Fn::cbegin() const {
-	return p->body.cbegin();
+	return p->body.begin();
 }
 
 Fn::const_iterator Fn::cend() const {
-	return p->body.cend();
+	return p->body.end();
+}
+
+size_t sweepFns() {
+	return fnArena.sweep([](FnImpl* p) {
+		auto live = p->mark;
+		p->mark = false;
+		return live;
+	});
 }
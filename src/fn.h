@@ -11,11 +11,14 @@ public:
 	}
 
 	Fn(Type rty, const Ref& ref, const vector<Term>& params);
-	Fn(Type rty, const Ref& ref, const vector<Term>& params, const vector<Inst>& body);
+	Fn(Type rty, const Ref& ref, const vector<Term>& params, const PVector<Inst>& body);
 
 	Type rty() const;
 	Ref ref() const;
-	vector<Term> params() const;
+	const vector<Term>& params() const;
+
+	// The body is persistent, so this does not copy the instructions
+	PVector<Inst> body() const;
 
 	size_t size() const;
 
@@ -23,10 +26,22 @@ public:
 		return !size();
 	}
 
+	// The same function object, not just one with the same contents
+	bool identical(Fn b) const {
+		return p == b.p;
+	}
+
 	Inst operator[](size_t i) const;
 
+	// Return a copy of this function with one instruction changed
+	// sharing the rest of the body with the original
+	Fn set(size_t i, Inst inst) const;
+
+	// Mark this function, its parameters and body as reachable, for garbage collection
+	void mark() const;
+
 	// Iterators
-	using const_iterator = vector<Inst>::const_iterator;
+	using const_iterator = PVector<Inst>::const_iterator;
 
 	const_iterator begin() const;
 	const_iterator end() const;
@@ -34,3 +49,7 @@ public:
 	const_iterator cbegin() const;
 	const_iterator cend() const;
 };
+
+// Reclaim functions that have not been marked as reachable, and clear the marks on the rest
+// Returns the number of functions reclaimed
+size_t sweepFns();
@@ -0,0 +1,31 @@
+#include "all.h"
+
+static void mark(const Module* module) {
+	for (auto global : module->globals) {
+		global.mark();
+	}
+	for (auto f : module->decls) {
+		f.mark();
+	}
+	for (auto f : module->defs) {
+		f.mark();
+	}
+}
+
+size_t collect() {
+	// Mark
+	for (auto module : modules) {
+		mark(module);
+	}
+	mark(&context);
+
+	// Sweep, containers before their contents
+	// though as nodes are only marked or destroyed here, the order is not essential
+	size_t n = 0;
+	n += sweepPrograms();
+	n += sweepFns();
+	n += sweepGlobals();
+	n += sweepInsts();
+	n += sweepTerms();
+	return n;
+}
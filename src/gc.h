@@ -0,0 +1,5 @@
+// Reclaim IR nodes that are no longer reachable from `::modules` or `::context`
+// This is intended to be called between passes, once a pass has produced its replacement for the old code
+// Any other Term, Inst, Fn, Global or Program still held elsewhere becomes invalid
+// Returns the number of nodes reclaimed
+size_t collect();
@@ -5,20 +5,25 @@ struct GlobalImpl {
 	const Ref ref;
 	const Term val;
 
+	// Reachable in the current garbage collection cycle
+	bool mark = false;
+
 	GlobalImpl(Type ty, const Ref& ref, Term val): ty(ty), ref(ref), val(val) {
 	}
 };
 
+Arena<GlobalImpl> globalArena;
+
 Global::Global() {
-	p = new GlobalImpl(voidTy(), (size_t)0, Term());
+	p = globalArena.make(voidTy(), (size_t)0, Term());
 }
 
 Global::Global(Type ty, const Ref& ref) {
-	p = new GlobalImpl(ty, ref, none(ty));
+	p = globalArena.make(ty, ref, none(ty));
 }
 
 Global::Global(Type ty, const Ref& ref, Term val) {
-	p = new GlobalImpl(ty, ref, val);
+	p = globalArena.make(ty, ref, val);
 }
 
 Type Global::ty() const {
@@ -33,6 +38,14 @@ Term Global::val() const {
 	return p->val;
 }
 
+void Global::mark() const {
+	if (p->mark) {
+		return;
+	}
+	p->mark = true;
+	p->val.mark();
+}
+
 bool Global::operator==(Global b0) const {
 	auto a = p;
 	auto b = b0.p;
@@ -44,3 +57,11 @@ bool Global::operator==(Global b0) const {
 	}
 	return a->val == b->val;
 }
+
+size_t sweepGlobals() {
+	return globalArena.sweep([](GlobalImpl* p) {
+		auto live = p->mark;
+		p->mark = false;
+		return live;
+	});
+}
@@ -17,6 +17,9 @@ public:
 	Ref ref() const;
 	Term val() const;
 
+	// Mark this global variable and its value as reachable, for garbage collection
+	void mark() const;
+
 	// Comparison by value
 	bool operator==(Global b) const;
 
@@ -24,3 +27,7 @@ public:
 		return !(*this == b);
 	}
 };
+
+// Reclaim global variables that have not been marked as reachable, and clear the marks on the rest
+// Returns the number of global variables reclaimed
+size_t sweepGlobals();
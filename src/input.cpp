@@ -0,0 +1,120 @@
+#include "all.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static std::system_error lastError(const string& msg) {
+	return std::system_error(std::error_code(GetLastError(), std::system_category()), msg);
+}
+
+InputFile::InputFile(const string& filename) {
+	auto h = CreateFileA(
+		filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (h == INVALID_HANDLE_VALUE) {
+		throw lastError("Failed to open file: " + filename);
+	}
+
+	LARGE_INTEGER size;
+	if (GetFileType(h) == FILE_TYPE_DISK && GetFileSizeEx(h, &size) && size.QuadPart) {
+		auto mapping = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+		if (map) {
+			mapSize = size.QuadPart;
+			view = std::string_view((const char*)map, mapSize);
+			CloseHandle(h);
+			return;
+		}
+	}
+
+	// Fall back to reading
+	char chunk[1 << 16];
+	DWORD n;
+	for (;;) {
+		if (!ReadFile(h, chunk, sizeof chunk, &n, nullptr)) {
+			// A pipe whose writer has finished reports this instead of end of file
+			if (GetLastError() == ERROR_BROKEN_PIPE) {
+				break;
+			}
+			auto e = lastError("Failed to read file: " + filename);
+			CloseHandle(h);
+			throw e;
+		}
+		if (!n) {
+			break;
+		}
+		buf.append(chunk, n);
+	}
+	CloseHandle(h);
+	view = buf;
+}
+
+InputFile::~InputFile() {
+	if (map) {
+		UnmapViewOfFile(map);
+	}
+}
+#else
+static std::system_error lastError(const string& msg) {
+	return std::system_error(std::error_code(errno, std::system_category()), msg);
+}
+
+InputFile::InputFile(const string& filename) {
+	auto fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw lastError("Failed to open file: " + filename);
+	}
+
+	// An empty file cannot be mapped, but there is nothing to read either
+	struct stat st;
+	if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size) {
+		auto p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			map = p;
+			mapSize = st.st_size;
+#ifdef MADV_SEQUENTIAL
+			madvise(map, mapSize, MADV_SEQUENTIAL);
+#endif
+			view = std::string_view((const char*)map, mapSize);
+			close(fd);
+			return;
+		}
+	}
+
+	// Fall back to reading
+	char chunk[1 << 16];
+	for (;;) {
+		auto n = read(fd, chunk, sizeof chunk);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			auto e = lastError("Failed to read file: " + filename);
+			close(fd);
+			throw e;
+		}
+		if (!n) {
+			break;
+		}
+		buf.append(chunk, n);
+	}
+	close(fd);
+	view = buf;
+}
+
+InputFile::~InputFile() {
+	if (map) {
+		munmap(map, mapSize);
+	}
+}
+#endif
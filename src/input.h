@@ -0,0 +1,25 @@
+// Contents of an input file, as a read-only view
+// Regular files are memory-mapped, so the text is not copied, and pages are only read as the parser reaches them
+// Anything that cannot be mapped, such as a pipe, is read into memory instead
+// The view is valid for the lifetime of the object
+class InputFile {
+	// When the file could not be mapped
+	string buf;
+
+	// When it could
+	void* map = nullptr;
+	size_t mapSize = 0;
+
+	std::string_view view;
+
+public:
+	explicit InputFile(const string& filename);
+	~InputFile();
+
+	InputFile(const InputFile&) = delete;
+	InputFile& operator=(const InputFile&) = delete;
+
+	std::string_view text() const {
+		return view;
+	}
+};
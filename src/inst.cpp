@@ -2,30 +2,37 @@
 
 struct InstImpl {
 	const Opcode opcode;
-	const vector<Term> v;
 
-	InstImpl(Opcode opcode, const vector<Term>& v): opcode(opcode), v(v) {
+	// Most instructions have at most three operands, which are stored inline
+	const SmallVec<Term, 3> v;
+
+	// Reachable in the current garbage collection cycle
+	bool mark = false;
+
+	InstImpl(Opcode opcode, const SmallVec<Term, 3>& v): opcode(opcode), v(v) {
 	}
 };
 
+Arena<InstImpl> instArena;
+
 Inst::Inst(Opcode opcode) {
-	p = new InstImpl(opcode, {});
+	p = instArena.make(opcode, SmallVec<Term, 3>());
 }
 
 Inst::Inst(Opcode opcode, Term a) {
-	p = new InstImpl(opcode, {a});
+	p = instArena.make(opcode, SmallVec<Term, 3>{a});
 }
 
 Inst::Inst(Opcode opcode, Term a, Term b) {
-	p = new InstImpl(opcode, {a, b});
+	p = instArena.make(opcode, SmallVec<Term, 3>{a, b});
 }
 
 Inst::Inst(Opcode opcode, Term a, Term b, Term c) {
-	p = new InstImpl(opcode, {a, b, c});
+	p = instArena.make(opcode, SmallVec<Term, 3>{a, b, c});
 }
 
 Inst::Inst(Opcode opcode, const vector<Term>& v) {
-	p = new InstImpl(opcode, v);
+	p = instArena.make(opcode, v);
 }
 
 Opcode Inst::opcode() const {
@@ -41,6 +48,16 @@ Term Inst::operator[](size_t i) const {
 	return p->v[i];
 }
 
+void Inst::mark() const {
+	if (p->mark) {
+		return;
+	}
+	p->mark = true;
+	for (auto a : p->v) {
+		a.mark();
+	}
+}
+
 Inst::const_iterator Inst::begin() const {
 	return p->v.begin();
 }
@@ -50,11 +67,11 @@ Inst::const_iterator Inst::end() const {
 }
 
 Inst::const_iterator Inst::cbegin() const {
-	return p->v.cbegin();
+	return p->v.begin();
 }
 
 Inst::const_iterator Inst::cend() const {
-	return p->v.cend();
+	return p->v.end();
 }
 
 bool Inst::operator==(Inst b0) const {
@@ -65,3 +82,11 @@ bool Inst::operator==(Inst b0) const {
 	}
 	return a->v == b->v;
 }
+
+size_t sweepInsts() {
+	return instArena.sweep([](InstImpl* p) {
+		auto live = p->mark;
+		p->mark = false;
+		return live;
+	});
+}
@@ -81,8 +81,11 @@ public:
 	size_t size() const;
 	Term operator[](size_t i) const;
 
+	// Mark this instruction and its operands as reachable, for garbage collection
+	void mark() const;
+
 	// Iterators
-	using const_iterator = vector<Term>::const_iterator;
+	using const_iterator = const Term*;
 
 	const_iterator begin() const;
 	const_iterator end() const;
@@ -98,6 +101,10 @@ public:
 	}
 };
 
+// Reclaim instructions that have not been marked as reachable, and clear the marks on the rest
+// Returns the number of instructions reclaimed
+size_t sweepInsts();
+
 // SORT FUNCTIONS
 
 inline Inst alloca(Term lval, Type ty, Term n) {
@@ -0,0 +1,168 @@
+#include "all.h"
+
+// Native arithmetic with overflow detection
+// Each returns true if the result did not fit
+static bool addOverflow(int64_t a, int64_t b, int64_t& r) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_add_overflow(a, b, &r);
+#else
+	if ((b > 0 && a > (std::numeric_limits<int64_t>::max)() - b) ||
+		(b < 0 && a < (std::numeric_limits<int64_t>::min)() - b)) {
+		return true;
+	}
+	r = a + b;
+	return false;
+#endif
+}
+
+static bool subOverflow(int64_t a, int64_t b, int64_t& r) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_sub_overflow(a, b, &r);
+#else
+	if ((b < 0 && a > (std::numeric_limits<int64_t>::max)() + b) ||
+		(b > 0 && a < (std::numeric_limits<int64_t>::min)() + b)) {
+		return true;
+	}
+	r = a - b;
+	return false;
+#endif
+}
+
+static bool mulOverflow(int64_t a, int64_t b, int64_t& r) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_mul_overflow(a, b, &r);
+#else
+	if (!a || !b) {
+		r = 0;
+		return false;
+	}
+	if (a == -1 || b == -1) {
+		auto c = a == -1 ? b : a;
+		if (c == (std::numeric_limits<int64_t>::min)()) {
+			return true;
+		}
+		r = -c;
+		return false;
+	}
+	r = (int64_t)((uint64_t)a * (uint64_t)b);
+	return r / b != a;
+#endif
+}
+
+void Integer::set(const cpp_int& val) {
+	if ((std::numeric_limits<int64_t>::min)() <= val && val <= (std::numeric_limits<int64_t>::max)()) {
+		small = val.convert_to<int64_t>();
+		big.reset();
+		return;
+	}
+	small = 0;
+	big = std::make_shared<const cpp_int>(val);
+}
+
+Integer operator+(const Integer& a, const Integer& b) {
+	int64_t r;
+	if (a.isSmall() && b.isSmall() && !addOverflow(a.small, b.small, r)) {
+		return r;
+	}
+	return cpp_int(a.toCppInt() + b.toCppInt());
+}
+
+Integer operator-(const Integer& a, const Integer& b) {
+	int64_t r;
+	if (a.isSmall() && b.isSmall() && !subOverflow(a.small, b.small, r)) {
+		return r;
+	}
+	return cpp_int(a.toCppInt() - b.toCppInt());
+}
+
+Integer operator*(const Integer& a, const Integer& b) {
+	int64_t r;
+	if (a.isSmall() && b.isSmall() && !mulOverflow(a.small, b.small, r)) {
+		return r;
+	}
+	return cpp_int(a.toCppInt() * b.toCppInt());
+}
+
+Integer operator/(const Integer& a, const Integer& b) {
+	ASSERT(b);
+	// The only quotient of 64-bit values that does not fit is min / -1
+	if (a.isSmall() && b.isSmall() && !(a.small == (std::numeric_limits<int64_t>::min)() && b.small == -1)) {
+		return a.small / b.small;
+	}
+	return cpp_int(a.toCppInt() / b.toCppInt());
+}
+
+Integer operator%(const Integer& a, const Integer& b) {
+	ASSERT(b);
+	if (a.isSmall() && b.isSmall()) {
+		// Avoid min % -1, which traps on some processors
+		if (b.small == -1) {
+			return 0;
+		}
+		return a.small % b.small;
+	}
+	return cpp_int(a.toCppInt() % b.toCppInt());
+}
+
+Integer operator&(const Integer& a, const Integer& b) {
+	if (a.isSmall() && b.isSmall()) {
+		return a.small & b.small;
+	}
+	return cpp_int(a.toCppInt() & b.toCppInt());
+}
+
+Integer operator|(const Integer& a, const Integer& b) {
+	if (a.isSmall() && b.isSmall()) {
+		return a.small | b.small;
+	}
+	return cpp_int(a.toCppInt() | b.toCppInt());
+}
+
+Integer operator^(const Integer& a, const Integer& b) {
+	if (a.isSmall() && b.isSmall()) {
+		return a.small ^ b.small;
+	}
+	return cpp_int(a.toCppInt() ^ b.toCppInt());
+}
+
+Integer operator~(const Integer& a) {
+	if (a.isSmall()) {
+		return ~a.small;
+	}
+	return cpp_int(~a.toCppInt());
+}
+
+Integer operator<<(const Integer& a, unsigned n) {
+	if (a.isSmall() && n < 63) {
+		// Check that no significant bits would be shifted out
+		auto x = a.small;
+		if (x >= 0 ? x <= (std::numeric_limits<int64_t>::max)() >> n : x >= (std::numeric_limits<int64_t>::min)() >> n) {
+			return (int64_t)((uint64_t)x << n);
+		}
+	}
+	return cpp_int(a.toCppInt() << n);
+}
+
+Integer operator>>(const Integer& a, unsigned n) {
+	if (a.isSmall()) {
+		if (n > 63) {
+			return a.small < 0 ? -1 : 0;
+		}
+		return a.small >> n;
+	}
+	return cpp_int(a.toCppInt() >> n);
+}
+
+bool operator<(const Integer& a, const Integer& b) {
+	if (a.isSmall() && b.isSmall()) {
+		return a.small < b.small;
+	}
+	return a.toCppInt() < b.toCppInt();
+}
+
+ostream& operator<<(ostream& os, const Integer& a) {
+	if (a.isSmall()) {
+		return os << a.toSmall();
+	}
+	return os << a.toCppInt();
+}
@@ -0,0 +1,133 @@
+// Arbitrary precision integer, optimized for the common case
+// Nearly all integer constants in real code fit in 64 bits
+// so these are stored inline, and arithmetic on them uses native instructions
+// falling back to cpp_int only for values that do not fit, or operations that overflow
+// As with cpp_int, values are signed and unbounded
+// wrapping to a particular bit width is the responsibility of the caller
+class Integer {
+	// The representation is canonical: a value is stored in `small` if and only if it fits
+	// so two Integers are equal if and only if their representations are equal
+	int64_t small = 0;
+	std::shared_ptr<const cpp_int> big;
+
+	void set(const cpp_int& val);
+
+public:
+	Integer() {
+	}
+
+	template <class T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+	Integer(T val): small(val) {
+	}
+
+	template <class T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T>, int> = 0> Integer(T val) {
+		if (val <= (uint64_t)(std::numeric_limits<int64_t>::max)()) {
+			small = (int64_t)val;
+		} else {
+			set(cpp_int(val));
+		}
+	}
+
+	Integer(const cpp_int& val) {
+		set(val);
+	}
+
+	// Does the value fit in 64 bits?
+	bool isSmall() const {
+		return !big;
+	}
+
+	int64_t toSmall() const {
+		ASSERT(isSmall());
+		return small;
+	}
+
+	cpp_int toCppInt() const {
+		if (big) {
+			return *big;
+		}
+		return small;
+	}
+
+	operator cpp_int() const {
+		return toCppInt();
+	}
+
+	explicit operator bool() const {
+		return big || small;
+	}
+
+	template <class T> T convert_to() const {
+		if (big) {
+			return big->convert_to<T>();
+		}
+		return (T)small;
+	}
+
+	size_t hash() const {
+		if (big) {
+			return std::hash<cpp_int>()(*big);
+		}
+		return std::hash<int64_t>()(small);
+	}
+
+	// Arithmetic
+	friend Integer operator+(const Integer& a, const Integer& b);
+	friend Integer operator-(const Integer& a, const Integer& b);
+	friend Integer operator*(const Integer& a, const Integer& b);
+
+	// Division and remainder truncate toward zero, like C++ and cpp_int
+	// The divisor must not be zero
+	friend Integer operator/(const Integer& a, const Integer& b);
+	friend Integer operator%(const Integer& a, const Integer& b);
+
+	// Bitwise operations behave as though values were in two's complement
+	friend Integer operator&(const Integer& a, const Integer& b);
+	friend Integer operator|(const Integer& a, const Integer& b);
+	friend Integer operator^(const Integer& a, const Integer& b);
+	friend Integer operator~(const Integer& a);
+
+	// Right shift of a negative value is arithmetic, rounding toward negative infinity
+	friend Integer operator<<(const Integer& a, unsigned n);
+	friend Integer operator>>(const Integer& a, unsigned n);
+
+	Integer& operator|=(const Integer& b) {
+		return *this = *this | b;
+	}
+
+	// Comparison by value
+	friend bool operator==(const Integer& a, const Integer& b) {
+		if (a.big || b.big) {
+			return a.big && b.big && *a.big == *b.big;
+		}
+		return a.small == b.small;
+	}
+
+	friend bool operator!=(const Integer& a, const Integer& b) {
+		return !(a == b);
+	}
+
+	friend bool operator<(const Integer& a, const Integer& b);
+
+	friend bool operator<=(const Integer& a, const Integer& b) {
+		return !(b < a);
+	}
+
+	friend bool operator>(const Integer& a, const Integer& b) {
+		return b < a;
+	}
+
+	friend bool operator>=(const Integer& a, const Integer& b) {
+		return !(a < b);
+	}
+};
+
+namespace std {
+template <> struct hash<Integer> {
+	size_t operator()(const Integer& a) const {
+		return a.hash();
+	}
+};
+} // namespace std
+
+ostream& operator<<(ostream& os, const Integer& a);
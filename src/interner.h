@@ -0,0 +1,158 @@
+// Hash-consing table, safe for concurrent use
+// Types, terms and names are interned, so every thread that builds IR goes through one of these
+// The table is split into shards, each an open-addressed array of atomic pointers
+// Looking up an entry that is already present takes no lock
+// the common case, since most of the nodes a pass builds already exist
+// Adding a new entry locks only the shard it belongs to
+// Entries are never removed while other threads may be using the table
+// sweep is called only between passes, when the IR is not being built
+template <class T, class Hash, class Equal> class Interner {
+	static constexpr size_t shardBits = 6;
+	static constexpr size_t shardCount = size_t(1) << shardBits;
+
+	struct Table {
+		// A power of two, kept at most half full, so probes are short and always reach an empty slot
+		size_t cap;
+		std::unique_ptr<std::atomic<T*>[]> slots;
+
+		explicit Table(size_t cap): cap(cap), slots(new std::atomic<T*>[cap]) {
+			for (size_t i = 0; i < cap; i++) {
+				slots[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	struct Shard {
+		std::atomic<Table*> table;
+		std::mutex mutex;
+
+		// Guarded by the mutex
+		size_t n = 0;
+
+		// The current table, and any it has replaced
+		// Readers may still be probing a replaced table, so it is kept until the next sweep
+		vector<std::unique_ptr<Table>> tables;
+	};
+
+	Shard shards[shardCount];
+
+	// Mix the hash, so that both the high bits, which choose the shard, and the low bits, which choose the slot, vary
+	static size_t mix(size_t h) {
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccd;
+		h ^= h >> 33;
+		return h;
+	}
+
+	Shard& shard(size_t h) {
+		return shards[h >> (sizeof(size_t) * 8 - shardBits)];
+	}
+
+	template <class K> static T* find(const Table* table, const K& key, size_t h) {
+		for (auto i = h & (table->cap - 1);; i = (i + 1) & (table->cap - 1)) {
+			auto p = table->slots[i].load(std::memory_order_acquire);
+			if (!p) {
+				return nullptr;
+			}
+			if (Equal()(*p, key)) {
+				return p;
+			}
+		}
+	}
+
+	// Caller must hold the shard lock, or otherwise have exclusive access
+	static void insert(Table* table, T* p, size_t h) {
+		auto i = h & (table->cap - 1);
+		while (table->slots[i].load(std::memory_order_relaxed)) {
+			i = (i + 1) & (table->cap - 1);
+		}
+		table->slots[i].store(p, std::memory_order_release);
+	}
+
+	static void reset(Shard& s, size_t cap) {
+		s.tables.clear();
+		s.tables.push_back(std::make_unique<Table>(cap));
+		s.table.store(s.tables.back().get(), std::memory_order_release);
+	}
+
+	void grow(Shard& s) {
+		auto old = s.table.load(std::memory_order_relaxed);
+		s.tables.push_back(std::make_unique<Table>(old->cap * 2));
+		auto table = s.tables.back().get();
+		for (size_t i = 0; i < old->cap; i++) {
+			if (auto p = old->slots[i].load(std::memory_order_relaxed)) {
+				insert(table, p, mix(Hash()(*p)));
+			}
+		}
+		s.table.store(table, std::memory_order_release);
+	}
+
+public:
+	Interner() {
+		for (auto& s : shards) {
+			reset(s, 16);
+		}
+	}
+
+	Interner(const Interner&) = delete;
+	Interner& operator=(const Interner&) = delete;
+
+	// Return the entry equal to the key
+	// or, if there is none, the result of calling make, which is added to the table
+	// make should return a copy of the key with the lifetime of an IR node
+	// The key need not be a T, as long as Hash and Equal accept it
+	// and hash it the same way as the entry it is equal to
+	template <class K, class F> T* intern(const K& key, F make) {
+		auto h = mix(Hash()(key));
+		auto& s = shard(h);
+		if (auto p = find(s.table.load(std::memory_order_acquire), key, h)) {
+			return p;
+		}
+
+		// Another thread may have added the same entry since the lookup above
+		std::lock_guard<std::mutex> lock(s.mutex);
+		auto table = s.table.load(std::memory_order_relaxed);
+		if (auto p = find(table, key, h)) {
+			return p;
+		}
+		if ((s.n + 1) * 2 > table->cap) {
+			grow(s);
+			table = s.table.load(std::memory_order_relaxed);
+		}
+		auto p = make();
+		insert(table, p, h);
+		s.n++;
+		return p;
+	}
+
+	// Add an entry known not to be present, such as a statically allocated constant
+	void add(T* p) {
+		intern(*p, [=]() { return p; });
+	}
+
+	// Forget every entry for which the predicate returns false
+	// Not safe to call while other threads are using the table
+	template <class F> void sweep(F keep) {
+		for (auto& s : shards) {
+			vector<T*> live;
+			auto table = s.table.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < table->cap; i++) {
+				auto p = table->slots[i].load(std::memory_order_relaxed);
+				if (p && keep(p)) {
+					live.push_back(p);
+				}
+			}
+
+			size_t cap = 16;
+			while (live.size() * 2 > cap) {
+				cap *= 2;
+			}
+			reset(s, cap);
+			table = s.table.load(std::memory_order_relaxed);
+			for (auto p : live) {
+				insert(table, p, mix(Hash()(*p)));
+			}
+			s.n = live.size();
+		}
+	}
+};
@@ -0,0 +1,245 @@
+#include "all.h"
+
+namespace {
+size_t layoutId(const string& s) {
+	static std::mutex mutex;
+	static unordered_map<string, size_t> ids;
+	std::lock_guard<std::mutex> lock(mutex);
+	return ids.emplace(s, ids.size()).first->second;
+}
+
+vector<string> split(const string& s, char separator) {
+	vector<string> r;
+	size_t i = 0;
+	for (;;) {
+		auto j = s.find(separator, i);
+		if (j == string::npos) {
+			r.push_back(s.substr(i));
+			return r;
+		}
+		r.push_back(s.substr(i, j - i));
+		i = j + 1;
+	}
+}
+
+size_t number(const string& spec, const string& s) {
+	if (s.empty() || !std::all_of(s.begin(), s.end(), [](char c) { return '0' <= c && c <= '9'; })) {
+		throw runtime_error("datalayout: " + spec + ": expected number");
+	}
+	return std::stoull(s);
+}
+
+// Alignments are specified in bits
+size_t alignBytes(const string& spec, const string& s) {
+	auto bits = number(spec, s);
+	if (bits % 8) {
+		throw runtime_error("datalayout: " + spec + ": alignment must be a multiple of 8 bits");
+	}
+	return bits / 8;
+}
+
+size_t alignTo(size_t n, size_t align) {
+	if (align <= 1) {
+		return n;
+	}
+	return (n + align - 1) / align * align;
+}
+
+size_t powerOf2Ceil(size_t n) {
+	size_t r = 1;
+	while (r < n) {
+		r *= 2;
+	}
+	return r;
+}
+} // namespace
+
+DataLayout::DataLayout(const string& s): id(layoutId(s)) {
+	// LLVM defaults
+	intAligns = {{1, 1}, {8, 1}, {16, 2}, {32, 4}, {64, 4}};
+	floatAligns = {{16, 2}, {32, 4}, {64, 8}, {128, 16}};
+	vecAligns = {{64, 8}, {128, 16}};
+
+	if (s.empty()) {
+		return;
+	}
+	for (auto& spec : split(s, '-')) {
+		if (spec.empty()) {
+			throw runtime_error("datalayout: empty specification");
+		}
+		auto fields = split(spec.substr(1), ':');
+		switch (spec[0]) {
+		case 'E':
+			bigEndian = true;
+			break;
+		case 'e':
+			bigEndian = false;
+			break;
+		case 'p': {
+			// Only the default address space is relevant, as that is the one used by `ptr`
+			if (fields[0].size() && number(spec, fields[0])) {
+				break;
+			}
+			if (fields.size() < 3) {
+				throw runtime_error("datalayout: " + spec + ": expected size and alignment");
+			}
+			ptrSize = alignBytes(spec, fields[1]);
+			ptrAlign = alignBytes(spec, fields[2]);
+			break;
+		}
+		case 'a':
+			if (fields.size() < 2) {
+				throw runtime_error("datalayout: " + spec + ": expected alignment");
+			}
+			aggregateAlign = std::max(alignBytes(spec, fields[1]), size_t(1));
+			break;
+		case 'f':
+		case 'i':
+		case 'v': {
+			if (fields.size() < 2) {
+				throw runtime_error("datalayout: " + spec + ": expected size and alignment");
+			}
+			auto bits = number(spec, fields[0]);
+			auto align = alignBytes(spec, fields[1]);
+			auto& aligns = spec[0] == 'i' ? intAligns : spec[0] == 'f' ? floatAligns : vecAligns;
+			aligns[bits] = align;
+			break;
+		}
+		default:
+			// Mangling, native integer widths, stack alignment, address spaces for other purposes etc.
+			// do not affect the layout of types
+			break;
+		}
+	}
+}
+
+Layout* DataLayout::compute(Type ty) const {
+	auto r = std::make_unique<Layout>();
+	r->id = id;
+	switch (ty.kind()) {
+	case ArrayKind: {
+		auto element = layout(ty[0]);
+		r->storeSize = r->allocSize = element->allocSize * ty.len();
+		r->align = element->align;
+		return r.release();
+	}
+	case DoubleKind:
+	case FloatKind: {
+		auto bits = ty.kind() == FloatKind ? 32 : 64;
+		r->storeSize = bits / 8;
+		auto i = floatAligns.find(bits);
+		r->align = i == floatAligns.end() ? r->storeSize : i->second;
+		break;
+	}
+	case IntKind: {
+		auto bits = ty.len();
+		r->storeSize = (bits + 7) / 8;
+
+		// If there is no exact match, use the alignment of the smallest larger integer type
+		// or failing that, the largest integer type
+		auto i = intAligns.lower_bound(bits);
+		if (i == intAligns.end()) {
+			--i;
+		}
+		r->align = i->second;
+		break;
+	}
+	case PtrKind:
+		r->storeSize = ptrSize;
+		r->align = ptrAlign;
+		break;
+	case StructKind: {
+		size_t offset = 0;
+		r->align = aggregateAlign;
+		for (auto field : ty) {
+			auto a = layout(field);
+			offset = alignTo(offset, a->align);
+			r->offsets.push_back(offset);
+			offset += a->allocSize;
+			r->align = std::max(r->align, a->align);
+		}
+		r->storeSize = r->allocSize = alignTo(offset, r->align);
+		return r.release();
+	}
+	case VecKind: {
+		auto element = ty[0];
+		size_t elementBits;
+		switch (element.kind()) {
+		case DoubleKind:
+			elementBits = 64;
+			break;
+		case FloatKind:
+			elementBits = 32;
+			break;
+		case IntKind:
+			elementBits = element.len();
+			break;
+		case PtrKind:
+			elementBits = ptrSize * 8;
+			break;
+		default:
+			throw runtime_error("datalayout: invalid vector element type");
+		}
+		auto bits = elementBits * ty.len();
+		r->storeSize = (bits + 7) / 8;
+
+		// If there is no exact match, vectors are naturally aligned
+		auto i = vecAligns.find(bits);
+		r->align = i == vecAligns.end() ? powerOf2Ceil(r->storeSize) : i->second;
+		break;
+	}
+	default:
+		throw runtime_error("datalayout: type has no size");
+	}
+	r->align = std::max(r->align, size_t(1));
+	r->allocSize = alignTo(r->storeSize, r->align);
+	return r.release();
+}
+
+const Layout* DataLayout::layout(Type ty) const {
+	for (auto r = ty.layouts(); r; r = r->next) {
+		if (r->id == id) {
+			return r;
+		}
+	}
+
+	// If another thread computes the same layout at the same time, both are added
+	// which is harmless, as they are equal
+	auto r = compute(ty);
+	ty.addLayout(r);
+	return r;
+}
+
+size_t DataLayout::storeSize(Type ty) const {
+	return layout(ty)->storeSize;
+}
+
+size_t DataLayout::allocSize(Type ty) const {
+	return layout(ty)->allocSize;
+}
+
+size_t DataLayout::align(Type ty) const {
+	return layout(ty)->align;
+}
+
+size_t DataLayout::offset(Type ty, size_t i) const {
+	ASSERT(ty.kind() == StructKind);
+	auto r = layout(ty);
+	ASSERT(i < r->offsets.size());
+	return r->offsets[i];
+}
+
+size_t DataLayout::stride(Type ty) const {
+	switch (ty.kind()) {
+	case ArrayKind:
+		return allocSize(ty[0]);
+	case VecKind:
+		// Elements of a vector are packed, with no padding between them
+		// so the stride is the store size of the element, provided that is a whole number of bytes
+		if (isInt(ty[0]) && ty[0].len() % 8) {
+			throw runtime_error("datalayout: vector elements are not byte addressable");
+		}
+		return storeSize(ty[0]);
+	}
+	throw runtime_error("datalayout: stride of non-sequence type");
+}
@@ -0,0 +1,63 @@
+// Layout of one type under one DataLayout
+// Computed on first use, and cached on the interned type, so later queries cost a pointer lookup
+// Types live for the duration of the process, and so do these
+struct Layout {
+	size_t id;
+	size_t storeSize;
+	size_t allocSize;
+	size_t align;
+
+	// For a structure, the offset of each field
+	vector<size_t> offsets;
+
+	// Layouts of the same type under other DataLayouts
+	const Layout* next = nullptr;
+};
+
+// Size and alignment of types, as specified by the target datalayout string
+// https://llvm.org/docs/LangRef.html#data-layout
+// All sizes, alignments and offsets are in bytes
+class DataLayout {
+	// Identifies the layout rules, so that results cached on types can be matched to the layout that computed them
+	// Two DataLayouts parsed from the same string share an id, and therefore share cached results
+	size_t id;
+
+	bool bigEndian = false;
+
+	size_t ptrSize = 8;
+	size_t ptrAlign = 8;
+
+	// Minimum alignment of aggregates
+	size_t aggregateAlign = 1;
+
+	// ABI alignments, keyed by size in bits
+	std::map<size_t, size_t> intAligns;
+	std::map<size_t, size_t> floatAligns;
+	std::map<size_t, size_t> vecAligns;
+
+	const Layout* layout(Type ty) const;
+	Layout* compute(Type ty) const;
+
+public:
+	// An empty string means the LLVM defaults
+	explicit DataLayout(const string& s = "");
+
+	bool isBigEndian() const {
+		return bigEndian;
+	}
+
+	// Number of bytes written by a store of the type, excluding padding
+	size_t storeSize(Type ty) const;
+
+	// Number of bytes between successive objects of the type, including padding
+	size_t allocSize(Type ty) const;
+
+	// ABI alignment
+	size_t align(Type ty) const;
+
+	// Offset of field i of a structure type
+	size_t offset(Type ty, size_t i) const;
+
+	// Distance between successive elements of an array or vector type
+	size_t stride(Type ty) const;
+};
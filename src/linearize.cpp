@@ -0,0 +1,312 @@
+#include "all.h"
+
+namespace {
+bool atomic(Term a) {
+	return !a.size() || a.constant();
+}
+
+bool contains(Term a, Term v) {
+	if (a == v) {
+		return true;
+	}
+	if (!a.hasVar()) {
+		return false;
+	}
+	for (auto b : a) {
+		if (contains(b, v)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool flat(Term a) {
+	for (auto b : a) {
+		if (!atomic(b)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Does the instruction already have the form LLVM requires?
+bool flat(Inst inst) {
+	switch (inst.opcode()) {
+	case Alloca:
+		return atomic(inst[2]);
+	case Assign:
+		return flat(inst[1]);
+	case Drop:
+		return inst[0].tag() == Call ? flat(inst[0]) : atomic(inst[0]);
+	case Phi:
+		return true;
+	}
+	for (auto a : inst) {
+		if (!atomic(a)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void maxNum(Term a, size_t& n) {
+	if (a.size()) {
+		for (auto b : a) {
+			maxNum(b, n);
+		}
+		return;
+	}
+	if ((a.tag() == Var || a.tag() == Label) && a.ref().numeric()) {
+		n = std::max(n, a.ref().num() + 1);
+	}
+}
+
+// LLVM requires numbered variables and labels to be defined in sequence, counting unnamed parameters,
+// the entry block if it has no label, and the results of calls that are not assigned to anything
+Fn renumber(const Fn& f, vector<Inst>& body) {
+	unordered_map<Term, Term> m;
+	size_t n = 0;
+	auto def = [&](Term a) {
+		if (a.ref().numeric() && !m.count(a)) {
+			m.emplace(a, Term(a.tag(), a.ty(), Ref(n++)));
+		}
+	};
+
+	for (auto a : f.params()) {
+		switch (a.tag()) {
+		case None:
+			n++;
+			break;
+		case Var:
+			def(a);
+			break;
+		}
+	}
+	if (body[0].opcode() != Block) {
+		n++;
+	}
+	for (auto inst : body) {
+		switch (inst.opcode()) {
+		case Alloca:
+		case Assign:
+		case Block:
+		case Phi:
+			def(inst[0]);
+			break;
+		case Drop:
+			if (inst[0].tag() == Call && inst[0].ty() != voidTy()) {
+				n++;
+			}
+			break;
+		}
+	}
+	return replace(Fn(f.rty(), f.ref(), f.params(), body), m);
+}
+
+void vars(Term a, unordered_set<Term>& s) {
+	if (!a.hasVar()) {
+		return;
+	}
+	if (a.tag() == Var) {
+		s.insert(a);
+		return;
+	}
+	for (auto b : a) {
+		vars(b, s);
+	}
+}
+
+class Linearizer {
+	vector<Inst> body;
+
+	// Number of the next temporary
+	size_t next;
+
+	// Subterms already computed in this block, and where to find their values
+	unordered_map<Term, Term> avail;
+
+	// For each variable, the subterms whose entries would be wrong once it is given a new value
+	// those that contain it, and those whose values are in it
+	// Entries already removed for some other reason may remain in these lists, which is harmless
+	unordered_map<Term, vector<Term>> uses;
+
+	// Subterms that load from memory
+	vector<Term> loads;
+
+	// SORT FUNCTIONS
+
+	// Something that may write memory has happened
+	void clobber() {
+		for (auto a : loads) {
+			avail.erase(a);
+		}
+		loads.clear();
+	}
+
+	// The variable has been given a new value
+	void define(Term v) {
+		auto i = uses.find(v);
+		if (i == uses.end()) {
+			return;
+		}
+		for (auto a : i->second) {
+			avail.erase(a);
+		}
+		uses.erase(i);
+	}
+
+	// Add an instruction, after those that compute its operands
+	void emit(Inst inst) {
+		body.push_back(inst);
+		switch (inst.opcode()) {
+		case Alloca:
+		case Assign:
+			define(inst[0]);
+			break;
+		case Block:
+			avail.clear();
+			uses.clear();
+			loads.clear();
+			return;
+		case Store:
+			clobber();
+			return;
+		}
+		for (auto a : inst) {
+			if (a.hasCall()) {
+				clobber();
+				return;
+			}
+		}
+	}
+
+	// An atom or constant with the same value as the term
+	Term operand(Term a) {
+		if (atomic(a)) {
+			return a;
+		}
+		auto i = avail.find(a);
+		if (i != avail.end()) {
+			return i->second;
+		}
+
+		// Temporaries are new variables, so there is nothing for their definitions to invalidate
+		auto t = var(a.ty(), Ref(next++));
+		body.push_back(assign(t, operands(a)));
+		if (a.hasCall()) {
+			clobber();
+		} else {
+			remember(a, t);
+		}
+		return t;
+	}
+
+	// A term with each compound operand replaced by the temporary that holds its value
+	Term operands(Term a) {
+		if (atomic(a)) {
+			return a;
+		}
+		vector<Term> v;
+		for (auto b : a) {
+			v.push_back(operand(b));
+		}
+		return Term(a.tag(), a.ty(), v);
+	}
+
+	// Later occurrences of the subterm can use the variable
+	void remember(Term a, Term v) {
+		if (!avail.emplace(a, v).second) {
+			return;
+		}
+		unordered_set<Term> s;
+		vars(a, s);
+		s.insert(v);
+		for (auto x : s) {
+			uses[x].push_back(a);
+		}
+		if (a.hasLoad()) {
+			loads.push_back(a);
+		}
+	}
+
+public:
+	explicit Linearizer(size_t next): next(next) {
+	}
+
+	void add(Inst inst) {
+		switch (inst.opcode()) {
+		case Alloca:
+			emit(alloca(inst[0], inst[1].ty(), operand(inst[2])));
+			return;
+		case Assign: {
+			auto v = inst[0];
+			auto a = inst[1];
+			emit(assign(v, operands(a)));
+
+			// Later occurrences of the expression can use the variable
+			// unless the expression refers to the variable's previous value
+			if (!atomic(a) && !a.hasCall() && !contains(a, v)) {
+				remember(a, v);
+			}
+			return;
+		}
+		case Drop:
+			// The value is discarded, so only a call need remain as an instruction
+			// anything else is computed, to keep any effects of evaluating it
+			if (inst[0].tag() == Call) {
+				emit(Inst(Drop, operands(inst[0])));
+				return;
+			}
+			if (!atomic(inst[0])) {
+				operand(inst[0]);
+			}
+			return;
+		case Phi:
+			emit(inst);
+			return;
+		}
+		vector<Term> v;
+		for (auto a : inst) {
+			v.push_back(operand(a));
+		}
+		emit(Inst(inst.opcode(), v));
+	}
+
+	Fn result(const Fn& f) {
+		return renumber(f, body);
+	}
+};
+} // namespace
+
+Fn linearize(const Fn& f) {
+	if (f.empty()) {
+		return f;
+	}
+	bool done = true;
+	for (auto inst : f) {
+		if (!flat(inst)) {
+			done = false;
+			break;
+		}
+	}
+	if (done) {
+		return f;
+	}
+
+	// Temporaries are numbered after everything already numbered, then renumbered with the rest
+	size_t next = 0;
+	for (auto a : f.params()) {
+		maxNum(a, next);
+	}
+	for (auto inst : f) {
+		for (auto a : inst) {
+			maxNum(a, next);
+		}
+	}
+
+	Linearizer linearizer(next);
+	for (auto inst : f) {
+		linearizer.add(inst);
+	}
+	return linearizer.result(f);
+}
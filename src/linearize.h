@@ -0,0 +1,12 @@
+// LLVM instructions take only atoms and constants as operands
+// but Olivine operands can be nested expressions, as produced by inlining, simplification and convertToSSA
+// Linearization assigns each compound operand to a new temporary just before the instruction that uses it
+// working from the inside out, so the result can be printed one operation per line
+// Within a block, a subterm that occurs more than once is computed once, and later occurrences use the same temporary
+// unless something in between may change its value: reassigning a variable it contains
+// or, for a subterm that loads from memory, a store or call
+// Calls are never shared, as each evaluation may have different effects
+// Temporaries are numbered, so all numbered variables and labels are renumbered in order of definition
+// as LLVM requires; named ones are unchanged
+// A function whose operands are already atomic is returned as is
+Fn linearize(const Fn& f);
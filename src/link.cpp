@@ -202,13 +202,14 @@ void link() {
 		}
 
 		// Update globals
+		auto mask = keyFlags(termMap);
 		for (auto& global : context.globals) {
-			global = replace(global, termMap);
+			global = replace(global, termMap, mask);
 		}
 
 		// Update function definitions
 		for (auto& def : context.defs) {
-			def = replace(def, termMap);
+			def = replace(def, termMap, mask);
 		}
 	}
 }
@@ -0,0 +1,119 @@
+#include "all.h"
+
+void Numbering::addVar(Term a) {
+	if (!a.hasVar()) {
+		return;
+	}
+	if (a.tag() == Var) {
+		if (varIndex.emplace(a.ref(), varTerms.size()).second) {
+			varTerms.push_back(a);
+		}
+		return;
+	}
+	for (auto b : a) {
+		addVar(b);
+	}
+}
+
+void Numbering::addLabel(const Ref& ref) {
+	if (labelIndex.emplace(ref, labelRefs.size()).second) {
+		labelRefs.push_back(ref);
+	}
+}
+
+Numbering::Numbering(const Fn& f) {
+	for (auto a : f.params()) {
+		addVar(a);
+	}
+	for (auto inst : f) {
+		for (auto a : inst) {
+			// Labels only occur as direct operands of instructions
+			if (a.tag() == Label) {
+				addLabel(a.ref());
+				continue;
+			}
+			addVar(a);
+		}
+	}
+}
+
+size_t Numbering::var(const Ref& ref) const {
+	auto i = varIndex.find(ref);
+	ASSERT(i != varIndex.end());
+	return i->second;
+}
+
+size_t Numbering::label(const Ref& ref) const {
+	auto i = labelIndex.find(ref);
+	ASSERT(i != labelIndex.end());
+	return i->second;
+}
+
+size_t VarSet::ctz(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(w);
+#else
+	size_t i = 0;
+	while (!(w & 1)) {
+		w >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+bool VarSet::empty() const {
+	for (auto w : words) {
+		if (w) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t VarSet::count() const {
+	size_t r = 0;
+	for (auto w : words) {
+#if defined(__GNUC__) || defined(__clang__)
+		r += __builtin_popcountll(w);
+#else
+		for (; w; w &= w - 1) {
+			r++;
+		}
+#endif
+	}
+	return r;
+}
+
+bool VarSet::addAll(const VarSet& b) {
+	ASSERT(n == b.n);
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		auto w = words[i] | b.words[i];
+		changed |= w ^ words[i];
+		words[i] = w;
+	}
+	return changed;
+}
+
+bool VarSet::keepOnly(const VarSet& b) {
+	ASSERT(n == b.n);
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		auto w = words[i] & b.words[i];
+		changed |= w ^ words[i];
+		words[i] = w;
+	}
+	return changed;
+}
+
+bool VarSet::removeAll(const VarSet& b) {
+	ASSERT(n == b.n);
+	uint64_t changed = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		auto w = words[i] & ~b.words[i];
+		changed |= w ^ words[i];
+		words[i] = w;
+	}
+	return changed;
+}
@@ -0,0 +1,172 @@
+// Dense numbering of the local variables and labels of a function
+// Variables, including parameters, are numbered 0, 1, 2... in order of first appearance, parameters first
+// Labels are numbered separately, in the same way
+// Per-function analyses can then use the numbers to index VarSet and VarMap
+// which are much faster than hash tables keyed by Ref or Term
+class Numbering {
+	vector<Term> varTerms;
+	unordered_map<Ref, size_t> varIndex;
+
+	vector<Ref> labelRefs;
+	unordered_map<Ref, size_t> labelIndex;
+
+	void addVar(Term a);
+	void addLabel(const Ref& ref);
+
+public:
+	explicit Numbering(const Fn& f);
+
+	// Variables
+	size_t vars() const {
+		return varTerms.size();
+	}
+
+	// The variable must occur in the function
+	size_t var(const Ref& ref) const;
+
+	size_t var(Term a) const {
+		ASSERT(a.tag() == Var);
+		return var(a.ref());
+	}
+
+	// The variable term numbered i
+	Term var(size_t i) const {
+		return varTerms[i];
+	}
+
+	// Labels
+	size_t labels() const {
+		return labelRefs.size();
+	}
+
+	// The label must occur in the function
+	size_t label(const Ref& ref) const;
+
+	size_t label(Term a) const {
+		ASSERT(a.tag() == Label);
+		return label(a.ref());
+	}
+
+	// The label numbered i
+	Ref label(size_t i) const {
+		return labelRefs[i];
+	}
+};
+
+// Set of variable or label numbers, represented as a bitset
+// so that union, intersection and difference operate on a word at a time
+// Sets being combined must have the same capacity, normally the number of variables or labels in the function
+class VarSet {
+	static constexpr size_t wordBits = 64;
+
+	size_t n;
+	vector<uint64_t> words;
+
+	static size_t ctz(uint64_t w);
+
+public:
+	explicit VarSet(size_t n): n(n), words((n + wordBits - 1) / wordBits) {
+	}
+
+	size_t capacity() const {
+		return n;
+	}
+
+	bool has(size_t i) const {
+		ASSERT(i < n);
+		return words[i / wordBits] >> (i % wordBits) & 1;
+	}
+
+	void add(size_t i) {
+		ASSERT(i < n);
+		words[i / wordBits] |= uint64_t(1) << (i % wordBits);
+	}
+
+	void remove(size_t i) {
+		ASSERT(i < n);
+		words[i / wordBits] &= ~(uint64_t(1) << (i % wordBits));
+	}
+
+	void clear() {
+		std::fill(words.begin(), words.end(), 0);
+	}
+
+	bool empty() const;
+
+	// Number of elements
+	size_t count() const;
+
+	// Each of these returns true if the set changed
+	// which is what iterative dataflow analysis needs to detect a fixed point
+	bool addAll(const VarSet& b);
+	bool keepOnly(const VarSet& b);
+	bool removeAll(const VarSet& b);
+
+	VarSet& operator|=(const VarSet& b) {
+		addAll(b);
+		return *this;
+	}
+
+	VarSet& operator&=(const VarSet& b) {
+		keepOnly(b);
+		return *this;
+	}
+
+	VarSet& operator-=(const VarSet& b) {
+		removeAll(b);
+		return *this;
+	}
+
+	// Call f on each element, in ascending order
+	template <class F> void each(F f) const {
+		for (size_t i = 0; i < words.size(); i++) {
+			for (auto w = words[i]; w; w &= w - 1) {
+				f(i * wordBits + ctz(w));
+			}
+		}
+	}
+
+	// Comparison by value
+	bool operator==(const VarSet& b) const {
+		return words == b.words;
+	}
+
+	bool operator!=(const VarSet& b) const {
+		return !(*this == b);
+	}
+};
+
+// Map from variable or label numbers to values, represented as a vector
+// Every number in range has a value, initially the default
+template <class T> class VarMap {
+	vector<T> v;
+
+public:
+	explicit VarMap(size_t n, const T& x = T()): v(n, x) {
+	}
+
+	size_t size() const {
+		return v.size();
+	}
+
+	T& operator[](size_t i) {
+		ASSERT(i < v.size());
+		return v[i];
+	}
+
+	const T& operator[](size_t i) const {
+		ASSERT(i < v.size());
+		return v[i];
+	}
+
+	// Iterators
+	using const_iterator = typename vector<T>::const_iterator;
+
+	const_iterator begin() const {
+		return v.begin();
+	}
+
+	const_iterator end() const {
+		return v.end();
+	}
+};
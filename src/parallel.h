@@ -0,0 +1,51 @@
+// Call f(i) for each i in [0, n), on up to the specified number of threads
+// Each thread takes the next unclaimed index, so uneven amounts of work per index balance out
+// With one thread, or one index, f is called on the current thread, in order
+// If any call throws, indexes above the lowest that has failed so far are abandoned
+// Indexes below it still run, as one of them may also fail
+// so the exception from the lowest failing index is rethrown, and errors are reported the same way regardless of timing
+template <class F> void parallelFor(size_t n, size_t threads, F f) {
+	threads = std::min(threads, n);
+	if (threads <= 1) {
+		for (size_t i = 0; i < n; i++) {
+			f(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> firstFailed(n);
+	vector<std::exception_ptr> errors(n);
+	auto work = [&]() {
+		for (;;) {
+			auto i = next.fetch_add(1);
+			// Indexes are claimed in ascending order, so every later one would also be abandoned
+			if (i >= n || i > firstFailed.load()) {
+				return;
+			}
+			try {
+				f(i);
+			} catch (...) {
+				errors[i] = std::current_exception();
+				auto j = firstFailed.load();
+				while (i < j && !firstFailed.compare_exchange_weak(j, i)) {
+				}
+			}
+		}
+	};
+
+	vector<std::thread> pool;
+	for (size_t i = 1; i < threads; i++) {
+		pool.emplace_back(work);
+	}
+	work();
+	for (auto& t : pool) {
+		t.join();
+	}
+
+	for (auto& e : errors) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+}
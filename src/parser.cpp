@@ -62,7 +62,7 @@ bool endsWith(string s, int c) {
 	return s.size() && s.back() == c;
 }
 
-unsigned parseHex(string s, size_t& pos, int maxLen) {
+unsigned parseHex(std::string_view s, size_t& pos, int maxLen) {
 	// Check if we're already at the end of the string
 	if (pos >= s.length()) {
 		throw runtime_error("No hexadecimal digits found: end of string");
@@ -103,7 +103,7 @@ unsigned parseHex(string s, size_t& pos, int maxLen) {
 	return result;
 }
 
-string removeSigil(string s) {
+std::string_view removeSigil(std::string_view s) {
 	ASSERT(s.size());
 	switch (s[0]) {
 	case '$':
@@ -119,8 +119,10 @@ string removeSigil(string s) {
 	return s;
 }
 
-string unwrap(string s) {
-	s = removeSigil(s);
+// Most identifiers are unquoted, or quoted without escape sequences
+// in which case the unwrapped text is just a view of the token, and no string need be built
+// s has already had its sigil removed
+static bool unwrapView(std::string_view s, std::string_view& r) {
 	ASSERT(s.size());
 
 	// Unquoted index number or identifier
@@ -128,14 +130,33 @@ string unwrap(string s) {
 		for (auto c : s) {
 			ASSERT(isIdPart(c));
 		}
-		return s;
+		r = s;
+		return true;
+	}
+
+	// Quoted, with nothing to evaluate
+	if (1 < s.size() && s.back() == '"') {
+		r = s.substr(1, s.size() - 2);
+		return r.find_first_of("\\\"") == std::string_view::npos;
+	}
+	return false;
+}
+
+string unwrap(std::string_view s) {
+	s = removeSigil(s);
+	std::string_view r;
+	if (unwrapView(s, r)) {
+		return string(r);
 	}
 
-	// Quoted identifier or string
+	// Quoted identifier or string with escape sequences
 	size_t pos = 1;
-	string r;
-	while (s[pos] != '"') {
+	string t;
+	for (;;) {
 		ASSERT(pos < s.size());
+		if (s[pos] == '"') {
+			break;
+		}
 		int c = s[pos++];
 		if (c == '\\') {
 			ASSERT(pos < s.size());
@@ -150,13 +171,23 @@ string unwrap(string s) {
 				break;
 			}
 		}
-		r += c;
+		t += c;
 	}
 	ASSERT(pos == s.size() - 1);
-	return r;
+	return t;
+}
+
+// Reference to the name in an identifier or string, building a string only if there are escape sequences to evaluate
+static Ref nameRef(std::string_view s) {
+	s = removeSigil(s);
+	std::string_view r;
+	if (unwrapView(s, r)) {
+		return Ref(r);
+	}
+	return Ref(unwrap(s));
 }
 
-Ref parseRef(string s) {
+Ref parseRef(std::string_view s) {
 	s = removeSigil(s);
 	ASSERT(s.size());
 
@@ -165,11 +196,52 @@ Ref parseRef(string s) {
 		for (auto c : s) {
 			ASSERT(isDigit(c));
 		}
-		return Ref(stoull(s));
+		return Ref(stoull(string(s)));
 	}
 
 	// Identifier or string
-	return Ref(unwrap(s));
+	return nameRef(s);
+}
+
+Integer parseInt(std::string_view s) {
+	auto negative = s.size() && s[0] == '-';
+	auto i = size_t(negative);
+	uint64_t base = 10;
+	if (s.size() > i + 2 && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+		base = 16;
+		i += 2;
+	}
+
+	// Native arithmetic, as long as the magnitude fits in 64 bits
+	if (i < s.size()) {
+		uint64_t r = 0;
+		for (; i < s.size(); i++) {
+			auto c = s[i];
+			uint64_t digit;
+			if (isDigit(c)) {
+				digit = c - '0';
+			} else if (base == 16 && isXDigit(c)) {
+				digit = (c | 0x20) - 'a' + 10;
+			} else {
+				break;
+			}
+			if (r > ((std::numeric_limits<uint64_t>::max)() - digit) / base) {
+				break;
+			}
+			r = r * base + digit;
+		}
+		if (i == s.size()) {
+			if (!negative) {
+				return r;
+			}
+			if (r <= uint64_t(1) << 63) {
+				return Integer(int64_t(0 - r));
+			}
+		}
+	}
+
+	// Too large, or not a valid number, in which case cpp_int reports the error
+	return cpp_int(string(s));
 }
 
 // Quote a string, particularly a token, for echoing to the user
@@ -181,141 +253,541 @@ static string quote(string s) {
 	return '\'' + s + '\'';
 }
 
+enum TokKind {
+	// End of input
+	End,
+
+	Newline,
+
+	// Identifier, keyword or number
+	Word,
+
+	// Names with sigils
+	ComdatName,
+	GlobalName,
+	LocalName,
+
+	// Quoted string, or c"..." byte array
+	String,
+
+	// Definition of a basic block label: word or string followed by a colon
+	LabelDef,
+
+	// Single character, or `...`
+	Punct,
+};
+
+// Keywords are recognized once, when a word is lexed
+// so the parser can switch on an enum instead of comparing strings
+enum Keyword {
+	NoKeyword,
+
+	AddKw,
+	AddrspaceKw,
+	AlignKw,
+	AllocaKw,
+	AndKw,
+	AnyKw,
+	AppendingKw,
+	AshrKw,
+	AvailableExternallyKw,
+	BitcastKw,
+	BrKw,
+	CallKw,
+	ComdatKw,
+	CommonKw,
+	ConstantKw,
+	DatalayoutKw,
+	DeclareKw,
+	DefineKw,
+	DoubleKw,
+	DsoLocalKw,
+	DsoPreemptableKw,
+	EqKw,
+	ExactKw,
+	ExternWeakKw,
+	ExternalKw,
+	FaddKw,
+	FalseKw,
+	FastKw,
+	FcmpKw,
+	FdivKw,
+	FloatKw,
+	FmulKw,
+	FnegKw,
+	FpextKw,
+	FptosiKw,
+	FptouiKw,
+	FptruncKw,
+	FremKw,
+	FsubKw,
+	GetelementptrKw,
+	GlobalKw,
+	IcmpKw,
+	InboundsKw,
+	InternalKw,
+	InttoptrKw,
+	LabelKw,
+	LinkonceKw,
+	LinkonceOdrKw,
+	LoadKw,
+	LocalUnnamedAddrKw,
+	LshrKw,
+	MulKw,
+	NeKw,
+	NinfKw,
+	NnanKw,
+	NoundefKw,
+	NswKw,
+	NszKw,
+	NullKw,
+	NuwKw,
+	OeqKw,
+	OgeKw,
+	OgtKw,
+	OleKw,
+	OltKw,
+	OrKw,
+	PhiKw,
+	PrivateKw,
+	PtrKw,
+	PtrtointKw,
+	RetKw,
+	SdivKw,
+	SextKw,
+	SgeKw,
+	SgtKw,
+	ShlKw,
+	SitofpKw,
+	SleKw,
+	SltKw,
+	SremKw,
+	StoreKw,
+	SubKw,
+	SwitchKw,
+	TargetKw,
+	ToKw,
+	TripleKw,
+	TrueKw,
+	TruncKw,
+	UdivKw,
+	UgeKw,
+	UgtKw,
+	UitofpKw,
+	UleKw,
+	UltKw,
+	UneKw,
+	UnnamedAddrKw,
+	UnreachableKw,
+	UremKw,
+	VoidKw,
+	WeakKw,
+	WeakOdrKw,
+	XKw,
+	XorKw,
+	ZeroinitializerKw,
+	ZextKw,
+
+	// Not a keyword, but the number of them
+	KeywordCount,
+};
+
+// Indexed by Keyword, for error messages
+static const char* keywordNames[] = {
+	"",
+
+	"add",
+	"addrspace",
+	"align",
+	"alloca",
+	"and",
+	"any",
+	"appending",
+	"ashr",
+	"available_externally",
+	"bitcast",
+	"br",
+	"call",
+	"comdat",
+	"common",
+	"constant",
+	"datalayout",
+	"declare",
+	"define",
+	"double",
+	"dso_local",
+	"dso_preemptable",
+	"eq",
+	"exact",
+	"extern_weak",
+	"external",
+	"fadd",
+	"false",
+	"fast",
+	"fcmp",
+	"fdiv",
+	"float",
+	"fmul",
+	"fneg",
+	"fpext",
+	"fptosi",
+	"fptoui",
+	"fptrunc",
+	"frem",
+	"fsub",
+	"getelementptr",
+	"global",
+	"icmp",
+	"inbounds",
+	"internal",
+	"inttoptr",
+	"label",
+	"linkonce",
+	"linkonce_odr",
+	"load",
+	"local_unnamed_addr",
+	"lshr",
+	"mul",
+	"ne",
+	"ninf",
+	"nnan",
+	"noundef",
+	"nsw",
+	"nsz",
+	"null",
+	"nuw",
+	"oeq",
+	"oge",
+	"ogt",
+	"ole",
+	"olt",
+	"or",
+	"phi",
+	"private",
+	"ptr",
+	"ptrtoint",
+	"ret",
+	"sdiv",
+	"sext",
+	"sge",
+	"sgt",
+	"shl",
+	"sitofp",
+	"sle",
+	"slt",
+	"srem",
+	"store",
+	"sub",
+	"switch",
+	"target",
+	"to",
+	"triple",
+	"true",
+	"trunc",
+	"udiv",
+	"uge",
+	"ugt",
+	"uitofp",
+	"ule",
+	"ult",
+	"une",
+	"unnamed_addr",
+	"unreachable",
+	"urem",
+	"void",
+	"weak",
+	"weak_odr",
+	"x",
+	"xor",
+	"zeroinitializer",
+	"zext",
+};
+
+static_assert(std::size(keywordNames) == KeywordCount, "keywordNames must have one entry per Keyword");
+
+// Keywords are looked up in an open-addressed table built from keywordNames
+// The hash needs only the length and three characters, so a word is classified with one probe
+// and, nearly always, at most one string comparison
+class KeywordTable {
+	static constexpr size_t cap = 512;
+	Keyword slots[cap] = {};
+
+	static size_t hash(std::string_view s) {
+		return (s.size() * 37 + uint8_t(s[0]) * 5 + uint8_t(s[s.size() / 2]) * 131 + uint8_t(s.back()) * 17) & (cap - 1);
+	}
+
+public:
+	KeywordTable() {
+		for (size_t k = 1; k < KeywordCount; k++) {
+			auto i = hash(keywordNames[k]);
+			while (slots[i]) {
+				i = (i + 1) & (cap - 1);
+			}
+			slots[i] = Keyword(k);
+		}
+	}
+
+	Keyword operator()(std::string_view s) const {
+		if (s.empty()) {
+			return NoKeyword;
+		}
+		for (auto i = hash(s);; i = (i + 1) & (cap - 1)) {
+			auto k = slots[i];
+			if (!k || keywordNames[k] == s) {
+				return k;
+			}
+		}
+	}
+};
+
+static Keyword keyword(std::string_view s) {
+	static const KeywordTable table;
+	return table(s);
+}
+
+// Tokens do not own their text; they are views into the input, which must outlive them
+// so tokenizing a file makes no allocations beyond the token array itself
 struct Tok {
-	size_t line;
-	string s;
+	TokKind kind;
+	std::string_view s;
+
+	// For words, which keyword if any
+	Keyword kw;
 
-	Tok(size_t line, string s): line(line), s(s) {
+	Tok(TokKind kind, std::string_view s): kind(kind), s(s), kw(kind == Word ? keyword(s) : NoKeyword) {
 	}
 
-	bool operator==(string t) const {
+	bool operator==(std::string_view t) const {
 		return s == t;
 	}
 
-	bool operator!=(string t) const {
+	bool operator!=(std::string_view t) const {
 		return s != t;
 	}
 };
 
-class Tokenizer {
+// End is indicated by a token that cannot correspond to any actual token
+// but is still nonempty, so parsing code can safely check the first character of current token
+const Tok sentinel(End, " ");
+
+// The grammar is line oriented, so parts of the text can be skipped without lexing them
+// by scanning for lines that begin with particular characters
+
+// Skip to the start of the next line, counting the newlines passed
+// Quoted strings may contain newlines, and comments may contain quotes, so both must be recognized
+static size_t skipLine(std::string_view text, size_t i, size_t& line) {
+	for (;;) {
+		i = findByte(text, i, '\n', '"', ';');
+		if (i == text.size()) {
+			return i;
+		}
+		switch (text[i]) {
+		case '\n':
+			line++;
+			return i + 1;
+		case '"': {
+			auto j = findByte(text, i + 1, '"');
+			line += std::count(text.begin() + i, text.begin() + j, '\n');
+			i = std::min(j + 1, text.size());
+			break;
+		}
+		case ';':
+			i = findByte(text, i, '\n');
+			break;
+		}
+	}
+}
+
+// Given the start of the first line of a function body, return the position of the closing brace
+// which is the first character of the line that ends the body
+// or the end of the text, if there is no such line
+static size_t skipBody(std::string_view text, size_t i, size_t& line) {
+	while (i < text.size()) {
+		auto j = skipSpace(text, i);
+		if (j < text.size() && text[j] == '}') {
+			return j;
+		}
+		i = skipLine(text, j, line);
+	}
+	return i;
+}
+
+// Tokens are produced on demand, as the parser asks for them
+// so memory use is proportional to the lookahead, not the size of the file
+// and parsing starts without waiting for the whole file to be tokenized
+// The interface is that of queue<Tok>, so reading past the end returns the sentinel
+class Lexer {
 	string file;
-	string text;
+	std::string_view text;
 	size_t pos = 0;
-	size_t line = 1;
-	string tok;
-	queue<Tok>& toks;
+
+	// Only needed for error messages, as the parser works out the line of a token from its position
+	size_t line;
+
+	// Tokens lexed but not yet consumed
+	vector<Tok> toks;
+	size_t head = 0;
+
+	// Whether the end of the input has been reached, and the final newline if any supplied
+	bool done = false;
 
 	runtime_error error(string msg) const {
 		return runtime_error(file + ':' + to_string(line) + ": " + msg);
 	}
 
+	// The input is not guaranteed to be terminated
+	// so reading past the end yields a null character, which does not continue any token
+	char at(size_t i) const {
+		return i < text.size() ? text[i] : 0;
+	}
+
 	void quote1() {
 		ASSERT(text[pos] == '"');
-		for (auto i = pos + 1; i < text.size(); i++) {
-			if (text[i] == '"') {
-				i++;
-				tok += text.substr(pos, i - pos);
-				pos = i;
-				return;
-			}
+		auto i = findByte(text, pos + 1, '"');
+		if (i == text.size()) {
+			throw error("unclosed quote");
 		}
-		throw error("unclosed quote");
+		pos = i + 1;
 	}
 
 	void id() {
-		if (text[pos] == '"') {
+		if (at(pos) == '"') {
 			quote1();
 			return;
 		}
-		if (!isIdPart(text[pos])) {
+		if (!isIdPart(at(pos))) {
 			throw error("expected identifier");
 		}
-		while (isIdPart(text[pos])) {
-			tok += text[pos++];
-		}
+		pos = skipIdPart(text, pos);
 	}
 
-	void maybeColon() {
-		if (text[pos] == ':') {
-			tok += text[pos++];
+	bool maybeColon() {
+		if (at(pos) == ':') {
+			pos++;
+			return true;
 		}
+		return false;
 	}
 
-	void push() {
-		toks.push(Tok(line, tok));
+	void push(TokKind kind, size_t start) {
+		toks.push_back(Tok(kind, text.substr(start, pos - start)));
 	}
 
-public:
-	Tokenizer(string file, string text0, queue<Tok>& toks): file(file), text(text0), toks(toks) {
-		if (!endsWith(text, '\n')) {
-			text += '\n';
-		}
+	// Lex one more token, or set done if there are no more
+	void lex() {
 		while (pos < text.size()) {
-			if (containsAt(text, pos, "...")) {
-				tok = text.substr(pos, 3);
-				pos += 3;
-				push();
-				continue;
-			}
+			auto start = pos;
 			switch (text[pos]) {
 			case ' ':
 			case '\f':
 			case '\r':
 			case '\t':
-				pos++;
+				pos = skipSpace(text, pos + 1);
 				continue;
 			case '"':
-				tok.clear();
 				quote1();
-				maybeColon();
-				push();
-				continue;
+				push(maybeColon() ? LabelDef : String, start);
+				return;
 			case '$':
+				pos++;
+				id();
+				push(ComdatName, start);
+				return;
 			case '%':
+				pos++;
+				id();
+				push(LocalName, start);
+				return;
 			case '@':
-				tok = text.substr(pos++, 1);
+				pos++;
 				id();
-				push();
-				continue;
-			case ';':
-				while (text[pos] != '\n') {
-					pos++;
+				push(GlobalName, start);
+				return;
+			case '.':
+				if (text.compare(pos, 3, "...") == 0) {
+					pos += 3;
+					push(Punct, start);
+					return;
 				}
+				break;
+			case ';':
+				pos = findByte(text, pos, '\n');
 				continue;
 			case '\n':
-				tok = text.substr(pos++, 1);
-				push();
+				pos++;
+				push(Newline, start);
 				line++;
-				continue;
+				return;
 			case 'c':
-				if (text[pos + 1] == '"') {
-					tok = text.substr(pos++, 1);
+				if (at(pos + 1) == '"') {
+					pos++;
 					quote1();
-					push();
-					continue;
+					push(String, start);
+					return;
 				}
 				break;
 			}
 			if (isIdPart(text[pos])) {
-				tok.clear();
 				id();
-				maybeColon();
-				push();
-				continue;
+				push(maybeColon() ? LabelDef : Word, start);
+				return;
 			}
-			tok = text.substr(pos++, 1);
-			push();
+			pos++;
+			push(Punct, start);
+			return;
+		}
+
+		// The grammar is line oriented, so the last line must be terminated
+		done = true;
+		if (text.size() && text.back() != '\n') {
+			toks.push_back(Tok(Newline, "\n"));
 		}
 	}
-};
 
-// End is indicated by a token that cannot correspond to any actual token
-// but is still nonempty, so parsing code can safely check the first character of current token
-const string sentinel = " ";
+public:
+	// The text may be part of a file, beginning at the specified line
+	Lexer(string file, std::string_view text, size_t line): file(file), text(text), line(line) {
+	}
+
+	// SORT FUNCTIONS
+
+	const Tok& operator*() {
+		return (*this)[0];
+	}
+
+	const Tok* operator->() {
+		return &(*this)[0];
+	}
+
+	const Tok& operator[](size_t i) {
+		while (toks.size() - head <= i) {
+			if (done) {
+				return sentinel;
+			}
+			lex();
+		}
+		return toks[head + i];
+	}
+
+	Tok pop() {
+		auto tok = (*this)[0];
+		if (head < toks.size()) {
+			// Once everything buffered has been consumed, the buffer can be reused from the start
+			if (++head == toks.size()) {
+				toks.clear();
+				head = 0;
+			}
+		}
+		return tok;
+	}
+};
 
 class Parser {
 	string file;
-	queue<Tok> toks = Tok(0, sentinel);
+	std::string_view text;
+	Lexer toks;
+
+	Module* module = nullptr;
 
 	// SORT FUNCTIONS
 
@@ -326,7 +798,7 @@ class Parser {
 	}
 
 	void argAttrs() {
-		if (*toks == "noundef") {
+		if (toks->kw == NoundefKw) {
 			toks.pop();
 		}
 	}
@@ -343,8 +815,19 @@ class Parser {
 		return v;
 	}
 
+	vector<Inst> body1() {
+		vector<Inst> body;
+		while (*toks != "}") {
+			if (toks->kind != Newline) {
+				body.push_back(inst1());
+			}
+			nextLine();
+		}
+		return body;
+	}
+
 	Term call1() {
-		expect("call");
+		expect(CallKw);
 		auto rty = type();
 		auto ref = globalRef1();
 		auto args = args1();
@@ -362,7 +845,7 @@ class Parser {
 		[(unnamed_addr|local_unnamed_addr)] [align N] [gc]
 		[prefix Constant] [prologue Constant]
 		*/
-		expect("declare");
+		expect(DeclareKw);
 		linkage();
 
 		// The syntax in the documentation says declarations don't have a preemption specifier
@@ -392,7 +875,7 @@ class Parser {
 		[gc] [prefix Constant] [prologue Constant] [personality Constant]
 		(!name !N)* { ... }
 		*/
-		expect("define");
+		expect(DefineKw);
 		linkage();
 		preemption();
 
@@ -408,7 +891,7 @@ class Parser {
 
 		// Trailing tokens
 		while (*toks != "{") {
-			if (*toks == "\n" || *toks == sentinel) {
+			if (toks->kind == Newline || toks->kind == End) {
 				throw error("expected '{'");
 			}
 			toks.pop();
@@ -417,13 +900,7 @@ class Parser {
 		// Body
 		expect("{");
 		newline();
-		vector<Inst> body;
-		while (*toks != "}") {
-			if (*toks != "\n") {
-				body.push_back(inst1());
-			}
-			nextLine();
-		}
+		auto body = body1();
 		expect("}");
 
 		return Fn(rty, ref, params, body);
@@ -435,15 +912,15 @@ class Parser {
 
 		// Line
 		auto tok = *toks;
-		if (tok.line) {
-			s += to_string(tok.line);
-		} else {
+		if (tok.kind == End) {
 			s += "EOF";
+		} else {
+			s += to_string(line(tok));
 		}
 		s += ": ";
 
 		// Current token
-		s += quote(tok.s) + ": ";
+		s += quote(string(tok.s)) + ": ";
 
 		// Specific message
 		s += msg;
@@ -453,38 +930,44 @@ class Parser {
 		return runtime_error(s);
 	}
 
-	void expect(string s) {
+	void expect(std::string_view s) {
 		if (*toks == s) {
 			toks.pop();
 			return;
 		}
-		throw error("expected " + quote(s));
+		throw error("expected " + quote(string(s)));
+	}
+
+	void expect(Keyword k) {
+		if (toks->kw == k) {
+			toks.pop();
+			return;
+		}
+		throw error("expected " + quote(keywordNames[k]));
 	}
 
 	Term expr(Type ty) {
 		// SORT BLOCKS
-		if (*toks == "false") {
+		switch (toks->kw) {
+		case FalseKw:
 			if (ty != boolTy()) {
 				throw error("type mismatch");
 			}
 			toks.pop();
 			return falseConst;
-		}
-		if (*toks == "null") {
+		case NullKw:
 			if (ty != ptrTy()) {
 				throw error("type mismatch");
 			}
 			toks.pop();
 			return nullPtrConst;
-		}
-		if (*toks == "true") {
+		case TrueKw:
 			if (ty != boolTy()) {
 				throw error("type mismatch");
 			}
 			toks.pop();
 			return trueConst;
-		}
-		if (*toks == "zeroinitializer") {
+		case ZeroinitializerKw:
 			toks.pop();
 			return zeroVal(ty);
 		}
@@ -505,12 +988,12 @@ class Parser {
 		}
 		if (isDigit(tok[0]) || (tok[0] == '-' && tok.size() > 1 && isDigit(tok[1]))) {
 			if (isInt(ty)) {
-				auto a = intConst(ty, cpp_int(tok));
+				auto a = intConst(ty, parseInt(tok));
 				toks.pop();
 				return a;
 			}
 			if (isFloat(ty)) {
-				auto a = floatConst(ty, tok);
+				auto a = floatConst(ty, string(tok));
 				toks.pop();
 				return a;
 			}
@@ -520,7 +1003,7 @@ class Parser {
 	}
 
 	void fastMathFlags() {
-		while (*toks == "fast" || *toks == "nnan" || *toks == "ninf" || *toks == "nsz") {
+		while (toks->kw == FastKw || toks->kw == NnanKw || toks->kw == NinfKw || toks->kw == NszKw) {
 			toks.pop();
 		}
 	}
@@ -546,13 +1029,13 @@ class Parser {
 		linkage();
 		preemption();
 
-		if (*toks == "unnamed_addr" | *toks == "local_unnamed_addr") {
+		if (toks->kw == UnnamedAddrKw || toks->kw == LocalUnnamedAddrKw) {
 			toks.pop();
 		}
 
-		if (*toks == "global") {
+		if (toks->kw == GlobalKw) {
 			toks.pop();
-		} else if (*toks == "constant") {
+		} else if (toks->kw == ConstantKw) {
 			toks.pop();
 		} else {
 			throw error("expected 'global' or 'constant'");
@@ -564,22 +1047,23 @@ class Parser {
 	}
 
 	Ref globalRef1() {
-		if (toks->s[0] != '@') {
+		if (toks->kind != GlobalName) {
 			throw error("expected global name");
 		}
 		return ref1();
 	}
 
 	Inst inst1() {
-		if (toks->s.back() == ':') {
+		if (toks->kind == LabelDef) {
 			auto tok = toks->s;
 			return block(parseRef(tok.substr(0, tok.size() - 1)));
 		}
 
 		// SORT BLOCKS
-		if (*toks == "br") {
+		switch (toks->kw) {
+		case BrKw: {
 			toks.pop();
-			if (*toks == "label") {
+			if (toks->kw == LabelKw) {
 				return jmp(label1());
 			}
 			auto cond = typeExpr();
@@ -589,24 +1073,22 @@ class Parser {
 			auto no = label1();
 			return br(cond, yes, no);
 		}
-		if (*toks == "call") {
+		case CallKw:
 			return Inst(Drop, call1());
-		}
-		if (*toks == "ret") {
+		case RetKw:
 			toks.pop();
-			if (*toks == "void") {
+			if (toks->kw == VoidKw) {
 				return ret();
 			}
 			return ret(typeExpr());
-		}
-		if (*toks == "store") {
+		case StoreKw: {
 			toks.pop();
 			auto a = typeExpr();
 			expect(",");
 			auto p = ptrExpr();
 			return store(a, p);
 		}
-		if (*toks == "switch") {
+		case SwitchKw: {
 			toks.pop();
 			vector<Term> v;
 
@@ -630,32 +1112,33 @@ class Parser {
 
 			return Inst(Switch, v);
 		}
-		if (*toks == "unreachable") {
+		case UnreachableKw:
 			return unreachable();
 		}
-		if (toks->s[0] == '%') {
+		if (toks->kind == LocalName) {
 			auto lval = parseRef(toks->s);
 			toks.pop();
 			expect("=");
-			if (*toks == "alloca") {
+			switch (toks->kw) {
+			case AllocaKw: {
 				toks.pop();
 				auto ty = type();
 				auto n = intConst(1);
 				while (*toks == ",") {
 					toks.pop();
-					if (*toks == "align") {
+					if (toks->kw == AlignKw) {
 						toks.pop();
 						int1();
 						continue;
 					}
-					if (*toks == "addrspace") {
+					if (toks->kw == AddrspaceKw) {
 						throw error("multiple address spaces not supported");
 					}
 					n = typeExpr();
 				}
 				return alloca(var(ptrTy(), lval), ty, n);
 			}
-			if (*toks == "phi") {
+			case PhiKw: {
 				toks.pop();
 				fastMathFlags();
 				vector<Term> v;
@@ -675,6 +1158,7 @@ class Parser {
 
 				return Inst(Phi, v);
 			}
+			}
 			auto rval = rval1();
 			return assign(var(rval.ty(), lval), rval);
 		}
@@ -688,57 +1172,65 @@ class Parser {
 		if (!std::all_of(tok.begin(), tok.end(), isDigit)) {
 			throw error("expected integer");
 		}
-		auto n = stoull1(tok);
+		auto n = stoull1(string(tok));
 		toks.pop();
 		return n;
 	}
 
 	Term label1() {
-		expect("label");
-		if (toks->s[0] != '%') {
+		expect(LabelKw);
+		if (toks->kind != LocalName) {
 			throw error("expected label");
 		}
 		return label(ref1());
 	}
 
+	// Line number of a token, counted from its position in the input
+	// This only happens when reporting an error, so there is no need to record the line in every token
+	size_t line(const Tok& tok) const {
+		auto p = tok.s.data();
+		auto n = p < text.data() || text.data() + text.size() < p ? text.size() : p - text.data();
+		return 1 + std::count(text.begin(), text.begin() + n, '\n');
+	}
+
 	void linkage() {
-		if (*toks == "private") {
+		if (toks->kw == PrivateKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "internal") {
+		if (toks->kw == InternalKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "available_externally") {
+		if (toks->kw == AvailableExternallyKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "linkonce") {
+		if (toks->kw == LinkonceKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "weak") {
+		if (toks->kw == WeakKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "common") {
+		if (toks->kw == CommonKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "appending") {
+		if (toks->kw == AppendingKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "extern_weak") {
+		if (toks->kw == ExternWeakKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "linkonce_odr" || *toks == "weak_odr") {
+		if (toks->kw == LinkonceOdrKw || toks->kw == WeakOdrKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "external") {
+		if (toks->kw == ExternalKw) {
 			toks.pop();
 			return;
 		}
@@ -753,7 +1245,7 @@ class Parser {
 	}
 
 	void newline() {
-		if (*toks == "\n") {
+		if (toks->kind == Newline) {
 			toks.pop();
 			return;
 		}
@@ -761,8 +1253,8 @@ class Parser {
 	}
 
 	void nextLine() {
-		while (*toks != "\n") {
-			if (*toks == sentinel) {
+		while (toks->kind != Newline) {
+			if (toks->kind == End) {
 				stackTrace();
 				throw error("unexpected end of file");
 			}
@@ -772,10 +1264,10 @@ class Parser {
 	}
 
 	void noWrap() {
-		if (*toks == "nuw") {
+		if (toks->kw == NuwKw) {
 			toks.pop();
 		}
-		if (*toks == "nsw") {
+		if (toks->kw == NswKw) {
 			toks.pop();
 		}
 	}
@@ -789,7 +1281,7 @@ class Parser {
 		// <type> [parameter Attrs] [name]
 		auto ty = type();
 		paramAttrs();
-		if (toks->s[0] == '%') {
+		if (toks->kind == LocalName) {
 			return var1(ty);
 		}
 		return none(ty);
@@ -815,39 +1307,39 @@ class Parser {
 	}
 
 	void parse1() {
-		if (*toks == "target") {
+		if (toks->kw == TargetKw) {
 			target1();
 			return;
 		}
-		if (*toks == "declare") {
+		if (toks->kw == DeclareKw) {
 			module->decls.push_back(declare());
 			return;
 		}
-		if (*toks == "define") {
+		if (toks->kw == DefineKw) {
 			module->defs.push_back(define());
 			return;
 		}
-		if (toks->s[0] == '$') {
-			auto ref = unwrap(toks->s);
+		if (toks->kind == ComdatName) {
+			auto ref = nameRef(toks->s);
 			toks.pop();
 			expect("=");
-			expect("comdat");
-			expect("any");
+			expect(ComdatKw);
+			expect(AnyKw);
 			module->comdats.push_back(ref);
 			return;
 		}
-		if (toks->s[0] == '@') {
+		if (toks->kind == GlobalName) {
 			module->globals.push_back(global());
 			return;
 		}
 	}
 
 	void preemption() {
-		if (*toks == "dso_local") {
+		if (toks->kw == DsoLocalKw) {
 			toks.pop();
 			return;
 		}
-		if (*toks == "dso_preemptable") {
+		if (toks->kw == DsoPreemptableKw) {
 			toks.pop();
 			return;
 		}
@@ -859,7 +1351,7 @@ class Parser {
 		if (*toks == "<") {
 			toks.pop();
 			auto len = int1();
-			expect("x");
+			expect(XKw);
 			auto element = type();
 			expect(">");
 			return vecTy(len, element);
@@ -867,29 +1359,27 @@ class Parser {
 		if (*toks == "[") {
 			toks.pop();
 			auto len = int1();
-			expect("x");
+			expect(XKw);
 			auto element = type();
 			expect("]");
 			return arrayTy(len, element);
 		}
-		if (*toks == "double") {
+		switch (toks->kw) {
+		case DoubleKw:
 			toks.pop();
 			return doubleTy();
-		}
-		if (*toks == "float") {
+		case FloatKw:
 			toks.pop();
 			return floatTy();
-		}
-		if (*toks == "ptr") {
+		case PtrKw:
 			toks.pop();
 			return ptrTy();
-		}
-		if (*toks == "void") {
+		case VoidKw:
 			toks.pop();
 			return voidTy();
 		}
 		if (toks->s[0] == 'i') {
-			auto len = stoull1(toks->s.substr(1));
+			auto len = stoull1(string(toks->s.substr(1)));
 			toks.pop();
 			return intTy(len);
 		}
@@ -899,7 +1389,7 @@ class Parser {
 	}
 
 	Term ptrExpr() {
-		expect("ptr");
+		expect(PtrKw);
 		return expr(ptrTy());
 	}
 
@@ -911,7 +1401,8 @@ class Parser {
 
 	Term rval1() {
 		// SORT BLOCKS
-		if (*toks == "add") {
+		switch (toks->kw) {
+		case AddKw: {
 			toks.pop();
 			noWrap();
 			auto ty = type();
@@ -920,7 +1411,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Add, ty, a, b);
 		}
-		if (*toks == "and") {
+		case AndKw: {
 			toks.pop();
 			auto ty = type();
 			auto a = expr(ty);
@@ -928,9 +1419,9 @@ class Parser {
 			auto b = expr(ty);
 			return Term(And, ty, a, b);
 		}
-		if (*toks == "ashr") {
+		case AshrKw: {
 			toks.pop();
-			if (*toks == "exact") {
+			if (toks->kw == ExactKw) {
 				toks.pop();
 			}
 			auto ty = type();
@@ -939,10 +1430,9 @@ class Parser {
 			auto b = expr(ty);
 			return Term(AShr, ty, a, b);
 		}
-		if (*toks == "call") {
+		case CallKw:
 			return call1();
-		}
-		if (*toks == "fadd") {
+		case FaddKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
@@ -951,10 +1441,11 @@ class Parser {
 			auto b = expr(ty);
 			return Term(FAdd, ty, a, b);
 		}
-		if (*toks == "fcmp") {
+		case FcmpKw:
 			toks.pop();
 			fastMathFlags();
-			if (*toks == "oeq") {
+			switch (toks->kw) {
+			case OeqKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -962,7 +1453,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(FEq, a, b);
 			}
-			if (*toks == "ogt") {
+			case OgtKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -970,7 +1461,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(FLt, b, a);
 			}
-			if (*toks == "oge") {
+			case OgeKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -978,7 +1469,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(FLe, b, a);
 			}
-			if (*toks == "olt") {
+			case OltKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -986,7 +1477,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(FLt, a, b);
 			}
-			if (*toks == "ole") {
+			case OleKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -994,7 +1485,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(FLe, a, b);
 			}
-			if (*toks == "ugt") {
+			case UgtKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1002,7 +1493,7 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(FLe, a, b));
 			}
-			if (*toks == "uge") {
+			case UgeKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1010,7 +1501,7 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(FLt, a, b));
 			}
-			if (*toks == "ult") {
+			case UltKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1018,7 +1509,7 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(FLe, b, a));
 			}
-			if (*toks == "ule") {
+			case UleKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1026,7 +1517,7 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(FLt, b, a));
 			}
-			if (*toks == "une") {
+			case UneKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1034,9 +1525,9 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(FEq, b, a));
 			}
+			}
 			throw error("expected condition");
-		}
-		if (*toks == "fdiv") {
+		case FdivKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
@@ -1045,7 +1536,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(FDiv, ty, a, b);
 		}
-		if (*toks == "fmul") {
+		case FmulKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
@@ -1054,14 +1545,14 @@ class Parser {
 			auto b = expr(ty);
 			return Term(FMul, ty, a, b);
 		}
-		if (*toks == "fneg") {
+		case FnegKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
 			auto a = expr(ty);
 			return Term(FNeg, ty, a);
 		}
-		if (*toks == "frem") {
+		case FremKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
@@ -1070,7 +1561,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(FRem, ty, a, b);
 		}
-		if (*toks == "fsub") {
+		case FsubKw: {
 			toks.pop();
 			fastMathFlags();
 			auto ty = type();
@@ -1079,9 +1570,9 @@ class Parser {
 			auto b = expr(ty);
 			return Term(FSub, ty, a, b);
 		}
-		if (*toks == "getelementptr") {
+		case GetelementptrKw: {
 			toks.pop();
-			if (*toks == "inbounds") {
+			if (toks->kw == InboundsKw) {
 				toks.pop();
 			}
 			auto ty = type();
@@ -1094,9 +1585,10 @@ class Parser {
 			} while (maybeComma());
 			return getElementPtr(ty, p, idxs);
 		}
-		if (*toks == "icmp") {
+		case IcmpKw:
 			toks.pop();
-			if (*toks == "eq") {
+			switch (toks->kw) {
+			case EqKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1104,7 +1596,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(Eq, a, b);
 			}
-			if (*toks == "ne") {
+			case NeKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1112,7 +1604,7 @@ class Parser {
 				auto b = expr(ty);
 				return not1(cmp(Eq, b, a));
 			}
-			if (*toks == "ugt") {
+			case UgtKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1120,7 +1612,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(ULt, b, a);
 			}
-			if (*toks == "uge") {
+			case UgeKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1128,7 +1620,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(ULe, b, a);
 			}
-			if (*toks == "ult") {
+			case UltKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1136,7 +1628,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(ULt, a, b);
 			}
-			if (*toks == "ule") {
+			case UleKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1144,7 +1636,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(ULe, a, b);
 			}
-			if (*toks == "sgt") {
+			case SgtKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1152,7 +1644,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(SLt, b, a);
 			}
-			if (*toks == "sge") {
+			case SgeKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1160,7 +1652,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(SLe, b, a);
 			}
-			if (*toks == "slt") {
+			case SltKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1168,7 +1660,7 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(SLt, a, b);
 			}
-			if (*toks == "sle") {
+			case SleKw: {
 				toks.pop();
 				auto ty = type();
 				auto a = expr(ty);
@@ -1176,18 +1668,18 @@ class Parser {
 				auto b = expr(ty);
 				return cmp(SLe, a, b);
 			}
+			}
 			throw error("expected condition");
-		}
-		if (*toks == "load") {
+		case LoadKw: {
 			toks.pop();
 			auto ty = type();
 			expect(",");
 			auto a = ptrExpr();
 			return Term(Load, ty, a);
 		}
-		if (*toks == "lshr") {
+		case LshrKw: {
 			toks.pop();
-			if (*toks == "exact") {
+			if (toks->kw == ExactKw) {
 				toks.pop();
 			}
 			auto ty = type();
@@ -1196,7 +1688,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(LShr, ty, a, b);
 		}
-		if (*toks == "mul") {
+		case MulKw: {
 			toks.pop();
 			noWrap();
 			auto ty = type();
@@ -1205,7 +1697,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Mul, ty, a, b);
 		}
-		if (*toks == "or") {
+		case OrKw: {
 			toks.pop();
 			auto ty = type();
 			auto a = expr(ty);
@@ -1213,9 +1705,9 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Or, ty, a, b);
 		}
-		if (*toks == "sdiv") {
+		case SdivKw: {
 			toks.pop();
-			if (*toks == "exact") {
+			if (toks->kw == ExactKw) {
 				toks.pop();
 			}
 			auto ty = type();
@@ -1224,14 +1716,16 @@ class Parser {
 			auto b = expr(ty);
 			return Term(SDiv, ty, a, b);
 		}
-		if (*toks == "sext" || *toks == "fptosi" || *toks == "sitofp") {
+		case SextKw:
+		case FptosiKw:
+		case SitofpKw: {
 			toks.pop();
 			auto a = typeExpr();
-			expect("to");
+			expect(ToKw);
 			auto ty = type();
 			return Term(SCast, ty, a);
 		}
-		if (*toks == "shl") {
+		case ShlKw: {
 			toks.pop();
 			noWrap();
 			auto ty = type();
@@ -1240,7 +1734,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Shl, ty, a, b);
 		}
-		if (*toks == "srem") {
+		case SremKw: {
 			toks.pop();
 			auto ty = type();
 			auto a = expr(ty);
@@ -1248,7 +1742,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(SRem, ty, a, b);
 		}
-		if (*toks == "sub") {
+		case SubKw: {
 			toks.pop();
 			noWrap();
 			auto ty = type();
@@ -1257,17 +1751,24 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Sub, ty, a, b);
 		}
-		if (*toks == "trunc" || *toks == "zext" || *toks == "fptrunc" || *toks == "fpext" || *toks == "fptoui" ||
-			*toks == "uitofp" || *toks == "ptrtoint" || *toks == "inttoptr" || *toks == "bitcast") {
+		case TruncKw:
+		case ZextKw:
+		case FptruncKw:
+		case FpextKw:
+		case FptouiKw:
+		case UitofpKw:
+		case PtrtointKw:
+		case InttoptrKw:
+		case BitcastKw: {
 			toks.pop();
 			auto a = typeExpr();
-			expect("to");
+			expect(ToKw);
 			auto ty = type();
 			return Term(Cast, ty, a);
 		}
-		if (*toks == "udiv") {
+		case UdivKw: {
 			toks.pop();
-			if (*toks == "exact") {
+			if (toks->kw == ExactKw) {
 				toks.pop();
 			}
 			auto ty = type();
@@ -1276,7 +1777,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(UDiv, ty, a, b);
 		}
-		if (*toks == "urem") {
+		case UremKw: {
 			toks.pop();
 			auto ty = type();
 			auto a = expr(ty);
@@ -1284,7 +1785,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(URem, ty, a, b);
 		}
-		if (*toks == "xor") {
+		case XorKw: {
 			toks.pop();
 			auto ty = type();
 			auto a = expr(ty);
@@ -1292,6 +1793,7 @@ class Parser {
 			auto b = expr(ty);
 			return Term(Xor, ty, a, b);
 		}
+		}
 		// END
 
 		throw error("expected rval");
@@ -1306,8 +1808,8 @@ class Parser {
 	}
 
 	void target1() {
-		expect("target");
-		if (*toks == "datalayout") {
+		expect(TargetKw);
+		if (toks->kw == DatalayoutKw) {
 			toks.pop();
 			expect("=");
 			auto tok = toks->s;
@@ -1317,7 +1819,7 @@ class Parser {
 			module->datalayout = unwrap(tok);
 			return;
 		}
-		if (*toks == "triple") {
+		if (toks->kw == TripleKw) {
 			toks.pop();
 			expect("=");
 			auto tok = toks->s;
@@ -1339,30 +1841,98 @@ class Parser {
 	}
 
 	Term var1(Type ty) {
-		if (toks->s[0] != '%') {
+		if (toks->kind != LocalName) {
 			throw error("expected variable name");
 		}
 		return var(ty, ref1());
 	}
 
 public:
-	Module* module = new Module;
+	// Parse a part of the text, beginning at the specified line
+	// Line numbers in error messages are counted from the start of the whole text
+	Parser(string file, std::string_view text, std::string_view part, size_t line)
+		: file(file), text(text), toks(file, part, line) {
+	}
 
-	Parser(string file, string text): file(file) {
-		Tokenizer tokenizer(file, text, toks);
-		while (*toks != sentinel) {
+	// Top-level entities, to the end of the part
+	Module* parseModule() {
+		module = new Module;
+		while (toks->kind != End) {
 			parse1();
 			nextLine();
 		}
+		return module;
 	}
 };
 
-Module* parse(string text) {
-	Parser parser("nameless.ll", text);
-	return parser.module;
+// Part of a file that can be parsed independently of the rest
+struct Part {
+	std::string_view text;
+
+	// Line number of the first line of the part
+	size_t line;
+};
+
+// Split the text into parts of at least the specified size, except for the last
+// Each part consists of whole top-level entities: global variables, declarations, definitions, attribute groups, metadata etc.
+// The grammar is line oriented, so this needs only a light scan, that keeps track of quoted strings and comments
+// and of whether the current line is in a function body, which ends with a line beginning with '}'
+static vector<Part> split(std::string_view text, size_t size) {
+	vector<Part> parts;
+	size_t begin = 0;
+	size_t beginLine = 1;
+	size_t line = 1;
+	size_t i = 0;
+	while (i < text.size()) {
+		if (i - begin >= size) {
+			parts.push_back({text.substr(begin, i - begin), beginLine});
+			begin = i;
+			beginLine = line;
+		}
+		auto j = skipSpace(text, i);
+		if (text.compare(j, 6, "define") == 0 && !(j + 6 < text.size() && isIdPart(text[j + 6]))) {
+			j = skipLine(text, j, line);
+			j = skipBody(text, j, line);
+		}
+		i = skipLine(text, j, line);
+	}
+	parts.push_back({text.substr(begin), beginLine});
+	return parts;
 }
 
-Module* parse(string file, string text) {
-	Parser parser(file, text);
-	return parser.module;
+Module* parse(std::string_view text) {
+	return parse("nameless.ll", text);
+}
+
+Module* parse(string file, std::string_view text, size_t threads) {
+	if (threads <= 1) {
+		Parser parser(file, text, text, 1);
+		return parser.parseModule();
+	}
+
+	// Several parts per thread, so that threads given parts that take less time to parse can go on to others
+	// but not so small that the per-part overhead is significant
+	auto parts = split(text, std::max(text.size() / (threads * 8), size_t(1) << 16));
+	vector<std::unique_ptr<Module>> pieces(parts.size());
+	parallelFor(parts.size(), threads, [&](size_t i) {
+		Parser parser(file, text, parts[i].text, parts[i].line);
+		pieces[i].reset(parser.parseModule());
+	});
+
+	// Reassemble in order of appearance in the text
+	auto module = new Module;
+	for (auto& piece : pieces) {
+		if (piece->datalayout.size()) {
+			module->datalayout = piece->datalayout;
+		}
+		if (piece->triple.size()) {
+			module->triple = piece->triple;
+		}
+		module->comdats.insert(module->comdats.end(), piece->comdats.begin(), piece->comdats.end());
+		module->globals.insert(module->globals.end(), piece->globals.begin(), piece->globals.end());
+		module->decls.insert(module->decls.end(), piece->decls.begin(), piece->decls.end());
+		module->defs.insert(module->defs.end(), piece->defs.begin(), piece->defs.end());
+		module->externals.insert(piece->externals.begin(), piece->externals.end());
+	}
+	return module;
 }
@@ -21,10 +21,10 @@ bool endsWith(string s, int c);
 // Hexadecimal digits are classified by the function isXDigit
 // Stops when it reaches the end of the string, or a character that is not a hexadecimal digit, or it has parsed maxLen digits
 // At least one hexadecimal digit must be present, or an exception is thrown
-unsigned parseHex(string s, size_t& pos, int maxLen = 8);
+unsigned parseHex(std::string_view s, size_t& pos, int maxLen = 8);
 
 // Remove the leading sigil from an LLVM identifier or string, if there is one
-string removeSigil(string s);
+std::string_view removeSigil(std::string_view s);
 
 // Unwrap an LLVM identifier or string
 // Remove the leading sigil if any
@@ -33,13 +33,21 @@ string removeSigil(string s);
 // The LLVM language manual doesn't say exactly what escape sequences are valid
 // Testing what the LLVM parser actually accepts, it seems to be just \ or two hex digits
 // Otherwise, the first \ is just treated as an ordinary character
-string unwrap(string s);
+string unwrap(std::string_view s);
 
 // Parse an LLVM identifier or string to a reference containing index number or string as appropriate
 // after removing the leading sigil if there is one
 // Correctly distinguishes between %9 and %"9"
-Ref parseRef(string s);
+Ref parseRef(std::string_view s);
+
+// Parse a decimal or hexadecimal integer literal, which may be negative
+// Literals that fit in 64 bits, which is nearly all of them, are parsed with native arithmetic
+// as cpp_int parses strings much more slowly
+Integer parseInt(std::string_view s);
 
 // Parser for LLVM `.ll` format
-Module* parse(string text);
-Module* parse(string file, string text);
+// The text need only remain valid during the call, as nothing in the resulting module refers to it
+// With more than one thread, the text is split at top-level entity boundaries, and the parts parsed concurrently
+// which gives the same module, and the same error for invalid input, as parsing it on one thread
+Module* parse(std::string_view text);
+Module* parse(string file, std::string_view text, size_t threads = 1);
@@ -1,311 +1,382 @@
 #include "all.h"
 
-string wrap(string s) {
+namespace {
+// Can the string be used as an unquoted LLVM identifier?
+bool plain(const string& s) {
 	// Empty string needs quotes
 	if (s.empty()) {
-		return "\"\"";
+		return false;
 	}
 
-	// Check if the string can be used as an unquoted identifier
-	bool needsQuotes = false;
-
 	// First character has stricter rules - must be a letter, _, or .
 	if (!isAlpha(s[0]) && s[0] != '_' && s[0] != '.') {
-		needsQuotes = true;
-	} else {
-		// Check remaining characters
-		for (size_t i = 1; i < s.size(); i++) {
-			if (!isIdPart(s[i])) {
-				needsQuotes = true;
-				break;
-			}
-		}
-	}
-
-	// If it's a valid unquoted identifier, return as is
-	if (!needsQuotes) {
-		return s;
+		return false;
 	}
 
-	// Need to wrap in quotes and handle special characters
-	string result = "\"";
-	for (char c : s) {
-		if (c == '\"' || c < 32 || c > 126) {
-			// Quotes and non-printable characters get hex escape
-			char hex[3];
-			snprintf(hex, sizeof(hex), "%02x", (unsigned char)c);
-			result += '\\';
-			result += hex;
-		} else if (c == '\\') {
-			// Single backslashes remain as backslashes
-			result += "\\\\";
-		} else {
-			// Normal characters added as-is
-			result += c;
+	// Check remaining characters
+	for (size_t i = 1; i < s.size(); i++) {
+		if (!isIdPart(s[i])) {
+			return false;
 		}
 	}
-	result += '\"';
-	return result;
+	return true;
 }
 
-string wrap(const Ref& ref) {
-	if (ref.numeric()) {
-		return to_string(ref.num());
-	}
-	return wrap(ref.str());
+void appendNum(string& s, size_t n) {
+	char v[24];
+	auto r = std::to_chars(v, v + sizeof v, n);
+	s.append(v, r.ptr);
 }
 
-ostream& operator<<(ostream& os, Type ty) {
+// Spelling of a type in LLVM format, built from the cached spellings of its components
+const string& spelling(Type ty);
+
+string spell(Type ty) {
+	string s;
 #if defined(__GNUC__) || defined(__clang__)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic warning "-Wswitch"
 #endif
 	switch (ty.kind()) {
 	case ArrayKind:
-		os << '[' << ty.len() << " x " << ty[0] << ']';
+		s += '[';
+		appendNum(s, ty.len());
+		s += " x ";
+		s += spelling(ty[0]);
+		s += ']';
 		break;
 	case DoubleKind:
-		os << "double";
+		s = "double";
 		break;
 	case FloatKind:
-		os << "float";
+		s = "float";
 		break;
 	case FuncKind:
-		os << ty[0] << " (";
+		s += spelling(ty[0]);
+		s += " (";
 		for (size_t i = 1; i < ty.size(); i++) {
 			if (i > 1) {
-				os << ", ";
+				s += ", ";
 			}
-			os << ty[i];
+			s += spelling(ty[i]);
 		}
-		os << ')';
+		s += ')';
 		break;
 	case IntKind:
-		os << 'i' << ty.len();
+		s += 'i';
+		appendNum(s, ty.len());
 		break;
 	case PtrKind:
-		os << "ptr";
+		s = "ptr";
 		break;
 	case StructKind:
-		os << '{';
+		s += '{';
 		for (size_t i = 0; i < ty.size(); i++) {
 			if (i) {
-				os << ", ";
+				s += ", ";
 			}
-			os << ty[i];
+			s += spelling(ty[i]);
 		}
-		os << '}';
+		s += '}';
 		break;
 	case VecKind:
-		os << '<' << ty.len() << " x " << ty[0] << '>';
+		s += '<';
+		appendNum(s, ty.len());
+		s += " x ";
+		s += spelling(ty[0]);
+		s += '>';
 		break;
 	case VoidKind:
-		os << "void";
+		s = "void";
 		break;
 	}
-	return os;
+	return s;
 #if defined(__GNUC__) || defined(__clang__)
 #pragma GCC diagnostic pop
 #endif
 }
 
-ostream& operator<<(ostream& os, Tag tag) {
+const string& spelling(Type ty) {
+	auto s = ty.spelling();
+	if (!s) {
+		s = ty.setSpelling(new string(spell(ty)));
+	}
+	return *s;
+}
+} // namespace
+
+string wrap(string s) {
+	if (plain(s)) {
+		return s;
+	}
+
+	// Need to wrap in quotes and handle special characters
+	string result = "\"";
+	for (char c : s) {
+		if (c == '\"' || c < 32 || c > 126) {
+			// Quotes and non-printable characters get hex escape
+			char hex[3];
+			snprintf(hex, sizeof(hex), "%02x", (unsigned char)c);
+			result += '\\';
+			result += hex;
+		} else if (c == '\\') {
+			// Single backslashes remain as backslashes
+			result += "\\\\";
+		} else {
+			// Normal characters added as-is
+			result += c;
+		}
+	}
+	result += '\"';
+	return result;
+}
+
+string wrap(const Ref& ref) {
+	if (ref.numeric()) {
+		return to_string(ref.num());
+	}
+	return wrap(ref.str());
+}
+
+void Writer::flush() {
+	if (!os) {
+		return;
+	}
+	os->write(buf.data(), buf.size());
+	buf.clear();
+}
+
+Writer& Writer::operator<<(size_t n) {
+	appendNum(buf, n);
+	reserve();
+	return *this;
+}
+
+Writer& Writer::operator<<(const Integer& a) {
+	if (a.isSmall()) {
+		char v[24];
+		auto r = std::to_chars(v, v + sizeof v, a.toSmall());
+		buf.append(v, r.ptr);
+		reserve();
+		return *this;
+	}
+	return *this << a.toCppInt().str();
+}
+
+Writer& Writer::operator<<(const Ref& ref) {
+	if (ref.numeric()) {
+		return *this << ref.num();
+	}
+
+	// Nearly all names can be written as they are, without making a copy
+	auto& s = ref.str();
+	if (plain(s)) {
+		return *this << s;
+	}
+	return *this << wrap(s);
+}
+
+Writer& Writer::operator<<(Type ty) {
+	return *this << spelling(ty);
+}
+
+Writer& Writer::operator<<(Tag tag) {
 	switch (tag) {
 	// Arithmetic operations
 	case Add:
-		return os << "add";
+		return *this << "add";
 	case Mul:
-		return os << "mul";
+		return *this << "mul";
 	case SDiv:
-		return os << "sdiv";
+		return *this << "sdiv";
 	case SRem:
-		return os << "srem";
+		return *this << "srem";
 	case Sub:
-		return os << "sub";
+		return *this << "sub";
 	case UDiv:
-		return os << "udiv";
+		return *this << "udiv";
 	case URem:
-		return os << "urem";
+		return *this << "urem";
 
 	// Floating point operations
 	case FAdd:
-		return os << "fadd";
+		return *this << "fadd";
 	case FDiv:
-		return os << "fdiv";
+		return *this << "fdiv";
 	case FMul:
-		return os << "fmul";
+		return *this << "fmul";
 	case FNeg:
-		return os << "fneg";
+		return *this << "fneg";
 	case FRem:
-		return os << "frem";
+		return *this << "frem";
 	case FSub:
-		return os << "fsub";
+		return *this << "fsub";
 
 	// Bitwise operations
 	case AShr:
-		return os << "ashr";
+		return *this << "ashr";
 	case And:
-		return os << "and";
+		return *this << "and";
 	case LShr:
-		return os << "lshr";
+		return *this << "lshr";
 	case Or:
-		return os << "or";
+		return *this << "or";
 	case Shl:
-		return os << "shl";
+		return *this << "shl";
 	case Xor:
-		return os << "xor";
+		return *this << "xor";
 
 	// Integer comparisons
 	case Eq:
-		return os << "icmp eq";
+		return *this << "icmp eq";
 	case SLe:
-		return os << "icmp sle";
+		return *this << "icmp sle";
 	case SLt:
-		return os << "icmp slt";
+		return *this << "icmp slt";
 	case ULe:
-		return os << "icmp ule";
+		return *this << "icmp ule";
 	case ULt:
-		return os << "icmp ult";
+		return *this << "icmp ult";
 
 	// Floating point comparisons
 	case FEq:
-		return os << "fcmp oeq";
+		return *this << "fcmp oeq";
 	case FLe:
-		return os << "fcmp ole";
+		return *this << "fcmp ole";
 	case FLt:
-		return os << "fcmp olt";
+		return *this << "fcmp olt";
 
 	// Logical operations
 	case Not:
-		return os << "not";
+		return *this << "not";
 
 	// Conversion operations
 	case Cast:
-		return os << "bitcast";
+		return *this << "bitcast";
 	case SCast:
-		return os << "sext";
+		return *this << "sext";
 
 	// Memory operations
 	case ElementPtr:
-		return os << "getelementptr";
+		return *this << "getelementptr";
 	case FieldPtr:
-		return os << "getelementptr";
+		return *this << "getelementptr";
 	case Load:
-		return os << "load";
+		return *this << "load";
 
 	// Reference types
 	case GlobalRef:
-		return os << "global";
+		return *this << "global";
 	case Label:
-		return os << "label";
+		return *this << "label";
 	case NullPtr:
-		return os << "null";
+		return *this << "null";
 	case Var:
-		return os << "var";
+		return *this << "var";
 
 	// Compound types
 	case Array:
-		return os << "array";
+		return *this << "array";
 	case Tuple:
-		return os << "struct";
+		return *this << "struct";
 	case Vec:
-		return os << "vector";
+		return *this << "vector";
 
 	// Constants
 	case Float:
-		return os << "float";
+		return *this << "float";
 	case Int:
-		return os << "i";
+		return *this << "i";
 
 	// Function-related
 	case Call:
-		return os << "call";
+		return *this << "call";
 
 	// Default case for any unhandled tags
 	default:
-		return os << "unknown_tag";
+		return *this << "unknown_tag";
 	}
 }
 
-ostream& operator<<(ostream& os, Term a) {
+Writer& Writer::operator<<(Term a) {
 	// Handle special cases first
 	switch (a.tag()) {
 	case Array:
-		os << '[';
+		*this << '[';
 		for (size_t i = 0; i < a.size(); ++i) {
 			if (i) {
-				os << ", ";
+				*this << ", ";
 			}
-			os << a[i].ty() << " " << a[i];
+			*this << a[i].ty() << " " << a[i];
 		}
-		os << ']';
-		return os;
+		*this << ']';
+		return *this;
 	case Call: {
 		// Format: call returnType (functionType function)(args...)
 		// Example: call i32 (i32, i32)* @sum(i32 %x, i32 %y)
-		os << "call " << a.ty() << " ";
+		*this << "call " << a.ty() << " ";
 
 		// Print the function operand (first operand)
 		Term func = a[0];
-		os << func;
+		*this << func;
 
 		// Print remaining operands (arguments) in parentheses
-		os << "(";
+		*this << "(";
 		for (size_t i = 1; i < a.size(); ++i) {
 			if (i > 1) {
-				os << ", ";
+				*this << ", ";
 			}
-			os << a[i].ty() << " " << a[i];
+			*this << a[i].ty() << " " << a[i];
 		}
-		os << ")";
-		return os;
+		*this << ")";
+		return *this;
 	}
 	case Float:
-		os << a.str();
-		return os;
+		*this << a.ref().str();
+		return *this;
 	case GlobalRef:
-		os << '@' << a.ref();
-		return os;
+		*this << '@' << a.ref();
+		return *this;
 	case Int:
 		if (a.ty() == boolTy()) {
-			os << (a.intVal() ? "true" : "false");
-			return os;
+			*this << (a.intVal() ? "true" : "false");
+			return *this;
 		}
-		os << a.intVal();
-		return os;
+		*this << a.intVal();
+		return *this;
 	case Label:
 	case Var:
-		os << '%' << a.ref();
-		return os;
+		*this << '%' << a.ref();
+		return *this;
 	case NullPtr:
-		os << "null";
-		return os;
+		*this << "null";
+		return *this;
 	}
 
 	// For compound expressions, we need to print in LLVM constant expression format
 	// Format: op (type operand1, operand2, ...)
-	os << a.tag() << " (";
+	*this << a.tag() << " (";
 
 	// Print all operands
 	for (size_t i = 0; i < a.size(); ++i) {
 		if (i) {
-			os << ", ";
+			*this << ", ";
 		}
-		os << a[i].ty() << " " << a[i];
+		*this << a[i].ty() << " " << a[i];
 	}
 
-	os << ")";
-	return os;
+	*this << ")";
+	return *this;
 }
 
-ostream& operator<<(ostream& os, Inst inst) {
+Writer& Writer::operator<<(Inst inst) {
 	// Handle empty instructions
 	if (!inst.size()) {
 		switch (inst.opcode()) {
 		case RetVoid:
-			return os << "ret void";
+			return *this << "ret void";
 		case Unreachable:
-			return os << "unreachable";
+			return *this << "unreachable";
 		default:
 			ASSERT(false && "Invalid empty instruction");
 		}
@@ -315,12 +386,12 @@ ostream& operator<<(ostream& os, Inst inst) {
 	case Alloca: {
 		// Format: %var = alloca type, i32 count
 		ASSERT(inst.size() == 3);
-		os << inst[0] << " = alloca " << inst[1].ty();
+		*this << inst[0] << " = alloca " << inst[1].ty();
 		auto n = inst[2];
 		if (n.tag() == Int && n.intVal() == 1) {
 			break;
 		}
-		os << ", " << n.ty() << ' ' << n;
+		*this << ", " << n.ty() << ' ' << n;
 		break;
 	}
 	case Assign: {
@@ -329,7 +400,7 @@ ostream& operator<<(ostream& os, Inst inst) {
 		Term lhs = inst[0];
 		Term rhs = inst[1];
 
-		os << lhs << " = ";
+		*this << lhs << " = ";
 
 		// Handle different expression types with their specific syntax
 		if (rhs.size() > 0) {
@@ -349,18 +420,18 @@ ostream& operator<<(ostream& os, Inst inst) {
 			case Xor:
 				// Format: <op> <type> <operand1>, <operand2>
 				ASSERT(rhs.size() == 2);
-				os << rhs.tag() << " " << rhs.ty() << " " << rhs[0] << ", " << rhs[1];
+				*this << rhs.tag() << " " << rhs.ty() << " " << rhs[0] << ", " << rhs[1];
 				break;
 			case Call:
 				// Format: call <return-type> <function>(<args...>)
-				os << "call " << rhs.ty() << " " << rhs[0] << "(";
+				*this << "call " << rhs.ty() << " " << rhs[0] << "(";
 				for (size_t i = 1; i < rhs.size(); ++i) {
 					if (i > 1) {
-						os << ", ";
+						*this << ", ";
 					}
-					os << rhs[i].ty() << " " << rhs[i];
+					*this << rhs[i].ty() << " " << rhs[i];
 				}
-				os << ")";
+				*this << ")";
 				break;
 			case Cast:
 			case SCast:
@@ -373,52 +444,57 @@ ostream& operator<<(ostream& os, Inst inst) {
 					if (isInt(rhs[0].ty()) && isInt(rhs.ty())) {
 						// Integer to integer bitcast
 						if (rhs[0].ty().len() < rhs.ty().len()) {
-							os << "zext "; // Zero extension for unsigned
+							*this << "zext "; // Zero extension for unsigned
 						} else if (rhs[0].ty().len() > rhs.ty().len()) {
-							os << "trunc "; // Truncation
+							*this << "trunc "; // Truncation
 						} else {
-							os << "bitcast "; // Same-size conversion
+							*this << "bitcast "; // Same-size conversion
 						}
 					} else if (isFloat(rhs[0].ty()) && isInt(rhs.ty())) {
-						os << "fptosi "; // Float to signed integer
+						*this << "fptosi "; // Float to signed integer
 					} else if (isInt(rhs[0].ty()) && isFloat(rhs.ty())) {
-						os << "sitofp "; // Signed integer to float
+						*this << "sitofp "; // Signed integer to float
 					} else if (rhs[0].ty().kind() == PtrKind && isInt(rhs.ty())) {
-						os << "ptrtoint "; // Pointer to integer
+						*this << "ptrtoint "; // Pointer to integer
 					} else if (isInt(rhs[0].ty()) && rhs.ty().kind() == PtrKind) {
-						os << "inttoptr "; // Integer to pointer
+						*this << "inttoptr "; // Integer to pointer
 					} else {
-						os << "bitcast "; // Default to bitcast for other cases
+						*this << "bitcast "; // Default to bitcast for other cases
 					}
 				} else { // SCast
 					// Handle signed cast operations
 					if (isInt(rhs[0].ty()) && isInt(rhs.ty())) {
 						if (rhs[0].ty().len() < rhs.ty().len()) {
-							os << "sext "; // Sign extension
+							*this << "sext "; // Sign extension
 						} else if (rhs[0].ty().len() > rhs.ty().len()) {
-							os << "trunc "; // Truncation (same as unsigned)
+							*this << "trunc "; // Truncation (same as unsigned)
 						} else {
-							os << "bitcast "; // Same-size conversion
+							*this << "bitcast "; // Same-size conversion
 						}
 					} else {
 						// For other cases, default to appropriate conversions
-						os << "bitcast ";
+						*this << "bitcast ";
 					}
 				}
 
-				os << rhs[0].ty() << " " << rhs[0] << " to " << rhs.ty();
+				*this << rhs[0].ty() << " " << rhs[0] << " to " << rhs.ty();
 				break;
 			case ElementPtr:
 				// Handle getelementptr with appropriate syntax
-				os << "getelementptr ";
+				*this << "getelementptr ";
 				if (rhs.size() >= 3) {
-					os << "inbounds "; // Common in LLVM IR
-					os << rhs[0].ty() << ", ptr " << rhs[1];
+					*this << "inbounds "; // Common in LLVM IR
+					*this << rhs[0].ty() << ", ptr " << rhs[1];
 					for (size_t i = 2; i < rhs.size(); ++i) {
-						os << ", " << rhs[i].ty() << " " << rhs[i];
+						*this << ", " << rhs[i].ty() << " " << rhs[i];
 					}
 				}
 				break;
+			case FieldPtr:
+				// Format: getelementptr <struct-type>, ptr <pointer>, i32 0, i32 <field>
+				ASSERT(rhs.size() == 3);
+				*this << "getelementptr inbounds " << rhs[0].ty() << ", ptr " << rhs[1] << ", i32 0, i32 " << rhs[2];
+				break;
 			case Eq:
 			case SLe:
 			case SLt:
@@ -426,7 +502,7 @@ ostream& operator<<(ostream& os, Inst inst) {
 			case ULt:
 				// Format: icmp <predicate> <type> <operand1>, <operand2>
 				ASSERT(rhs.size() == 2);
-				os << rhs.tag() << " " << rhs[0].ty() << " " << rhs[0] << ", " << rhs[1];
+				*this << rhs.tag() << " " << rhs[0].ty() << " " << rhs[0] << ", " << rhs[1];
 				break;
 			case FAdd:
 			case FDiv:
@@ -435,195 +511,276 @@ ostream& operator<<(ostream& os, Inst inst) {
 			case FSub:
 				// Format: <op> <type> <operand1>, <operand2>
 				ASSERT(rhs.size() == 2);
-				os << rhs.tag() << " " << rhs.ty() << " " << rhs[0] << ", " << rhs[1];
+				*this << rhs.tag() << " " << rhs.ty() << " " << rhs[0] << ", " << rhs[1];
 				break;
 			case FEq:
 			case FLe:
 			case FLt:
 				// Format: fcmp <predicate> <type> <operand1>, <operand2>
 				ASSERT(rhs.size() == 2);
-				os << rhs.tag() << " " << rhs[0].ty() << " " << rhs[0] << ", " << rhs[1];
+				*this << rhs.tag() << " " << rhs[0].ty() << " " << rhs[0] << ", " << rhs[1];
 				break;
 			case FNeg:
 				// Format: fneg <type> <operand>
 				ASSERT(rhs.size() == 1);
-				os << "fneg " << rhs.ty() << " " << rhs[0];
+				*this << "fneg " << rhs.ty() << " " << rhs[0];
+				break;
+			case Not:
+				// Format: xor <type> <operand>, -1
+				ASSERT(rhs.size() == 1);
+				*this << "xor " << rhs.ty() << " " << rhs[0] << ", " << (rhs.ty() == boolTy() ? "true" : "-1");
 				break;
 			case Load:
 				// Format: load <type>, ptr <pointer>
 				ASSERT(rhs.size() == 1);
-				os << "load " << rhs.ty() << ", ptr " << rhs[0];
+				*this << "load " << rhs.ty() << ", ptr " << rhs[0];
 				break;
 			default:
 				// For other compound expressions, use a generic format
-				os << rhs.tag() << " " << rhs.ty();
+				*this << rhs.tag() << " " << rhs.ty();
 				for (size_t i = 0; i < rhs.size(); ++i) {
-					os << (i == 0 ? " " : ", ") << rhs[i];
+					*this << (i == 0 ? " " : ", ") << rhs[i];
 				}
 				break;
 			}
 		} else {
 			// For atomic terms, output with type
-			os << rhs.ty() << " " << rhs;
+			*this << rhs.ty() << " " << rhs;
 		}
 		break;
 	}
 	case Block: {
 		// Format: label:
 		ASSERT(inst.size() == 1);
-		os << inst[0].ref() << ":";
+		*this << inst[0].ref() << ":";
 		break;
 	}
 	case Br: {
 		// Format: br i1 %cond, label %true, label %false
 		ASSERT(inst.size() == 3);
-		os << "br i1 " << inst[0] << ", label " << inst[1] << ", label " << inst[2];
+		*this << "br i1 " << inst[0] << ", label " << inst[1] << ", label " << inst[2];
 		break;
 	}
 	case Drop: {
 		// Format: expr
 		ASSERT(inst.size() == 1);
-		os << inst[0];
+		*this << inst[0];
 		break;
 	}
 	case Jmp: {
 		// Format: br label %target
 		ASSERT(inst.size() == 1);
-		os << "br label " << inst[0];
+		*this << "br label " << inst[0];
 		break;
 	}
 	case Phi: {
 		// Format: %var = phi type [ val1, %label1 ], [ val2, %label2 ], ...
 		ASSERT(inst.size() >= 3 && (inst.size() % 2) == 1);
-		os << inst[0] << " = phi " << inst[1].ty() << ' ';
+		*this << inst[0] << " = phi " << inst[1].ty() << ' ';
 		for (size_t i = 1; i < inst.size(); i += 2) {
 			if (i > 1) {
-				os << ", ";
+				*this << ", ";
 			}
-			os << "[ " << inst[i] << ", " << inst[i + 1] << " ]";
+			*this << "[ " << inst[i] << ", " << inst[i + 1] << " ]";
 		}
 		break;
 	}
 	case Ret: {
 		// Format: ret type value
 		ASSERT(inst.size() == 1);
-		os << "ret " << inst[0].ty() << " " << inst[0];
+		*this << "ret " << inst[0].ty() << " " << inst[0];
 		break;
 	}
 	case Store: {
 		// Format: store type value, ptr pointer
 		ASSERT(inst.size() == 2);
-		os << "store " << inst[0].ty() << " " << inst[0] << ", " << inst[1].ty() << " " << inst[1];
+		*this << "store " << inst[0].ty() << " " << inst[0] << ", " << inst[1].ty() << " " << inst[1];
 		break;
 	}
 	case Switch: {
 		// Format: switch type value, label %default [ type val1, label %label1 ... ]
 		ASSERT(inst.size() >= 2 && (inst.size() % 2) == 0);
-		os << "switch " << inst[0].ty() << " " << inst[0] << ", label " << inst[1];
+		*this << "switch " << inst[0].ty() << " " << inst[0] << ", label " << inst[1];
 		if (inst.size() > 2) {
-			os << " [";
+			*this << " [";
 			for (size_t i = 2; i < inst.size(); i += 2) {
-				os << "\n    " << inst[i].ty() << " " << inst[i] << ", label " << inst[i + 1];
+				*this << "\n    " << inst[i].ty() << " " << inst[i] << ", label " << inst[i + 1];
 			}
-			os << "\n  ]";
+			*this << "\n  ]";
 		}
 		break;
 	}
 	default:
 		ASSERT(false && "Unknown instruction type");
 	}
-	return os;
+	return *this;
 }
 
-ostream& operator<<(ostream& os, Global a) {
-	os << '@' << a.ref() << '=' << "global " << a.ty();
+Writer& Writer::operator<<(Global a) {
+	*this << '@' << a.ref() << '=' << "global " << a.ty();
 	if (a.val().tag() != None) {
-		os << ' ' << a.val();
+		*this << ' ' << a.val();
 	}
-	return os;
+	return *this;
 }
 
-ostream& operator<<(ostream& os, Fn f) {
+Writer& Writer::operator<<(Fn f) {
+	// Nested operands must be broken out into separate instructions
+	f = linearize(f);
+
 	// Output declare/define based on whether function has a body
 	if (f.size() == 0) {
-		os << "declare ";
+		*this << "declare ";
 	} else {
-		os << "define ";
+		*this << "define ";
 	}
 
 	// Output return type
-	os << f.rty() << ' ';
+	*this << f.rty() << ' ';
 
 	// Output function name/reference
-	os << '@' << f.ref();
+	*this << '@' << f.ref();
 
 	// Output parameter list
-	os << '(';
+	*this << '(';
 	auto params = f.params();
 	for (size_t i = 0; i < params.size(); ++i) {
 		if (i > 0) {
-			os << ", ";
+			*this << ", ";
 		}
 		if (params[i].tag() == Array) {
-			os << "...";
+			*this << "...";
 			continue;
 		}
-		os << params[i].ty();
+		*this << params[i].ty();
 		if (params[i].tag() == Var) {
-			os << ' ' << params[i];
+			*this << ' ' << params[i];
 		}
 	}
-	os << ')';
+	*this << ')';
 
 	// If this is just a declaration, end here
 	if (f.size() == 0) {
-		return os;
+		return *this;
 	}
 
 	// Output function body
-	os << " {\n";
+	*this << " {\n";
 
 	// Output each instruction in the function body
 	for (const auto& inst : f) {
 		if (inst.opcode() != Block) {
-			os << "  ";
+			*this << "  ";
 		}
-		os << inst << '\n';
+		*this << inst << '\n';
 	}
 
-	os << '}';
+	*this << '}';
 
-	return os;
+	return *this;
+}
+
+Writer& Writer::operator<<(const Module& module) {
+	write(module, 1);
+	return *this;
 }
 
-ostream& operator<<(ostream& out, const Module& module) {
+void Writer::write(const Module& module, size_t threads) {
+	// Only a whole module is worth allocating the full buffer up front
+	// a writer used to print a single term grows its buffer as needed
+	if (os) {
+		buf.reserve(bufSize + 4096);
+	}
+
 	// Print target platform info
 	if (module.datalayout.size()) {
-		out << "target datalayout = \"" << module.datalayout << "\"\n";
+		*this << "target datalayout = \"" << module.datalayout << "\"\n";
 	}
 	if (module.triple.size()) {
-		out << "target triple = \"" << module.triple << "\"\n";
+		*this << "target triple = \"" << module.triple << "\"\n";
 	}
 
 	// Print comdats
 	for (const auto& ref : module.comdats) {
-		out << '$' << ref << " = comdat any\n";
+		*this << '$' << ref << " = comdat any\n";
 	}
 
 	// Print global variables
 	for (const auto& global : module.globals) {
-		out << global << "\n";
+		*this << global << "\n";
 	}
 
 	// Print function declarations
 	for (const auto& decl : module.decls) {
-		out << decl << "\n";
+		*this << decl << "\n";
 	}
 
 	// Print function definitions
-	for (const auto& def : module.defs) {
-		out << def << "\n";
+	auto& defs = module.defs;
+	if (threads <= 1 || defs.size() < 2) {
+		for (const auto& def : defs) {
+			*this << def << "\n";
+		}
+		return;
+	}
+
+	// Contiguous runs of definitions are rendered into separate buffers
+	// several per thread, so a few large functions do not leave the other threads idle
+	// then the buffers are written in order
+	// The output is a stream, which has no gathered write, but there are at most eight parts per thread
+	// so writing them one at a time costs only a few system calls
+	// and parts smaller than the buffer are coalesced into it, so they do not each cost one
+	auto n = std::min(defs.size(), threads * 8);
+	vector<Writer> parts(n);
+	parallelFor(n, threads, [&](size_t i) {
+		for (auto j = defs.size() * i / n; j < defs.size() * (i + 1) / n; j++) {
+			parts[i] << defs[j] << "\n";
+		}
+	});
+	for (auto& part : parts) {
+		auto& s = part.str();
+		if (os && s.size() >= bufSize) {
+			flush();
+			os->write(s.data(), s.size());
+			continue;
+		}
+		*this << s;
 	}
+}
 
-	return out;
+// The stream operators print through a writer of their own
+// so output of a whole module is buffered as one, but a single term is still convenient for debug output
+ostream& operator<<(ostream& os, Type ty) {
+	Writer(os) << ty;
+	return os;
+}
+
+ostream& operator<<(ostream& os, Tag tag) {
+	Writer(os) << tag;
+	return os;
+}
+
+ostream& operator<<(ostream& os, Term a) {
+	Writer(os) << a;
+	return os;
+}
+
+ostream& operator<<(ostream& os, Inst inst) {
+	Writer(os) << inst;
+	return os;
+}
+
+ostream& operator<<(ostream& os, Global a) {
+	Writer(os) << a;
+	return os;
+}
+
+ostream& operator<<(ostream& os, Fn f) {
+	Writer(os) << f;
+	return os;
+}
+
+ostream& operator<<(ostream& os, const Module& module) {
+	Writer(os) << module;
+	return os;
 }
@@ -17,6 +17,83 @@ inline string wrap(const char* s) {
 // with the single exception of `\` which is converted to `\\`
 string wrap(const Ref&);
 
+// Buffered output of LLVM format
+// Text is appended to a large buffer, which is written to the stream when full, and when the writer is destroyed
+// so printing a module takes a few large writes, rather than many small formatted ones
+// Numbers are formatted with std::to_chars, and each type is formatted once, then its spelling is cached
+// A writer without a stream keeps all its output in the buffer instead
+class Writer {
+	ostream* os = nullptr;
+	string buf;
+
+	static constexpr size_t bufSize = 1 << 20;
+
+	void reserve() {
+		if (os && buf.size() >= bufSize) {
+			flush();
+		}
+	}
+
+public:
+	Writer() {
+	}
+
+	explicit Writer(ostream& os): os(&os) {
+	}
+
+	~Writer() {
+		flush();
+	}
+
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+
+	void flush();
+
+	// The output so far, for a writer without a stream
+	const string& str() const {
+		return buf;
+	}
+
+	// Output a module, rendering function definitions on several threads
+	// Each definition's text depends only on that function, so this gives the same output as on one thread
+	void write(const Module& module, size_t threads);
+
+	Writer& operator<<(char c) {
+		buf += c;
+		reserve();
+		return *this;
+	}
+
+	Writer& operator<<(const char* s) {
+		buf += s;
+		reserve();
+		return *this;
+	}
+
+	Writer& operator<<(std::string_view s) {
+		buf += s;
+		reserve();
+		return *this;
+	}
+
+	// Otherwise a string would be ambiguous, as it also converts to a Ref
+	Writer& operator<<(const string& s) {
+		return *this << std::string_view(s);
+	}
+
+	Writer& operator<<(size_t n);
+	Writer& operator<<(const Integer& a);
+	Writer& operator<<(const Ref& ref);
+	Writer& operator<<(Type ty);
+	Writer& operator<<(Tag tag);
+	Writer& operator<<(Term a);
+	Writer& operator<<(Inst inst);
+	Writer& operator<<(Global a);
+	Writer& operator<<(Fn f);
+	Writer& operator<<(const Module& module);
+};
+
 inline ostream& operator<<(ostream& os, const Ref& ref) {
 	return os << wrap(ref);
 }
@@ -4,16 +4,21 @@ struct ProgramImpl {
 	const vector<Global> globals;
 	const vector<Fn> defs;
 
+	// Reachable in the current garbage collection cycle
+	bool mark = false;
+
 	ProgramImpl(const vector<Global>& globals, const vector<Fn>& defs): globals(globals), defs(defs) {
 	}
 };
 
+Arena<ProgramImpl> programArena;
+
 Program::Program() {
-	p = new ProgramImpl({}, {});
+	p = programArena.make(vector<Global>(), vector<Fn>());
 }
 
 Program::Program(const vector<Global>& globals, const vector<Fn>& defs) {
-	p = new ProgramImpl(globals, defs);
+	p = programArena.make(globals, defs);
 }
 
 vector<Global> Program::globals() const {
@@ -29,6 +34,19 @@ Fn Program::operator[](size_t i) const {
 	return p->defs[i];
 }
 
+void Program::mark() const {
+	if (p->mark) {
+		return;
+	}
+	p->mark = true;
+	for (auto global : p->globals) {
+		global.mark();
+	}
+	for (auto f : p->defs) {
+		f.mark();
+	}
+}
+
 Program::const_iterator Program::begin() const {
 	return p->defs.begin();
 }
@@ -44,3 +62,11 @@ Program::const_iterator Program::cbegin() const {
 Program::const_iterator Program::cend() const {
 	return p->defs.cend();
 }
+
+size_t sweepPrograms() {
+	return programArena.sweep([](ProgramImpl* p) {
+		auto live = p->mark;
+		p->mark = false;
+		return live;
+	});
+}
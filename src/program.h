@@ -22,6 +22,9 @@ public:
 
 	Fn operator[](size_t i) const;
 
+	// Mark this program and everything in it as reachable, for garbage collection
+	void mark() const;
+
 	// Iterators
 	using const_iterator = vector<Fn>::const_iterator;
 
@@ -31,3 +34,7 @@ public:
 	const_iterator cbegin() const;
 	const_iterator cend() const;
 };
+
+// Reclaim programs that have not been marked as reachable, and clear the marks on the rest
+// Returns the number of programs reclaimed
+size_t sweepPrograms();
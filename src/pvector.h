@@ -0,0 +1,271 @@
+// Persistent vector
+// Immutable; an update returns a new vector that shares all but O(log n) of its structure with the original
+// Represented as a tree with a branching factor of 32, with the elements in the leaves
+// Intended for function bodies, so that a pass that changes a few instructions in a large function
+// does not have to copy the whole thing
+template <class T> class PVector {
+	static constexpr unsigned bits = 5;
+	static constexpr size_t width = size_t(1) << bits;
+	static constexpr size_t mask = width - 1;
+
+	struct Node {
+		// Exactly one of these is used, depending on whether the node is a leaf
+		vector<T> elements;
+		vector<std::shared_ptr<const Node>> children;
+	};
+
+	using NodePtr = std::shared_ptr<const Node>;
+
+	NodePtr root;
+	size_t n = 0;
+
+	// Number of bits of an index consumed by the levels above the leaves
+	unsigned shift = 0;
+
+	const T* leaf(size_t i) const {
+		auto node = root.get();
+		for (auto s = shift; s; s -= bits) {
+			node = node->children[(i >> s) & mask].get();
+		}
+		return node->elements.data();
+	}
+
+	static NodePtr set(const NodePtr& node, unsigned s, size_t i, const T& x) {
+		auto r = std::make_shared<Node>(*node);
+		if (s) {
+			auto& child = r->children[(i >> s) & mask];
+			child = set(child, s - bits, i, x);
+		} else {
+			r->elements[i & mask] = x;
+		}
+		return r;
+	}
+
+	template <class F> static NodePtr map(const NodePtr& node, unsigned s, F& f) {
+		std::shared_ptr<Node> r;
+		if (s) {
+			for (size_t i = 0; i < node->children.size(); i++) {
+				auto& child = node->children[i];
+				auto c = map(child, s - bits, f);
+				if (c != child) {
+					if (!r) {
+						r = std::make_shared<Node>(*node);
+					}
+					r->children[i] = c;
+				}
+			}
+		} else {
+			for (size_t i = 0; i < node->elements.size(); i++) {
+				auto& x = node->elements[i];
+				T y = f(x);
+				if (y != x) {
+					if (!r) {
+						r = std::make_shared<Node>(*node);
+					}
+					r->elements[i] = y;
+				}
+			}
+		}
+		if (r) {
+			return r;
+		}
+		return node;
+	}
+
+public:
+	PVector() {
+	}
+
+	template <class Iterator> PVector(Iterator first, Iterator last) {
+		// Leaves
+		vector<NodePtr> level;
+		while (first != last) {
+			auto node = std::make_shared<Node>();
+			while (first != last && node->elements.size() < width) {
+				node->elements.push_back(*first++);
+			}
+			n += node->elements.size();
+			level.push_back(node);
+		}
+		if (level.empty()) {
+			return;
+		}
+
+		// Interior nodes
+		while (level.size() > 1) {
+			vector<NodePtr> up;
+			for (size_t i = 0; i < level.size(); i += width) {
+				auto node = std::make_shared<Node>();
+				node->children.assign(level.begin() + i, level.begin() + std::min(i + width, level.size()));
+				up.push_back(node);
+			}
+			level = up;
+			shift += bits;
+		}
+		root = level[0];
+	}
+
+	PVector(std::initializer_list<T> v): PVector(v.begin(), v.end()) {
+	}
+
+	PVector(const vector<T>& v): PVector(v.begin(), v.end()) {
+	}
+
+	size_t size() const {
+		return n;
+	}
+
+	const T& operator[](size_t i) const {
+		ASSERT(i < n);
+		return leaf(i)[i & mask];
+	}
+
+	// Return a copy of the vector with one element changed
+	PVector set(size_t i, const T& x) const {
+		ASSERT(i < n);
+		auto r = *this;
+		r.root = set(root, shift, i, x);
+		return r;
+	}
+
+	// Return a copy of the vector with f applied to every element
+	// Only the parts of the tree that actually change are copied
+	// so if f returns every element unchanged, the result is identical to the original
+	template <class F> PVector map(F f) const {
+		if (!n) {
+			return *this;
+		}
+		auto r = *this;
+		r.root = map(root, shift, f);
+		return r;
+	}
+
+	// Do the two vectors share the same representation?
+	// This implies equality, but not the converse
+	bool identical(const PVector& b) const {
+		return root == b.root;
+	}
+
+	// Iterators
+	class const_iterator {
+		const PVector* v = nullptr;
+		size_t i = 0;
+
+		// Cache of the current leaf, to avoid descending the tree for every element
+		mutable const T* elements = nullptr;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		const_iterator() {
+		}
+
+		const_iterator(const PVector* v, size_t i): v(v), i(i) {
+		}
+
+		reference operator*() const {
+			if (!elements) {
+				elements = v->leaf(i);
+			}
+			return elements[i & mask];
+		}
+
+		pointer operator->() const {
+			return &**this;
+		}
+
+		reference operator[](difference_type d) const {
+			return (*v)[i + d];
+		}
+
+		const_iterator& operator++() {
+			++i;
+			if (!(i & mask)) {
+				elements = nullptr;
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			auto r = *this;
+			++*this;
+			return r;
+		}
+
+		const_iterator& operator--() {
+			if (!(i & mask)) {
+				elements = nullptr;
+			}
+			--i;
+			return *this;
+		}
+
+		const_iterator operator--(int) {
+			auto r = *this;
+			--*this;
+			return r;
+		}
+
+		const_iterator& operator+=(difference_type d) {
+			if ((i + d) >> bits != i >> bits) {
+				elements = nullptr;
+			}
+			i += d;
+			return *this;
+		}
+
+		const_iterator& operator-=(difference_type d) {
+			return *this += -d;
+		}
+
+		const_iterator operator+(difference_type d) const {
+			auto r = *this;
+			return r += d;
+		}
+
+		const_iterator operator-(difference_type d) const {
+			auto r = *this;
+			return r -= d;
+		}
+
+		difference_type operator-(const const_iterator& b) const {
+			return i - b.i;
+		}
+
+		bool operator==(const const_iterator& b) const {
+			return i == b.i;
+		}
+
+		bool operator!=(const const_iterator& b) const {
+			return i != b.i;
+		}
+
+		bool operator<(const const_iterator& b) const {
+			return i < b.i;
+		}
+
+		bool operator<=(const const_iterator& b) const {
+			return i <= b.i;
+		}
+
+		bool operator>(const const_iterator& b) const {
+			return i > b.i;
+		}
+
+		bool operator>=(const const_iterator& b) const {
+			return i >= b.i;
+		}
+	};
+
+	const_iterator begin() const {
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const {
+		return const_iterator(this, n);
+	}
+};
@@ -1,7 +1,93 @@
 #include "all.h"
 
-bool Ref::operator==(const Ref& b) const {
-	return num1 == b.num1 && str1 == b.str1;
+namespace {
+struct Symbol {
+	string name;
+	size_t id;
+};
+
+struct SymbolHash {
+	size_t operator()(const Symbol& a) const {
+		return hash<std::string_view>()(a.name);
+	}
+
+	size_t operator()(std::string_view s) const {
+		return hash<std::string_view>()(s);
+	}
+};
+
+struct SymbolEqual {
+	bool operator()(const Symbol& a, std::string_view s) const {
+		return a.name == s;
+	}
+};
+
+// Names are looked up by id in chunks that are allocated as needed and never move
+// so reading the name of an existing ref takes no lock
+// An id is only handed out after its entry is written, and the interner publishes it with release ordering
+// so a thread that has the id can see the entry
+constexpr size_t chunkBits = 16;
+constexpr size_t chunkSize = size_t(1) << chunkBits;
+constexpr size_t chunkCount = size_t(1) << 14;
+
+struct SymbolTable {
+	Interner<Symbol, SymbolHash, SymbolEqual> symbols;
+
+	std::atomic<size_t> n{0};
+	std::atomic<const string**> chunks[chunkCount];
+
+	// Guards allocation of chunks
+	std::mutex mutex;
+
+	SymbolTable() {
+		for (auto& p : chunks) {
+			p.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	const string** chunk(size_t i) {
+		if (i >= chunkCount) {
+			throw runtime_error("Too many names");
+		}
+		auto p = chunks[i].load(std::memory_order_acquire);
+		if (p) {
+			return p;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		p = chunks[i].load(std::memory_order_relaxed);
+		if (!p) {
+			p = new const string*[chunkSize];
+			chunks[i].store(p, std::memory_order_release);
+		}
+		return p;
+	}
+
+	Symbol* add(std::string_view s) {
+		auto a = new Symbol{string(s), n.fetch_add(1, std::memory_order_relaxed)};
+		chunk(a->id >> chunkBits)[a->id & (chunkSize - 1)] = &a->name;
+		return a;
+	}
+
+	const string& name(size_t id) const {
+		return *chunks[id >> chunkBits].load(std::memory_order_acquire)[id & (chunkSize - 1)];
+	}
+};
+
+// Constructed on first use, as refs may be created during static initialization
+SymbolTable& table() {
+	static SymbolTable table;
+	return table;
+}
+} // namespace
+
+size_t Ref::intern(std::string_view s) {
+	auto& t = table();
+	return t.symbols.intern(s, [&]() { return t.add(s); })->id;
+}
+
+const string& Ref::str() const {
+	ASSERT(!numeric());
+	return table().name(id);
 }
 
 bool Ref::operator<(const Ref& b) const {
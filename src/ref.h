@@ -1,53 +1,64 @@
+// Names are interned in a global symbol table
+// so a Ref is just a number and a flag, cheap to copy, compare and hash
+// however long the name it refers to
 class Ref {
-	string str1;
-	size_t num1 = ~(size_t)0;
+	// For a numeric reference, the number
+	// For a named reference, the index of the name in the symbol table
+	size_t id = 0;
+	bool named = false;
+
+	static size_t intern(std::string_view s);
 
 public:
-	Ref(): num1(0) {
+	Ref() {
+	}
+
+	Ref(const string& str): id(intern(str)), named(true) {
 	}
 
-	Ref(string str): str1(str) {
+	Ref(const char* str): id(intern(str)), named(true) {
 	}
 
-	Ref(const char* str): str1(str) {
+	Ref(std::string_view str): id(intern(str)), named(true) {
 	}
 
-	Ref(size_t num): num1(num) {
-		ASSERT(num != (std::numeric_limits<size_t>::max)());
+	Ref(size_t num): id(num) {
 	}
 
 	// Accessors
 	bool numeric() const {
-		return num1 != ~(size_t)0;
+		return !named;
 	}
 
-	string str() const {
-		ASSERT(!numeric());
-		return str1;
-	}
+	const string& str() const;
 
 	size_t num() const {
 		ASSERT(numeric());
-		return num1;
+		return id;
 	}
 
 	// Comparison by value
-	bool operator==(const Ref& b) const;
+	bool operator==(const Ref& b) const {
+		return id == b.id && named == b.named;
+	}
 
 	bool operator!=(const Ref& b) const {
 		return !(*this == b);
 	}
 
+	// Names are ordered by their text, not by the order in which they were interned
+	// so the ordering is deterministic
 	bool operator<(const Ref& b) const;
+
+	friend struct hash<Ref>;
 };
 
 namespace std {
 template <> struct hash<Ref> {
 	size_t operator()(const Ref& ref) const {
-		if (ref.numeric()) {
-			return hash<size_t>()(ref.num());
-		}
-		return hash<string>()(ref.str());
+		size_t h = ref.id;
+		hash_combine(h, ref.named);
+		return h;
 	}
 };
 } // namespace std
@@ -1,6 +1,30 @@
 #include "all.h"
 
-Term replace(Term term, const unordered_map<Term, Term>& replacements) {
+// Replacement maps usually contain only variables, or only global references
+// in which case subterms that contain neither kind of atom cannot change
+unsigned keyFlags(const unordered_map<Term, Term>& replacements) {
+	unsigned mask = 0;
+	for (const auto& [key, val] : replacements) {
+		switch (key.tag()) {
+		case GlobalRef:
+			mask |= HasGlobalRef;
+			break;
+		case Var:
+			mask |= HasVar;
+			break;
+		default:
+			return 0;
+		}
+	}
+	return mask;
+}
+
+Term replace(Term term, const unordered_map<Term, Term>& replacements, unsigned mask) {
+	// Skip subterms that cannot contain any of the keys
+	if (replacements.empty() || (mask && !(term.flags() & mask))) {
+		return term;
+	}
+
 	// First, check if the term itself is in the replacement map
 	if (term.size() == 0) {
 		auto it = replacements.find(term);
@@ -20,7 +44,7 @@ Term replace(Term term, const unordered_map<Term, Term>& replacements) {
 
 	bool changed = false;
 	for (const Term& operand : term) {
-		Term newOperand = replace(operand, replacements);
+		Term newOperand = replace(operand, replacements, mask);
 		newOperands.push_back(newOperand);
 		if (newOperand != operand) {
 			changed = true;
@@ -36,9 +60,13 @@ Term replace(Term term, const unordered_map<Term, Term>& replacements) {
 	return Term(term.tag(), term.ty(), newOperands);
 }
 
-Inst replace(Inst inst, const unordered_map<Term, Term>& replacements) {
-	// If the instruction has no operands, return it as is
-	if (inst.size() == 0) {
+Term replace(Term term, const unordered_map<Term, Term>& replacements) {
+	return replace(term, replacements, keyFlags(replacements));
+}
+
+Inst replace(Inst inst, const unordered_map<Term, Term>& replacements, unsigned mask) {
+	// If the instruction has no operands, or there is nothing to replace, return it as is
+	if (inst.size() == 0 || replacements.empty()) {
 		return inst;
 	}
 
@@ -47,23 +75,45 @@ Inst replace(Inst inst, const unordered_map<Term, Term>& replacements) {
 	newOperands.reserve(inst.size());
 
 	// Transform each operand
-	for (size_t i = 0; i < inst.size(); ++i) {
+	bool changed = false;
+	for (auto operand : inst) {
 		// Apply replacement recursively to each operand
-		newOperands.push_back(replace(inst[i], replacements));
+		auto newOperand = replace(operand, replacements, mask);
+		newOperands.push_back(newOperand);
+		if (newOperand != operand) {
+			changed = true;
+		}
+	}
+
+	// If none of the operands changed, return the original instruction
+	if (!changed) {
+		return inst;
 	}
 
 	// Create a new instruction with the same opcode but with transformed operands
 	return Inst(inst.opcode(), newOperands);
 }
 
+Inst replace(Inst inst, const unordered_map<Term, Term>& replacements) {
+	return replace(inst, replacements, keyFlags(replacements));
+}
+
 Global replace(Global global, const unordered_map<Term, Term>& replacements) {
+	return replace(global, replacements, keyFlags(replacements));
+}
+
+Global replace(Global global, const unordered_map<Term, Term>& replacements, unsigned mask) {
+	if (replacements.empty()) {
+		return global;
+	}
+
 	// Create a new Global with the same type and reference
 	Global result(global.ty(), global.ref());
 
 	// If the global has a value, replace it
 	if (global.val().tag() != None) {
 		// Apply term replacement to the value
-		Term newVal = replace(global.val(), replacements);
+		Term newVal = replace(global.val(), replacements, mask);
 
 		// Create a new Global with the replaced value
 		return Global(global.ty(), global.ref(), newVal);
@@ -74,24 +124,47 @@ Global replace(Global global, const unordered_map<Term, Term>& replacements) {
 }
 
 Fn replace(Fn func, const unordered_map<Term, Term>& replacements) {
+	// The map is the same for every instruction, so only needs to be examined once
+	return replace(func, replacements, keyFlags(replacements));
+}
+
+Fn replace(Fn func, const unordered_map<Term, Term>& replacements, unsigned mask) {
+	if (replacements.empty()) {
+		return func;
+	}
+
 	// Create a new function with the same return type and reference
 	Type returnType = func.rty();
 	Ref funcRef = func.ref();
 
 	// Replace all parameters
+	// The list is copied only once a parameter is found to change
+	auto& params = func.params();
 	vector<Term> newParams;
-	for (const Term& param : func.params()) {
-		newParams.push_back(replace(param, replacements));
+	auto paramsChanged = false;
+	for (size_t i = 0; i < params.size(); i++) {
+		auto param = replace(params[i], replacements, mask);
+		if (!paramsChanged && param != params[i]) {
+			newParams.assign(params.begin(), params.begin() + i);
+			paramsChanged = true;
+		}
+		if (paramsChanged) {
+			newParams.push_back(param);
+		}
 	}
 
 	// Replace all instructions in the function body
-	vector<Inst> newBody;
-	for (const Inst& inst : func) {
-		newBody.push_back(replace(inst, replacements));
+	// Only the parts of the body containing changed instructions are copied
+	auto body = func.body();
+	auto newBody = body.map([&](Inst inst) { return replace(inst, replacements, mask); });
+
+	// If nothing changed, return the original function
+	if (!paramsChanged && newBody.identical(body)) {
+		return func;
 	}
 
 	// Create and return a new function with the replaced parameters and body
-	return Fn(returnType, funcRef, newParams, newBody);
+	return Fn(returnType, funcRef, paramsChanged ? newParams : params, newBody);
 }
 
 void rename(Module* module, const unordered_map<Ref, Ref>& renameMap) {
@@ -167,10 +240,7 @@ void rename(Module* module, const unordered_map<Ref, Ref>& renameMap) {
 			Ref newRef = it->second;
 
 			// Create new definition with renamed reference and body
-			vector<Term> params = def.params();
-			vector<Inst> body(def.begin(), def.end());
-
-			Fn newDef = Fn(def.rty(), newRef, params, body);
+			Fn newDef = Fn(def.rty(), newRef, def.params(), def.body());
 
 			// Add mapping for any references to this function
 			Type fnType = fnTy(def.rty(), map(def.params(), [](Term p) { return p.ty(); }));
@@ -187,16 +257,17 @@ void rename(Module* module, const unordered_map<Ref, Ref>& renameMap) {
 	module->defs = newDefs;
 
 	// Apply the term replacements to all globals that have values
+	auto mask = keyFlags(termRenameMap);
 	for (auto& global : module->globals) {
 		Term val = global.val();
 		if (val != Term()) { // Check if global has a value
-			global = replace(global, termRenameMap);
+			global = replace(global, termRenameMap, mask);
 		}
 	}
 
 	// Apply the term replacements to all function bodies
 	for (auto& def : module->defs) {
-		def = replace(def, termRenameMap);
+		def = replace(def, termRenameMap, mask);
 	}
 }
 
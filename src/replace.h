@@ -5,6 +5,17 @@
 // but can replace any atomic terms
 Term replace(Term, const unordered_map<Term, Term>&);
 
+// The flags a term must have for any key of the map to occur within it
+// or 0 if the keys are of kinds not tracked by flags, so no subterm can be skipped
+// Replacing over many terms with the same map, callers should compute this once
+// and pass it to the overloads that take it, rather than have each call scan the map
+unsigned keyFlags(const unordered_map<Term, Term>&);
+
+Term replace(Term, const unordered_map<Term, Term>&, unsigned mask);
+Inst replace(Inst, const unordered_map<Term, Term>&, unsigned mask);
+Global replace(Global, const unordered_map<Term, Term>&, unsigned mask);
+Fn replace(Fn, const unordered_map<Term, Term>&, unsigned mask);
+
 // Transform an instruction by performing term replacement over all operands
 Inst replace(Inst, const unordered_map<Term, Term>&);
 
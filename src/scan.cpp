@@ -0,0 +1,211 @@
+#include "all.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SCAN_X86
+#include <cpuid.h>
+#include <immintrin.h>
+
+// The baseline for x86-64 includes SSE2, but not AVX2
+// so AVX2 code is compiled separately, and only called if the processor turns out to support it
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+#ifdef SCAN_X86
+bool hasAvx2() {
+	unsigned a, b, c, d;
+	if (!__get_cpuid(1, &a, &b, &c, &d)) {
+		return false;
+	}
+
+	// The operating system must save the AVX registers on context switch
+	if (!(c & bit_OSXSAVE) || !(c & bit_AVX)) {
+		return false;
+	}
+	unsigned lo, hi;
+	__asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	if ((lo & 6) != 6) {
+		return false;
+	}
+
+	if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) {
+		return false;
+	}
+	return b & bit_AVX2;
+}
+
+const bool avx2 = hasAvx2();
+
+// Bytes in the range lo to hi inclusive
+__m128i inRange(__m128i x, char lo, char hi) {
+	auto d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(hi - lo)), d);
+}
+
+AVX2 __m256i inRange(__m256i x, char lo, char hi) {
+	auto d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(hi - lo)), d);
+}
+#endif
+
+// Each kind of run is described by a test of whether a character ends it
+// and, for vector code, a mask with a bit set for each byte in a block that ends it
+
+struct Byte {
+	char c;
+
+	bool end(char x) const {
+		return x == c;
+	}
+
+#ifdef SCAN_X86
+	unsigned mask(__m128i x) const {
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(c)));
+	}
+
+	AVX2 unsigned mask(__m256i x) const {
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(c)));
+	}
+#endif
+};
+
+struct Byte3 {
+	char a, b, c;
+
+	bool end(char x) const {
+		return x == a || x == b || x == c;
+	}
+
+#ifdef SCAN_X86
+	unsigned mask(__m128i x) const {
+		auto r = _mm_cmpeq_epi8(x, _mm_set1_epi8(a));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8(b)));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8(c)));
+		return _mm_movemask_epi8(r);
+	}
+
+	AVX2 unsigned mask(__m256i x) const {
+		auto r = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(a));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(b)));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c)));
+		return _mm256_movemask_epi8(r);
+	}
+#endif
+};
+
+struct Space {
+	bool end(char x) const {
+		switch (x) {
+		case ' ':
+		case '\f':
+		case '\r':
+		case '\t':
+			return false;
+		}
+		return true;
+	}
+
+#ifdef SCAN_X86
+	unsigned mask(__m128i x) const {
+		auto r = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8('\f')));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8('\r')));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+		return ~_mm_movemask_epi8(r) & 0xffff;
+	}
+
+	AVX2 unsigned mask(__m256i x) const {
+		auto r = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\f')));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+		return ~_mm256_movemask_epi8(r);
+	}
+#endif
+};
+
+struct IdPart {
+	bool end(char x) const {
+		return !isIdPart((unsigned char)x);
+	}
+
+	// Letters are matched case-insensitively, by setting the bit that distinguishes lower case
+	// '-' and '.' are adjacent, so they are matched as a range
+#ifdef SCAN_X86
+	unsigned mask(__m128i x) const {
+		auto r = inRange(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+		r = _mm_or_si128(r, inRange(x, '0', '9'));
+		r = _mm_or_si128(r, inRange(x, '-', '.'));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+		r = _mm_or_si128(r, _mm_cmpeq_epi8(x, _mm_set1_epi8('$')));
+		return ~_mm_movemask_epi8(r) & 0xffff;
+	}
+
+	AVX2 unsigned mask(__m256i x) const {
+		auto r = inRange(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+		r = _mm256_or_si256(r, inRange(x, '0', '9'));
+		r = _mm256_or_si256(r, inRange(x, '-', '.'));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+		r = _mm256_or_si256(r, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('$')));
+		return ~_mm256_movemask_epi8(r);
+	}
+#endif
+};
+
+#ifdef SCAN_X86
+template <class Run> AVX2 size_t scanAvx2(const char* s, size_t i, size_t n, Run run) {
+	for (; i + 32 <= n; i += 32) {
+		if (auto m = run.mask(_mm256_loadu_si256((const __m256i*)(s + i)))) {
+			return i + __builtin_ctz(m);
+		}
+	}
+	return i;
+}
+#endif
+
+template <class Run> size_t scan(std::string_view text, size_t i, Run run) {
+	auto s = text.data();
+	auto n = text.size();
+
+	// Many runs, such as the space between tokens, end almost at once
+	// so check the first character before setting up the vector code
+	if (i >= n || run.end(s[i])) {
+		return std::min(i, n);
+	}
+
+#ifdef SCAN_X86
+	if (avx2) {
+		// Stops at the end of the run, or when fewer than 32 bytes are left
+		// either way, the code below finishes the job, at once in the first case
+		i = scanAvx2(s, i, n, run);
+	}
+	for (; i + 16 <= n; i += 16) {
+		if (auto m = run.mask(_mm_loadu_si128((const __m128i*)(s + i)))) {
+			return i + __builtin_ctz(m);
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		if (run.end(s[i])) {
+			return i;
+		}
+	}
+	return n;
+}
+} // namespace
+
+size_t findByte(std::string_view text, size_t i, char c) {
+	return scan(text, i, Byte{c});
+}
+
+size_t findByte(std::string_view text, size_t i, char a, char b, char c) {
+	return scan(text, i, Byte3{a, b, c});
+}
+
+size_t skipSpace(std::string_view text, size_t i) {
+	return scan(text, i, Space());
+}
+
+size_t skipIdPart(std::string_view text, size_t i) {
+	return scan(text, i, IdPart());
+}
@@ -0,0 +1,16 @@
+// Kernels for scanning runs of text, used by the lexer
+// Each returns the first position at or after i at which the run ends, or the size of the text if it does not end
+// On x86-64, these compare 16 bytes at a time with SSE2, or 32 with AVX2 where the processor supports it
+// with scalar code for the last few bytes of the text, which must not be read past, and on other processors
+
+// First occurrence of c
+size_t findByte(std::string_view text, size_t i, char c);
+
+// First occurrence of any of a, b or c
+size_t findByte(std::string_view text, size_t i, char a, char b, char c);
+
+// First character that is not horizontal whitespace, which the lexer considers to be space, tab, form feed and carriage return
+size_t skipSpace(std::string_view text, size_t i);
+
+// First character that is not isIdPart
+size_t skipIdPart(std::string_view text, size_t i);
@@ -2,11 +2,12 @@
 
 Term simplify(const unordered_map<Term, Term>& env, Term a) {
 	// Base cases: constants and environmental lookups
-	switch (a.tag()) {
-	case Float:
-	case Int:
-	case NullPtr:
+	// Constant aggregates such as string literals cannot be simplified further
+	// so there is no need to rebuild them element by element
+	if (a.constant()) {
 		return a;
+	}
+	switch (a.tag()) {
 	case Var:
 		auto it = env.find(a);
 		if (it != env.end()) {
@@ -26,8 +27,8 @@ Term simplify(const unordered_map<Term, Term>& env, Term a) {
 
 	// Try to evaluate constant expressions
 	if (a.size() == 2 && simplified[0].tag() == Int && simplified[1].tag() == Int) {
-		cpp_int v0 = simplified[0].intVal();
-		cpp_int v1 = simplified[1].intVal();
+		Integer v0 = simplified[0].intVal();
+		Integer v1 = simplified[1].intVal();
 		Type ty = simplified[0].ty();
 
 		switch (a.tag()) {
@@ -35,9 +36,9 @@ Term simplify(const unordered_map<Term, Term>& env, Term a) {
 			if (v1 >= 0 && v1 < ty.len()) {
 				// Implement arithmetic right shift
 				bool sign = (v0 < 0);
-				cpp_int result = v0 >> v1.convert_to<unsigned>();
+				Integer result = v0 >> v1.convert_to<unsigned>();
 				if (sign) {
-					cpp_int mask = (cpp_int(1) << (ty.len() - v1.convert_to<unsigned>())) - 1;
+					Integer mask = (Integer(1) << (ty.len() - v1.convert_to<unsigned>())) - 1;
 					mask = ~mask;
 					result |= mask;
 				}
@@ -61,16 +62,16 @@ Term simplify(const unordered_map<Term, Term>& env, Term a) {
 			return intConst(ty, v0 | v1);
 		case SDiv:
 			if (v1 != 0) {
-				return intConst(ty, v0 / v1); // Assuming cpp_int handles signed division
+				return intConst(ty, v0 / v1); // Integer division is signed, truncating toward zero
 			}
 			break;
 		case SLe:
 			return v0 <= v1 ? trueConst : falseConst;
 		case SLt:
-			return v0 < v1 ? trueConst : falseConst; // cpp_int handles signed comparison
+			return v0 < v1 ? trueConst : falseConst; // Integer comparison is signed
 		case SRem:
 			if (v1 != 0) {
-				return intConst(ty, v0 % v1); // Assuming cpp_int handles signed remainder
+				return intConst(ty, v0 % v1); // Integer remainder is signed
 			}
 			break;
 		case Shl:
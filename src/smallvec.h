@@ -0,0 +1,70 @@
+// Immutable sequence with inline storage for up to N elements
+// Intended for the operands of IR nodes
+// most of which have only a few, so storing them in the node itself
+// saves a separate heap allocation per node, and a pointer indirection per traversal
+// Longer sequences, such as the arguments of calls or elements of aggregates, spill to the heap
+template <class T, size_t N> class SmallVec {
+	size_t n = 0;
+	T* data;
+	alignas(T) unsigned char buf[N * sizeof(T)];
+
+	template <class Iterator> void init(Iterator first, Iterator last) {
+		n = std::distance(first, last);
+		data = n <= N ? reinterpret_cast<T*>(buf) : static_cast<T*>(::operator new(n * sizeof(T)));
+		std::uninitialized_copy(first, last, data);
+	}
+
+public:
+	SmallVec() {
+		init((const T*)nullptr, (const T*)nullptr);
+	}
+
+	SmallVec(std::initializer_list<T> v) {
+		init(v.begin(), v.end());
+	}
+
+	SmallVec(const vector<T>& v) {
+		init(v.begin(), v.end());
+	}
+
+	SmallVec(const SmallVec& b) {
+		init(b.begin(), b.end());
+	}
+
+	SmallVec& operator=(const SmallVec&) = delete;
+
+	~SmallVec() {
+		std::destroy(data, data + n);
+		if (n > N) {
+			::operator delete(data);
+		}
+	}
+
+	size_t size() const {
+		return n;
+	}
+
+	const T& operator[](size_t i) const {
+		return data[i];
+	}
+
+	// Iterators
+	using const_iterator = const T*;
+
+	const_iterator begin() const {
+		return data;
+	}
+
+	const_iterator end() const {
+		return data + n;
+	}
+
+	// Comparison by value
+	bool operator==(const SmallVec& b) const {
+		return std::equal(begin(), end(), b.begin(), b.end());
+	}
+
+	bool operator!=(const SmallVec& b) const {
+		return !(*this == b);
+	}
+};
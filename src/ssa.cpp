@@ -5,35 +5,37 @@ Fn eliminatePhiNodes(const Fn& func) {
 		return func;
 	}
 
-	// Step 1: Collect all phi instructions and their variables
-	struct PhiInfo {
-		Term targetVar;
-		vector<pair<Term, Term>> valuesAndLabels; // pairs of (value, label)
-	};
-
-	unordered_map<Ref, PhiInfo> phiNodes;
-	unordered_map<Ref, size_t> labelToIndex;
-	vector<Inst> newBody;
+	// Step 1: Collect the assignments implied by phi instructions
+	// indexed by the incoming label of each value-label pair
+	// Step 2 looks them up by branch target, so they are made before any branch to a block with that label
+	Numbering numbering(func);
+	VarMap<vector<Inst>> moves(numbering.labels());
+	bool hasPhi = false;
+
+	// Labels already seen in the current phi
+	// shared between phis, and cleared by removing only what each one added
+	VarSet seen(numbering.labels());
+	for (auto inst : func) {
+		if (inst.opcode() != Phi) {
+			continue;
+		}
+		hasPhi = true;
 
-	// First pass: collect phi nodes and build label index
-	for (size_t i = 0; i < func.size(); i++) {
-		const Inst& inst = func[i];
-		if (inst.opcode() == Block) {
-			labelToIndex[inst[0].ref()] = i;
-		} else if (inst.opcode() == Phi) {
-			PhiInfo info;
-			info.targetVar = inst[0];
-
-			// Collect value-label pairs from phi instruction
-			for (size_t j = 1; j < inst.size(); j += 2) {
-				info.valuesAndLabels.push_back({inst[j], inst[j + 1]});
+		// Value-label pairs; if a label occurs more than once, the first pair applies
+		for (size_t j = 1; j < inst.size(); j += 2) {
+			auto label = numbering.label(inst[j + 1]);
+			if (seen.has(label)) {
+				continue;
 			}
-
-			phiNodes[info.targetVar.ref()] = info;
+			seen.add(label);
+			moves[label].push_back(assign(inst[0], inst[j]));
+		}
+		for (size_t j = 2; j < inst.size(); j += 2) {
+			seen.remove(numbering.label(inst[j]));
 		}
 	}
 
-	if (phiNodes.empty()) {
+	if (!hasPhi) {
 		return func; // No phi nodes to eliminate
 	}
 
@@ -61,14 +63,8 @@ Fn eliminatePhiNodes(const Fn& func) {
 			Term falseLabel = inst[2];
 
 			// Add assignments for phi nodes in true target
-			for (const auto& [ref, phi] : phiNodes) {
-				for (const auto& [value, label] : phi.valuesAndLabels) {
-					if (label.ref() == trueLabel.ref()) {
-						result.push_back(assign(phi.targetVar, value));
-						break;
-					}
-				}
-			}
+			auto& m = moves[numbering.label(trueLabel)];
+			result.insert(result.end(), m.begin(), m.end());
 
 			// Add the branch instruction
 			result.push_back(inst);
@@ -80,14 +76,8 @@ Fn eliminatePhiNodes(const Fn& func) {
 			Term target = inst[0];
 
 			// Add assignments for phi nodes in the target block
-			for (const auto& [ref, phi] : phiNodes) {
-				for (const auto& [value, label] : phi.valuesAndLabels) {
-					if (label.ref() == target.ref()) {
-						result.push_back(assign(phi.targetVar, value));
-						break;
-					}
-				}
-			}
+			auto& m = moves[numbering.label(target)];
+			result.insert(result.end(), m.begin(), m.end());
 
 			result.push_back(inst);
 			i++;
@@ -112,12 +102,17 @@ inline Term loadFromAlloca(const Term& ptr, Type ty) {
 // convertToSSA turns mutable variables into allocas.
 Fn convertToSSA(const Fn& f) {
 	vector<Inst> newBody;
-	// Map from variable identifier (Ref) to the pointer (Term) returned by its alloca.
-	unordered_map<Ref, Term> varAlloca;
+	// Map from variable number to the pointer (Term) returned by its alloca.
+	// None for variables that have not been lowered.
+	Numbering numbering(f);
+	VarMap<Term> varAlloca(numbering.vars());
 
 	// --- Step 1. Insert allocas for all function parameters.
-	// We assume parameters are declared as Var terms.
+	// Unnamed parameters and the varargs marker cannot be referred to, so need no storage.
 	for (Term param : f.params()) {
+		if (param.tag() != Var) {
+			continue;
+		}
 		Ref name = param.ref();
 		Type ty = param.ty();
 		// Create a pointer term to hold the allocated memory.
@@ -126,7 +121,7 @@ Fn convertToSSA(const Fn& f) {
 		// Note: we use intConst(intTy(64), 1) to represent the number of elements.
 		newBody.push_back(alloca(ptr, ty, intConst(intTy(64), 1)));
 		// Save the mapping.
-		varAlloca[name] = ptr;
+		varAlloca[numbering.var(name)] = ptr;
 	}
 
 	// --- Step 2. Process each instruction in the original function body.
@@ -144,15 +139,15 @@ Fn convertToSSA(const Fn& f) {
 			// If lhs is a variable, ensure we have allocated storage for it.
 			if (lhs.tag() == Var) {
 				Ref name = lhs.ref();
+				auto& ptr = varAlloca[numbering.var(name)];
 				// If we haven’t seen this variable before, insert an alloca at the beginning.
-				if (varAlloca.find(name) == varAlloca.end()) {
-					Term ptr = var(ptrTy(), name);
+				if (ptr == Term()) {
+					ptr = var(ptrTy(), name);
 					// Prepend the alloca instruction.
 					newBody.insert(newBody.begin(), alloca(ptr, lhs.ty(), intConst(intTy(64), 1)));
-					varAlloca[name] = ptr;
 				}
 				// Replace the assignment with a store into the allocated memory.
-				newBody.push_back(store(rhs, varAlloca[name]));
+				newBody.push_back(store(rhs, ptr));
 			} else {
 				// If not a Var, just copy the instruction.
 				newBody.push_back(inst);
@@ -164,9 +159,9 @@ Fn convertToSSA(const Fn& f) {
 			vector<Term> newOps;
 			for (size_t j = 0; j < inst.size(); ++j) {
 				Term opnd = inst[j];
-				if (opnd.tag() == Var && varAlloca.find(opnd.ref()) != varAlloca.end()) {
+				if (opnd.tag() == Var && varAlloca[numbering.var(opnd)] != Term()) {
 					// Replace with a load.
-					newOps.push_back(loadFromAlloca(varAlloca[opnd.ref()], opnd.ty()));
+					newOps.push_back(loadFromAlloca(varAlloca[numbering.var(opnd)], opnd.ty()));
 				} else {
 					newOps.push_back(opnd);
 				}
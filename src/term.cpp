@@ -6,68 +6,174 @@ struct TermImpl {
 
 	// Atom
 	const Ref ref;
-	const cpp_int intVal;
+	const Integer intVal;
 
 	// Compound
-	const vector<Term> v;
+	// Most compound terms have at most three operands, which are stored inline
+	const SmallVec<Term, 3> v;
+
+	// Derived data, computed once when the term is built
+	size_t hash;
+	unsigned flags;
+
+	// Reachable in the current garbage collection cycle
+	bool mark = false;
 
 	TermImpl(Tag tag, Type ty): tag(tag), ty(ty) {
+		init();
 	}
 
 	TermImpl(Tag tag, Type ty, const Ref& ref): tag(tag), ty(ty), ref(ref) {
+		init();
 	}
 
-	TermImpl(Tag tag, Type ty, const cpp_int& intVal): tag(tag), ty(ty), intVal(intVal) {
+	TermImpl(Tag tag, Type ty, const Integer& intVal): tag(tag), ty(ty), intVal(intVal) {
+		init();
 	}
 
-	TermImpl(Tag tag, Type ty, const vector<Term>& v): tag(tag), ty(ty), v(v) {
+	TermImpl(Tag tag, Type ty, const SmallVec<Term, 3>& v): tag(tag), ty(ty), v(v) {
+		init();
+	}
+
+private:
+	void init() {
+		// Structural hash
+		// Operands are already interned, so they can be hashed by identity
+		hash = 0;
+		hash_combine(hash, std::hash<Tag>()(tag));
+		hash_combine(hash, std::hash<Type>()(ty));
+		hash_combine(hash, std::hash<Ref>()(ref));
+		hash_combine(hash, std::hash<Integer>()(intVal));
+		hash_combine(hash, hashRange(v.begin(), v.end()));
+
+		// Properties of this node
+		flags = 0;
+		switch (tag) {
+		case Call:
+			flags = HasCall;
+			break;
+		case Float:
+		case Int:
+		case NullPtr:
+			flags = IsConstant;
+			break;
+		case GlobalRef:
+			flags = HasGlobalRef;
+			break;
+		case Load:
+			flags = HasLoad;
+			break;
+		case Var:
+			flags = HasVar;
+			break;
+		}
+
+		// Properties inherited from operands
+		for (auto a : v) {
+			flags |= a.flags() & ~IsConstant;
+		}
+
+		// An aggregate of constants is itself a constant
+		switch (tag) {
+		case Array:
+		case Tuple:
+		case Vec:
+			if (std::all_of(v.begin(), v.end(), [](Term a) { return a.constant(); })) {
+				flags |= IsConstant;
+			}
+			break;
+		}
 	}
 };
 
-TermImpl trueImpl(Int, boolTy(), cpp_int(1));
-TermImpl falseImpl(Int, boolTy(), cpp_int(0));
+TermImpl trueImpl(Int, boolTy(), Integer(1));
+TermImpl falseImpl(Int, boolTy(), Integer(0));
 
 TermImpl nullImpl(NullPtr, ptrTy());
 
+// Terms are hash-consed, the same way types are
+// so structurally equal terms always share a single TermImpl
+// and comparison and hashing can work on the pointer alone
+struct TermHash {
+	size_t operator()(const TermImpl& a) const {
+		return a.hash;
+	}
+};
+
+struct TermEqual {
+	bool operator()(const TermImpl& a, const TermImpl& b) const {
+		// Operands are already interned, so comparing the vectors only compares pointers
+		return a.tag == b.tag && a.ty == b.ty && a.ref == b.ref && a.intVal == b.intVal && a.v == b.v;
+	}
+};
+
+Arena<TermImpl> termArena;
+
+class TermInterner {
+	Interner<TermImpl, TermHash, TermEqual> terms;
+
+public:
+	TermInterner() {
+		// Insert the statically allocated constants
+		terms.add(&trueImpl);
+		terms.add(&falseImpl);
+
+		terms.add(&nullImpl);
+	}
+
+	// The key is only copied into the arena if it is not already present
+	// so building a term that already exists allocates nothing
+	TermImpl* intern(const TermImpl& key) {
+		return terms.intern(key, [&]() { return termArena.make(key); });
+	}
+
+	// Forget terms not marked as reachable
+	void sweep() {
+		terms.sweep([](TermImpl* p) { return p->mark; });
+	}
+};
+
+TermInterner termInterner;
+
 Term::Term() {
-	p = new TermImpl(None, voidTy());
+	p = termInterner.intern(TermImpl(None, voidTy()));
 }
 
 Term::Term(Tag tag) {
-	p = new TermImpl(tag, voidTy());
+	p = termInterner.intern(TermImpl(tag, voidTy()));
 }
 
 Term::Term(Tag tag, Type ty, const Ref& ref) {
-	p = new TermImpl(tag, ty, ref);
+	p = termInterner.intern(TermImpl(tag, ty, ref));
 }
 
 Term::Term(Tag tag, Type ty, Term a) {
-	p = new TermImpl(tag, ty, {a});
+	p = termInterner.intern(TermImpl(tag, ty, SmallVec<Term, 3>{a}));
 }
 
 Term::Term(Tag tag, Type ty, Term a, Term b) {
-	p = new TermImpl(tag, ty, {a, b});
+	p = termInterner.intern(TermImpl(tag, ty, SmallVec<Term, 3>{a, b}));
 }
 
 Term::Term(Tag tag, Type ty, Term a, Term b, Term c) {
-	p = new TermImpl(tag, ty, {a, b, c});
+	p = termInterner.intern(TermImpl(tag, ty, SmallVec<Term, 3>{a, b, c}));
 }
 
 Term::Term(Tag tag, Type ty, const vector<Term>& v) {
-	p = new TermImpl(tag, ty, v);
+	p = termInterner.intern(TermImpl(tag, ty, v));
 }
 
 Term::Term(Tag tag, Term a) {
-	p = new TermImpl(tag, a.ty(), {a});
+	p = termInterner.intern(TermImpl(tag, a.ty(), SmallVec<Term, 3>{a}));
 }
 
 Term::Term(Tag tag, Term a, Term b) {
-	p = new TermImpl(tag, a.ty(), {a, b});
+	p = termInterner.intern(TermImpl(tag, a.ty(), SmallVec<Term, 3>{a, b}));
 }
 
 Term ::Term(Tag tag, const vector<Term>& v) {
 	ASSERT(v.size());
-	p = new TermImpl(tag, v[0].ty(), v);
+	p = termInterner.intern(TermImpl(tag, v[0].ty(), v));
 }
 
 Tag Term::tag() const {
@@ -86,7 +192,7 @@ string Term::str() const {
 	return p->ref.str();
 }
 
-cpp_int Term::intVal() const {
+Integer Term::intVal() const {
 	return p->intVal;
 }
 
@@ -99,6 +205,20 @@ Term Term::operator[](size_t i) const {
 	return p->v[i];
 }
 
+unsigned Term::flags() const {
+	return p->flags;
+}
+
+void Term::mark() const {
+	if (p->mark) {
+		return;
+	}
+	p->mark = true;
+	for (auto a : p->v) {
+		a.mark();
+	}
+}
+
 Term::const_iterator Term::begin() const {
 	return p->v.begin();
 }
@@ -108,29 +228,35 @@ Term::const_iterator Term::end() const {
 }
 
 Term::const_iterator Term::cbegin() const {
-	return p->v.cbegin();
+	return p->v.begin();
 }
 
 Term::const_iterator Term::cend() const {
-	return p->v.cend();
+	return p->v.end();
 }
 
-bool Term::operator==(Term b0) const {
-	auto a = p;
-	auto b = b0.p;
-	if (a->tag != b->tag) {
-		return false;
-	}
-	if (a->ty != b->ty) {
-		return false;
-	}
-	if (a->ref != b->ref) {
-		return false;
-	}
-	if (a->intVal != b->intVal) {
-		return false;
-	}
-	return a->v == b->v;
+bool Term::operator==(Term b) const {
+	return p == b.p;
+}
+
+size_t sweepTerms() {
+	// The statically allocated constants are always reachable
+	trueImpl.mark = true;
+	falseImpl.mark = true;
+	nullImpl.mark = true;
+
+	// Terms must be removed from the interner before they are destroyed
+	termInterner.sweep();
+	auto n = termArena.sweep([](TermImpl* p) {
+		auto live = p->mark;
+		p->mark = false;
+		return live;
+	});
+
+	trueImpl.mark = false;
+	falseImpl.mark = false;
+	nullImpl.mark = false;
+	return n;
 }
 
 Term trueConst(&trueImpl);
@@ -138,10 +264,9 @@ Term falseConst(&falseImpl);
 
 Term nullPtrConst(&nullImpl);
 
-Term intConst(Type ty, const cpp_int& val) {
+Term intConst(Type ty, const Integer& val) {
 	ASSERT(ty.kind() == IntKind);
-	auto p = new TermImpl(Int, ty, val);
-	return Term(p);
+	return Term(termInterner.intern(TermImpl(Int, ty, val)));
 }
 
 Term zeroVal(Type ty) {
@@ -220,7 +345,7 @@ Term arrayBytes(unsigned char* v, size_t n) {
 	// Convert each byte to an 8-bit integer Term
 	for (size_t i = 0; i < n; ++i) {
 		// Create an integer constant Term with intTy(8) type and the byte value
-		elements.push_back(intConst(intTy(8), cpp_int(v[i])));
+		elements.push_back(intConst(intTy(8), v[i]));
 	}
 
 	// Create and return an Array Term containing all the byte elements
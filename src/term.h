@@ -132,6 +132,18 @@ enum Tag {
 	Xor,
 };
 
+// Properties of a term, computed once when it is built
+// The Has* flags are true if the term or any of its subterms has the corresponding tag
+enum {
+	HasCall = 1 << 0,
+	HasGlobalRef = 1 << 1,
+	HasLoad = 1 << 2,
+	HasVar = 1 << 3,
+
+	// An Int, Float or NullPtr, or an Array, Tuple or Vec made entirely of them
+	IsConstant = 1 << 4,
+};
+
 struct TermImpl;
 
 class Term {
@@ -168,14 +180,40 @@ public:
 	// Atom data
 	Ref ref() const;
 	string str() const;
-	cpp_int intVal() const;
+	Integer intVal() const;
 
 	// Compound terms contain other terms
 	size_t size() const;
 	Term operator[](size_t i) const;
 
+	// Derived properties
+	unsigned flags() const;
+
+	bool hasCall() const {
+		return flags() & HasCall;
+	}
+
+	bool hasGlobalRef() const {
+		return flags() & HasGlobalRef;
+	}
+
+	bool hasLoad() const {
+		return flags() & HasLoad;
+	}
+
+	bool hasVar() const {
+		return flags() & HasVar;
+	}
+
+	bool constant() const {
+		return flags() & IsConstant;
+	}
+
+	// Mark this term and its subterms as reachable, for garbage collection
+	void mark() const;
+
 	// Iterators
-	using const_iterator = vector<Term>::const_iterator;
+	using const_iterator = const Term*;
 
 	const_iterator begin() const;
 	const_iterator end() const;
@@ -184,27 +222,28 @@ public:
 	const_iterator cend() const;
 
 	// Comparison by value
+	// Terms are interned, so this is just a pointer comparison
 	bool operator==(Term b) const;
 
 	bool operator!=(Term b) const {
 		return !(*this == b);
 	}
+
+	friend struct hash<Term>;
 };
 
 namespace std {
 template <> struct hash<Term> {
 	size_t operator()(const Term& a) const {
-		size_t h = 0;
-		hash_combine(h, hash<Tag>()(a.tag()));
-		hash_combine(h, hash<Type>()(a.ty()));
-		hash_combine(h, hash<Ref>()(a.ref()));
-		hash_combine(h, hash<cpp_int>()(a.intVal()));
-		hash_combine(h, hashRange(a.begin(), a.end()));
-		return h;
+		return hash<TermImpl*>()(a.p);
 	}
 };
 } // namespace std
 
+// Reclaim terms that have not been marked as reachable, and clear the marks on the rest
+// Returns the number of terms reclaimed
+size_t sweepTerms();
+
 extern Term trueConst;
 extern Term falseConst;
 
@@ -216,9 +255,17 @@ inline Term none(Type ty) {
 }
 
 // Integer constants are arbitrary precision
-Term intConst(Type ty, const cpp_int& val);
+Term intConst(Type ty, const Integer& val);
+
+inline Term intConst(Type ty, const cpp_int& val) {
+	return intConst(ty, Integer(val));
+}
+
+template <class T, std::enable_if_t<std::is_integral_v<T>, int> = 0> Term intConst(Type ty, T val) {
+	return intConst(ty, Integer(val));
+}
 
-inline Term intConst(const cpp_int& val) {
+inline Term intConst(const Integer& val) {
 	return intConst(intTy(64), val);
 }
 
@@ -5,6 +5,12 @@ struct TypeImpl {
 	const size_t len;
 	const vector<Type> v;
 
+	// Cached by DataLayout
+	std::atomic<const Layout*> layouts{nullptr};
+
+	// Cached by the printer
+	std::atomic<const string*> spelling{nullptr};
+
 	explicit TypeImpl(Kind kind): kind(kind), len(0) {
 	}
 
@@ -16,6 +22,10 @@ struct TypeImpl {
 
 	TypeImpl(Kind kind, const vector<Type>& v): kind(kind), len(0), v(v) {
 	}
+
+	// Copies the key used for lookup in the interner, which has nothing cached yet
+	TypeImpl(const TypeImpl& b): kind(b.kind), len(b.len), v(b.v) {
+	}
 };
 
 TypeImpl voidImpl(VoidKind);
@@ -27,47 +37,43 @@ TypeImpl doubleImpl(DoubleKind);
 
 TypeImpl ptrImpl(PtrKind);
 
-class TypeInterner {
-	struct TypeHash {
-		size_t operator()(const TypeImpl* p) const {
-			size_t h = hash<Kind>()(p->kind);
-			h ^= hash<size_t>()(p->len) + 0x9e3779b9 + (h << 6) + (h >> 2);
-			for (const auto& t : p->v) {
-				h ^= hash<Type>()(t) + 0x9e3779b9 + (h << 6) + (h >> 2);
-			}
-			return h;
+struct TypeHash {
+	size_t operator()(const TypeImpl& a) const {
+		size_t h = hash<Kind>()(a.kind);
+		h ^= hash<size_t>()(a.len) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		for (const auto& t : a.v) {
+			h ^= hash<Type>()(t) + 0x9e3779b9 + (h << 6) + (h >> 2);
 		}
-	};
+		return h;
+	}
+};
 
-	struct TypeEqual {
-		bool operator()(const TypeImpl* a, const TypeImpl* b) const {
-			return a->kind == b->kind && a->len == b->len && a->v == b->v;
-		}
-	};
+struct TypeEqual {
+	bool operator()(const TypeImpl& a, const TypeImpl& b) const {
+		return a.kind == b.kind && a.len == b.len && a.v == b.v;
+	}
+};
 
-	unordered_set<TypeImpl*, TypeHash, TypeEqual> tys;
+// Types are never freed, so the interner needs no sweep
+class TypeInterner {
+	Interner<TypeImpl, TypeHash, TypeEqual> tys;
 
 public:
 	TypeInterner() {
 		// Insert the primitive types
-		tys.insert(&voidImpl);
+		tys.add(&voidImpl);
 
-		tys.insert(&boolImpl);
+		tys.add(&boolImpl);
 
-		tys.insert(&floatImpl);
-		tys.insert(&doubleImpl);
+		tys.add(&floatImpl);
+		tys.add(&doubleImpl);
 
-		tys.insert(&ptrImpl);
+		tys.add(&ptrImpl);
 	}
 
-	TypeImpl* intern(TypeImpl* ty) {
-		auto it = tys.find(ty);
-		if (it != tys.end()) {
-			delete ty; // Delete the duplicate
-			return *it;
-		}
-		tys.insert(ty);
-		return ty;
+	// The key is only copied to the heap if it is not already present
+	Type intern(const TypeImpl& key) {
+		return Type(tys.intern(key, [&]() { return new TypeImpl(key); }));
 	}
 };
 
@@ -109,6 +115,31 @@ Type::const_iterator Type::cend() const {
 	return p->v.cend();
 }
 
+const Layout* Type::layouts() const {
+	return p->layouts.load(std::memory_order_acquire);
+}
+
+void Type::addLayout(Layout* layout) const {
+	// Another thread may be adding a layout at the same time
+	auto head = p->layouts.load(std::memory_order_relaxed);
+	do {
+		layout->next = head;
+	} while (!p->layouts.compare_exchange_weak(head, layout, std::memory_order_release, std::memory_order_relaxed));
+}
+
+const string* Type::spelling() const {
+	return p->spelling.load(std::memory_order_acquire);
+}
+
+const string* Type::setSpelling(const string* s) const {
+	const string* old = nullptr;
+	if (p->spelling.compare_exchange_strong(old, s, std::memory_order_acq_rel)) {
+		return s;
+	}
+	delete s;
+	return old;
+}
+
 bool Type::operator==(Type b0) const {
 	auto a = p;
 	auto b = b0.p;
@@ -137,8 +168,7 @@ Type boolTy() {
 
 Type intTy(size_t len) {
 	ASSERT(len);
-	auto p = new TypeImpl(IntKind, len);
-	return Type(tyInterner.intern(p));
+	return tyInterner.intern(TypeImpl(IntKind, len));
 }
 
 Type floatTy() {
@@ -158,22 +188,19 @@ Type ptrTy() {
 
 Type vecTy(size_t len, Type element) {
 	ASSERT(element != voidTy());
-	auto p = new TypeImpl(VecKind, len, element);
-	return Type(tyInterner.intern(p));
+	return tyInterner.intern(TypeImpl(VecKind, len, element));
 }
 
 Type arrayTy(size_t len, Type element) {
 	ASSERT(element != voidTy());
-	auto p = new TypeImpl(ArrayKind, len, element);
-	return Type(tyInterner.intern(p));
+	return tyInterner.intern(TypeImpl(ArrayKind, len, element));
 }
 
 Type structTy(const vector<Type>& fields) {
 	for (auto field : fields) {
 		ASSERT(field != voidTy());
 	}
-	auto p = new TypeImpl(StructKind, fields);
-	return Type(tyInterner.intern(p));
+	return tyInterner.intern(TypeImpl(StructKind, fields));
 }
 
 Type fnTy(const vector<Type>& v) {
@@ -181,8 +208,7 @@ Type fnTy(const vector<Type>& v) {
 	for (size_t i = 1; i != v.size(); ++i) {
 		ASSERT(v[i] != voidTy());
 	}
-	auto p = new TypeImpl(FuncKind, v);
-	return Type(tyInterner.intern(p));
+	return tyInterner.intern(TypeImpl(FuncKind, v));
 }
 
 Type fnTy(Type rty, const vector<Type>& params) {
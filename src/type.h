@@ -20,6 +20,7 @@ enum Kind {
 };
 
 struct TypeImpl;
+struct Layout;
 
 class Type {
 	TypeImpl* p;
@@ -58,6 +59,18 @@ public:
 	const_iterator cbegin() const;
 	const_iterator cend() const;
 
+	// Layouts computed for this type, one per DataLayout in use
+	// For internal use by DataLayout
+	const Layout* layouts() const;
+	void addLayout(Layout* layout) const;
+
+	// The type as printed in LLVM format, cached by the printer
+	// For internal use by the printer
+	// setSpelling takes ownership of s
+	// Another thread may have set it first, in which case s is deleted, and the existing spelling returned
+	const string* spelling() const;
+	const string* setSpelling(const string* s) const;
+
 	// Comparison by value
 	bool operator==(Type b) const;
 	bool operator!=(Type b) const;
@@ -0,0 +1,213 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include "module-text.h"
+
+BOOST_AUTO_TEST_SUITE(BitcodeTests)
+
+// Made by llvm-as from this text
+static const char text[] =
+	"@g = global i32 5\n"
+	"define i32 @f(i32 %x, ptr %p) {\n"
+	"  %y = add i32 %x, 1\n"
+	"  store i32 %y, ptr %p\n"
+	"  %c = icmp sgt i32 %y, 2\n"
+	"  br i1 %c, label %a, label %b\n"
+	"a:\n"
+	"  br label %b\n"
+	"b:\n"
+	"  %r = phi i32 [ %y, %0 ], [ 0, %a ]\n"
+	"  ret i32 %r\n"
+	"}\n";
+
+static const unsigned char bitcode[] = {
+	0x42, 0x43, 0xc0, 0xde, 0x35, 0x14, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x62, 0x0c, 0x30, 0x24,
+	0x4a, 0x59, 0xbe, 0x66, 0x8d, 0xfb, 0xb4, 0xaf, 0x0b, 0x51, 0x80, 0x4c, 0x01, 0x00, 0x00, 0x00,
+	0x21, 0x0c, 0x00, 0x00, 0x1c, 0x01, 0x00, 0x00, 0x0b, 0x02, 0x21, 0x00, 0x02, 0x00, 0x00, 0x00,
+	0x16, 0x00, 0x00, 0x00, 0x07, 0x81, 0x23, 0x91, 0x41, 0xc8, 0x04, 0x49, 0x06, 0x10, 0x32, 0x39,
+	0x92, 0x01, 0x84, 0x0c, 0x25, 0x05, 0x08, 0x19, 0x1e, 0x04, 0x8b, 0x62, 0x80, 0x0c, 0x45, 0x02,
+	0x42, 0x92, 0x0b, 0x42, 0x64, 0x10, 0x32, 0x14, 0x38, 0x08, 0x18, 0x4b, 0x0a, 0x32, 0x32, 0x88,
+	0x48, 0x70, 0xc4, 0x21, 0x23, 0x44, 0x12, 0x87, 0x8c, 0x10, 0x41, 0x92, 0x02, 0x64, 0xc8, 0x08,
+	0xb1, 0x14, 0x20, 0x43, 0x46, 0x88, 0x20, 0xc9, 0x01, 0x32, 0x32, 0x84, 0x18, 0x2a, 0x28, 0x2a,
+	0x90, 0x31, 0x7c, 0xb0, 0x5c, 0x91, 0x20, 0xc3, 0xc8, 0x00, 0x00, 0x00, 0x89, 0x20, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x32, 0x22, 0xc8, 0x08, 0x20, 0x62, 0x46, 0x00, 0x21, 0x2b, 0x24, 0x98,
+	0x0c, 0x21, 0x25, 0x24, 0x98, 0x0c, 0x19, 0x27, 0x0c, 0x85, 0xa4, 0x90, 0x60, 0x32, 0x64, 0x5c,
+	0x20, 0x24, 0x63, 0x82, 0xe0, 0xa8, 0x39, 0x02, 0x30, 0x30, 0x43, 0x82, 0x81, 0x80, 0x11, 0x80,
+	0x39, 0x82, 0x60, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x4a, 0x0f, 0x08, 0x11, 0x92, 0x40, 0x86, 0x8c,
+	0x94, 0x00, 0x01, 0x34, 0x42, 0x18, 0x96, 0xa0, 0xfc, 0x65, 0x21, 0x40, 0x40, 0x61, 0x00, 0x43,
+	0xaa, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	0x40, 0x62, 0x83, 0x40, 0x61, 0x90, 0x00, 0x00, 0x80, 0x2c, 0x10, 0x00, 0x05, 0x00, 0x00, 0x00,
+	0x32, 0x1e, 0x98, 0x08, 0x19, 0x11, 0x4c, 0x90, 0x8c, 0x09, 0x26, 0x47, 0xc6, 0x04, 0x43, 0x4a,
+	0x29, 0x00, 0x00, 0x00, 0xb1, 0x18, 0x00, 0x00, 0x97, 0x00, 0x00, 0x00, 0x33, 0x08, 0x80, 0x1c,
+	0xc4, 0xe1, 0x1c, 0x66, 0x14, 0x01, 0x3d, 0x88, 0x43, 0x38, 0x84, 0xc3, 0x8c, 0x42, 0x80, 0x07,
+	0x79, 0x78, 0x07, 0x73, 0x98, 0x71, 0x0c, 0xe6, 0x00, 0x0f, 0xed, 0x10, 0x0e, 0xf4, 0x80, 0x0e,
+	0x33, 0x0c, 0x42, 0x1e, 0xc2, 0xc1, 0x1d, 0xce, 0xa1, 0x1c, 0x66, 0x30, 0x05, 0x3d, 0x88, 0x43,
+	0x38, 0x84, 0x83, 0x1b, 0xcc, 0x03, 0x3d, 0xc8, 0x43, 0x3d, 0x8c, 0x03, 0x3d, 0xcc, 0x78, 0x8c,
+	0x74, 0x70, 0x07, 0x7b, 0x08, 0x07, 0x79, 0x48, 0x87, 0x70, 0x70, 0x07, 0x7a, 0x70, 0x03, 0x76,
+	0x78, 0x87, 0x70, 0x20, 0x87, 0x19, 0xcc, 0x11, 0x0e, 0xec, 0x90, 0x0e, 0xe1, 0x30, 0x0f, 0x6e,
+	0x30, 0x0f, 0xe3, 0xf0, 0x0e, 0xf0, 0x50, 0x0e, 0x33, 0x10, 0xc4, 0x1d, 0xde, 0x21, 0x1c, 0xd8,
+	0x21, 0x1d, 0xc2, 0x61, 0x1e, 0x66, 0x30, 0x89, 0x3b, 0xbc, 0x83, 0x3b, 0xd0, 0x43, 0x39, 0xb4,
+	0x03, 0x3c, 0xbc, 0x83, 0x3c, 0x84, 0x03, 0x3b, 0xcc, 0xf0, 0x14, 0x76, 0x60, 0x07, 0x7b, 0x68,
+	0x07, 0x37, 0x68, 0x87, 0x72, 0x68, 0x07, 0x37, 0x80, 0x87, 0x70, 0x90, 0x87, 0x70, 0x60, 0x07,
+	0x76, 0x28, 0x07, 0x76, 0xf8, 0x05, 0x76, 0x78, 0x87, 0x77, 0x80, 0x87, 0x5f, 0x08, 0x87, 0x71,
+	0x18, 0x87, 0x72, 0x98, 0x87, 0x79, 0x98, 0x81, 0x2c, 0xee, 0xf0, 0x0e, 0xee, 0xe0, 0x0e, 0xf5,
+	0xc0, 0x0e, 0xec, 0x30, 0x03, 0x62, 0xc8, 0xa1, 0x1c, 0xe4, 0xa1, 0x1c, 0xcc, 0xa1, 0x1c, 0xe4,
+	0xa1, 0x1c, 0xdc, 0x61, 0x1c, 0xca, 0x21, 0x1c, 0xc4, 0x81, 0x1d, 0xca, 0x61, 0x06, 0xd6, 0x90,
+	0x43, 0x39, 0xc8, 0x43, 0x39, 0x98, 0x43, 0x39, 0xc8, 0x43, 0x39, 0xb8, 0xc3, 0x38, 0x94, 0x43,
+	0x38, 0x88, 0x03, 0x3b, 0x94, 0xc3, 0x2f, 0xbc, 0x83, 0x3c, 0xfc, 0x82, 0x3b, 0xd4, 0x03, 0x3b,
+	0xb0, 0xc3, 0x0c, 0xc7, 0x69, 0x87, 0x70, 0x58, 0x87, 0x72, 0x70, 0x83, 0x74, 0x68, 0x07, 0x78,
+	0x60, 0x87, 0x74, 0x18, 0x87, 0x74, 0xa0, 0x87, 0x19, 0xce, 0x53, 0x0f, 0xee, 0x00, 0x0f, 0xf2,
+	0x50, 0x0e, 0xe4, 0x90, 0x0e, 0xe3, 0x40, 0x0f, 0xe1, 0x20, 0x0e, 0xec, 0x50, 0x0e, 0x33, 0x20,
+	0x28, 0x1d, 0xdc, 0xc1, 0x1e, 0xc2, 0x41, 0x1e, 0xd2, 0x21, 0x1c, 0xdc, 0x81, 0x1e, 0xdc, 0xe0,
+	0x1c, 0xe4, 0xe1, 0x1d, 0xea, 0x01, 0x1e, 0x66, 0x18, 0x51, 0x38, 0xb0, 0x43, 0x3a, 0x9c, 0x83,
+	0x3b, 0xcc, 0x50, 0x24, 0x76, 0x60, 0x07, 0x7b, 0x68, 0x07, 0x37, 0x60, 0x87, 0x77, 0x78, 0x07,
+	0x78, 0x98, 0x51, 0x4c, 0xf4, 0x90, 0x0f, 0xf0, 0x50, 0x0e, 0x33, 0x1e, 0x6a, 0x1e, 0xca, 0x61,
+	0x1c, 0xe8, 0x21, 0x1d, 0xde, 0xc1, 0x1d, 0x7e, 0x01, 0x1e, 0xe4, 0xa1, 0x1c, 0xcc, 0x21, 0x1d,
+	0xf0, 0x61, 0x06, 0x54, 0x85, 0x83, 0x38, 0xcc, 0xc3, 0x3b, 0xb0, 0x43, 0x3d, 0xd0, 0x43, 0x39,
+	0xfc, 0xc2, 0x3c, 0xe4, 0x43, 0x3b, 0x88, 0xc3, 0x3b, 0xb0, 0xc3, 0x8c, 0xc5, 0x0a, 0x87, 0x79,
+	0x98, 0x87, 0x77, 0x18, 0x87, 0x74, 0x08, 0x07, 0x7a, 0x28, 0x07, 0x72, 0x98, 0x81, 0x5c, 0xe3,
+	0x10, 0x0e, 0xec, 0xc0, 0x0e, 0xe5, 0x50, 0x0e, 0xf3, 0x30, 0x23, 0xc1, 0xd2, 0x41, 0x1e, 0xe4,
+	0xe1, 0x17, 0xd8, 0xe1, 0x1d, 0xde, 0x01, 0x1e, 0x66, 0x48, 0x19, 0x3b, 0xb0, 0x83, 0x3d, 0xb4,
+	0x83, 0x1b, 0x84, 0xc3, 0x38, 0x8c, 0x43, 0x39, 0xcc, 0xc3, 0x3c, 0xb8, 0xc1, 0x39, 0xc8, 0xc3,
+	0x3b, 0xd4, 0x03, 0x3c, 0xcc, 0x48, 0xb4, 0x71, 0x08, 0x07, 0x76, 0x60, 0x07, 0x71, 0x08, 0x87,
+	0x71, 0x58, 0x87, 0x19, 0xdb, 0xc6, 0x0e, 0xec, 0x60, 0x0f, 0xed, 0xe0, 0x06, 0xf0, 0x20, 0x0f,
+	0xe5, 0x30, 0x0f, 0xe5, 0x20, 0x0f, 0xf6, 0x50, 0x0e, 0x6e, 0x10, 0x0e, 0xe3, 0x30, 0x0e, 0xe5,
+	0x30, 0x0f, 0xf3, 0xe0, 0x06, 0xe9, 0xe0, 0x0e, 0xe4, 0x50, 0x0e, 0xf8, 0x30, 0x23, 0xe2, 0xec,
+	0x61, 0x1c, 0xc2, 0x81, 0x1d, 0xd8, 0xe1, 0x17, 0xec, 0x21, 0x1d, 0xe6, 0x21, 0x1d, 0xc4, 0x21,
+	0x1d, 0xd8, 0x21, 0x1d, 0xe8, 0x21, 0x1f, 0x66, 0x20, 0x9d, 0x3b, 0xbc, 0x43, 0x3d, 0xb8, 0x03,
+	0x39, 0x94, 0x83, 0x39, 0xcc, 0x58, 0xbc, 0x70, 0x70, 0x07, 0x77, 0x78, 0x07, 0x7a, 0x08, 0x07,
+	0x7a, 0x48, 0x87, 0x77, 0x70, 0x07, 0x00, 0x00, 0xa9, 0x18, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00,
+	0x0b, 0x0a, 0x72, 0x28, 0x87, 0x77, 0x80, 0x07, 0x7a, 0x58, 0x70, 0x98, 0x43, 0x3d, 0xb8, 0xc3,
+	0x38, 0xb0, 0x43, 0x39, 0xd0, 0xc3, 0x82, 0xe6, 0x1c, 0xc6, 0xa1, 0x0d, 0xe8, 0x41, 0x1e, 0xc2,
+	0xc1, 0x1d, 0xe6, 0x21, 0x1d, 0xe8, 0x21, 0x1d, 0xde, 0xc1, 0x1d, 0x16, 0x34, 0xe3, 0x60, 0x0e,
+	0xe7, 0x50, 0x0f, 0xe1, 0x20, 0x0f, 0xe4, 0x40, 0x0f, 0xe1, 0x20, 0x0f, 0xe7, 0x50, 0x0e, 0xf4,
+	0xb0, 0x80, 0x81, 0x07, 0x79, 0x28, 0x87, 0x70, 0x60, 0x07, 0x76, 0x78, 0x87, 0x71, 0x08, 0x07,
+	0x7a, 0x28, 0x07, 0x72, 0x58, 0x70, 0x9c, 0xc3, 0x38, 0xb4, 0x01, 0x3b, 0xa4, 0x83, 0x3d, 0x94,
+	0xc3, 0x02, 0x6b, 0x1c, 0xd8, 0x21, 0x1c, 0xdc, 0xe1, 0x1c, 0xdc, 0x20, 0x1c, 0xe4, 0x61, 0x1c,
+	0xdc, 0x20, 0x1c, 0xe8, 0x81, 0x1e, 0xc2, 0x61, 0x1c, 0xd0, 0xa1, 0x1c, 0xc8, 0x61, 0x1c, 0xc2,
+	0x81, 0x1d, 0xd8, 0x01, 0xd1, 0x10, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x07, 0xcc, 0x3c, 0xa4,
+	0x83, 0x3b, 0x9c, 0x03, 0x3b, 0x94, 0x03, 0x3d, 0xa0, 0x83, 0x3c, 0x94, 0x43, 0x38, 0x90, 0xc3,
+	0x01, 0x00, 0x00, 0x00, 0x61, 0x20, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x13, 0x04, 0x43, 0x2c,
+	0x10, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x94, 0x12, 0x28, 0x82, 0x11, 0x00, 0x00, 0x00,
+	0x57, 0x0c, 0x30, 0x6c, 0x40, 0x14, 0xc1, 0x00, 0x0c, 0x37, 0x04, 0x83, 0x19, 0xcc, 0x32, 0x04,
+	0x42, 0x30, 0x4b, 0x20, 0x0c, 0x54, 0x04, 0x04, 0x60, 0x04, 0x1b, 0x84, 0x03, 0x01, 0x00, 0x00,
+	0x06, 0x00, 0x00, 0x00, 0x46, 0x10, 0x3c, 0x17, 0x10, 0x00, 0x27, 0x10, 0x04, 0x96, 0x10, 0x08,
+	0xa6, 0x10, 0x44, 0x36, 0x10, 0x5c, 0x86, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x71, 0x20, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x32, 0x0e, 0x10, 0x22, 0x84, 0x01, 0x89, 0x02,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5d, 0x0c, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+	0x12, 0x03, 0x94, 0x0c, 0x67, 0x66, 0x31, 0x34, 0x2e, 0x30, 0x2e, 0x36, 0x75, 0x2e, 0x6c, 0x6c,
+	0x00, 0x00, 0x00, 0x00,
+};
+
+static std::string_view data() {
+	return std::string_view((const char*)bitcode, sizeof bitcode);
+}
+
+BOOST_AUTO_TEST_CASE(Magic) {
+	BOOST_CHECK(isBitcode(data()));
+	BOOST_CHECK(!isBitcode(text));
+	BOOST_CHECK(!isBitcode(""));
+}
+
+BOOST_AUTO_TEST_CASE(SameAsParse) {
+	std::unique_ptr<Module> read(readBitcode("test.bc", data()));
+	std::unique_ptr<Module> parsed(parse(text));
+	BOOST_CHECK_EQUAL(str(*read), str(*parsed));
+}
+
+BOOST_AUTO_TEST_CASE(Wrapper) {
+	// Magic, version, offset, size, CPU type
+	string s;
+	for (uint32_t x : {0x0b17c0deu, 0u, 20u, uint32_t(sizeof bitcode), 0u}) {
+		for (int i = 0; i < 4; i++) {
+			s += char(x >> (i * 8));
+		}
+	}
+	s += data();
+	BOOST_CHECK(isBitcode(s));
+	std::unique_ptr<Module> read(readBitcode("test.bc", s));
+	std::unique_ptr<Module> parsed(parse(text));
+	BOOST_CHECK_EQUAL(str(*read), str(*parsed));
+}
+
+BOOST_AUTO_TEST_CASE(Truncated) {
+	BOOST_CHECK_THROW(readBitcode("test.bc", data().substr(0, sizeof bitcode / 2)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(AbbrevWidth) {
+	for (unsigned width : {0, 1, 33, 64}) {
+		BitstreamWriter w;
+		w.enterBlock(8, 3);
+		w.defineAbbrev({{AbbrevOp::Literal, 1}, {AbbrevOp::VBR, width}});
+		w.endBlock();
+
+		BitstreamReader r(w.str());
+		unsigned id;
+		BOOST_CHECK_EQUAL(r.advance(id), BitstreamReader::Block);
+		r.enterBlock(id);
+		BOOST_CHECK_EXCEPTION(r.advance(id), runtime_error, [](const runtime_error& e) {
+			return string(e.what()) == "invalid bitcode: abbreviation field width";
+		});
+	}
+}
+
+static string writeRead(const Module& module) {
+	std::unique_ptr<Module> read(readBitcode("test.bc", writeBitcode(module)));
+	return str(*read);
+}
+
+BOOST_AUTO_TEST_CASE(Write) {
+	std::unique_ptr<Module> module(parse(text));
+	BOOST_CHECK_EQUAL(writeRead(*module), str(*module));
+
+	const char text2[] = "target triple = \"x86_64-pc-linux-gnu\"\n"
+						 "@s = global [3 x i8] c\"hi\\00\"\n"
+						 "@a = global [2 x i32] zeroinitializer\n"
+						 "@p = global ptr @a\n"
+						 "@big = global i128 -170141183460469231731687303715884105728\n"
+						 "@fl = global float 0x3FB99999A0000000\n"
+						 "declare i32 @h(ptr, i32, double)\n"
+						 "declare void @g(double)\n"
+						 "define i32 @main(i32 %n) {\n"
+						 "entry:\n"
+						 "  %x = alloca i32, i32 %n\n"
+						 "  %c = icmp ne i32 %n, 3\n"
+						 "  %d = sitofp i32 %n to double\n"
+						 "  call void @g(double %d)\n"
+						 "  %r = call i32 @h(ptr @s, i32 %n, double %d)\n"
+						 "  br i1 %c, label %loop, label %end\n"
+						 "loop:\n"
+						 "  %i = phi i32 [ 0, %entry ], [ %j, %loop ]\n"
+						 "  %j = add i32 %i, 1\n"
+						 "  store i32 %j, ptr %x\n"
+						 "  switch i32 %j, label %loop [\n"
+						 "    i32 10, label %end\n"
+						 "  ]\n"
+						 "end:\n"
+						 "  ret i32 %r\n"
+						 "}\n";
+	module.reset(parse(text2));
+	BOOST_CHECK_EQUAL(writeRead(*module), str(*module));
+}
+
+BOOST_AUTO_TEST_CASE(WriteOddWidths) {
+	// LLVM takes arrays of these as data only for the usual widths, so they are written element by element
+	Module module;
+	auto i1 = intTy(1);
+	auto i24 = intTy(24);
+	module.globals.push_back(Global(arrayTy(2, i1), "b", array(i1, {intConst(i1, 1), intConst(i1, 0)})));
+	module.globals.push_back(Global(arrayTy(2, i24), "c", array(i24, {intConst(i24, 1), intConst(i24, -2)})));
+	BOOST_CHECK_EQUAL(writeRead(module), str(module));
+}
+
+BOOST_AUTO_TEST_CASE(WriteNested) {
+	// Nested operands are linearized as for printing
+	auto x = var(intTy(32), "x");
+	auto square = Term(Mul, intTy(32), x, x);
+	vector<Inst> body;
+	body.push_back(ret(Term(Add, intTy(32), square, square)));
+	Module module;
+	module.defs.push_back(Fn(intTy(32), "f", {x}, body));
+	BOOST_CHECK_EQUAL(writeRead(module), str(module));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
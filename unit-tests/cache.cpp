@@ -0,0 +1,95 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include "module-text.h"
+
+BOOST_AUTO_TEST_SUITE(CacheTests)
+
+static const char text[] = "target datalayout = \"e-m:e-i64:64\"\n"
+						   "$c = comdat any\n"
+						   "@g = global i32 5\n"
+						   "@big = global i128 -170141183460469231731687303715884105728\n"
+						   "@s = global [3 x i8] c\"ab\\00\"\n"
+						   "declare void @h(ptr, double)\n"
+						   "define i32 @f(i32 %x, ptr %p) {\n"
+						   "  %y = add i32 %x, -1\n"
+						   "  store i32 %y, ptr %p\n"
+						   "  %c = icmp sgt i32 %y, 2\n"
+						   "  br i1 %c, label %a, label %b\n"
+						   "a:\n"
+						   "  call void @h(ptr %p, double 1.5)\n"
+						   "  br label %b\n"
+						   "b:\n"
+						   "  %r = phi i32 [ %y, %0 ], [ 0, %a ]\n"
+						   "  ret i32 %r\n"
+						   "}\n";
+
+static string image(const Module& module, uint64_t hash) {
+	std::ostringstream os;
+	writeCache(os, module, hash);
+	return os.str();
+}
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+	std::unique_ptr<Module> module(parse(text));
+	auto s = image(*module, contentHash(text));
+	BOOST_CHECK(isCache(s, contentHash(text)));
+
+	std::unique_ptr<Module> loaded(readCache("test.olivine", s));
+	BOOST_CHECK_EQUAL(str(*loaded), str(*module));
+	BOOST_CHECK(loaded->comdats == module->comdats);
+
+	// Terms are interned, so loading gives the same ones
+	BOOST_CHECK(loaded->globals[1].val() == module->globals[1].val());
+
+	// The output does not depend on the order of anything unordered in memory
+	BOOST_CHECK_EQUAL(image(*loaded, contentHash(text)), s);
+}
+
+BOOST_AUTO_TEST_CASE(Stale) {
+	std::unique_ptr<Module> module(parse(text));
+	auto s = image(*module, contentHash(text));
+	BOOST_CHECK(!isCache(s, contentHash("")));
+	BOOST_CHECK(!isCache(text, contentHash(text)));
+	BOOST_CHECK(!isCache("", contentHash(text)));
+}
+
+BOOST_AUTO_TEST_CASE(Truncated) {
+	std::unique_ptr<Module> module(parse(text));
+	auto s = image(*module, 0);
+	for (size_t n : {size_t(0), size_t(24), s.size() / 2, s.size() - 1}) {
+		BOOST_CHECK_THROW(readCache("test.olivine", s.substr(0, n)), runtime_error);
+	}
+}
+
+// A body that is complete but describes IR that cannot exist is rejected like any other invalid cache
+// so the caller can fall back to parsing
+BOOST_AUTO_TEST_CASE(CorruptBody) {
+	std::unique_ptr<Module> module(parse(text));
+	auto header = image(*module, 0).substr(0, 24);
+
+	// No names, and an integer type of width zero
+	auto zeroWidth = header + string{0, 1, char(IntKind), 0};
+
+	// No names, a pointer type, and an integer constant of that type
+	auto ptrInt = header + string{0, 1, char(PtrKind), 1, char(Int), 0, 0, 0, 0};
+
+	for (auto& s : {zeroWidth, ptrInt}) {
+		try {
+			readCache("test.olivine", s);
+			BOOST_FAIL("expected exception");
+		} catch (const runtime_error& e) {
+			BOOST_CHECK_EQUAL(string(e.what()), "test.olivine: invalid cache");
+		}
+	}
+}
+
+// Caches from a build that numbered things differently are not recognized
+BOOST_AUTO_TEST_CASE(OtherVersion) {
+	std::unique_ptr<Module> module(parse(text));
+	auto s = image(*module, 0);
+	BOOST_CHECK(isCache(s, 0));
+	s[8] ^= 1;
+	BOOST_CHECK(!isCache(s, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
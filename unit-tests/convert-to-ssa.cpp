@@ -0,0 +1,45 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(ConvertToSSATests)
+
+BOOST_AUTO_TEST_CASE(LowersAssignedVariables) {
+	Type i32 = intTy(32);
+	Term a = var(i32, "a");
+	Term x = var(i32, "x");
+	Fn f(i32, "f", {a}, {assign(x, a), ret(x)});
+	Fn g = convertToSSA(f);
+
+	Term pa = var(ptrTy(), "a");
+	Term px = var(ptrTy(), "x");
+	Term one = intConst(intTy(64), 1);
+	BOOST_REQUIRE_EQUAL(g.size(), 4);
+	BOOST_CHECK(g[0] == alloca(px, i32, one));
+	BOOST_CHECK(g[1] == alloca(pa, i32, one));
+	BOOST_CHECK(g[2] == store(a, px));
+	BOOST_CHECK(g[3] == ret(Term(Load, i32, px)));
+	BOOST_CHECK(g.params() == f.params());
+}
+
+BOOST_AUTO_TEST_CASE(SkipsUnnamedParams) {
+	Type i32 = intTy(32);
+	Fn f(i32, "f", {none(i32)}, {ret(intConst(i32, 0))});
+	Fn g = convertToSSA(f);
+
+	BOOST_REQUIRE_EQUAL(g.size(), 1);
+	BOOST_CHECK(g[0] == ret(intConst(i32, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(SkipsVarargs) {
+	Type i32 = intTy(32);
+	Term a = var(i32, "a");
+	Fn f(i32, "f", {a, Term(Array)}, {ret(a)});
+	Fn g = convertToSSA(f);
+
+	Term pa = var(ptrTy(), "a");
+	BOOST_REQUIRE_EQUAL(g.size(), 2);
+	BOOST_CHECK(g[0] == alloca(pa, i32, intConst(intTy(64), 1)));
+	BOOST_CHECK(g[1] == ret(Term(Load, i32, pa)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
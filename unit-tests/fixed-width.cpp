@@ -55,4 +55,54 @@ BOOST_AUTO_TEST_CASE(test_edge_cases) {
 	BOOST_CHECK_EQUAL(fw::ashr(8, 4, 4), 15); // Sign extends 1000 to 1111
 }
 
+// The native versions for common widths must agree with the arbitrary precision versions
+BOOST_AUTO_TEST_CASE(test_native_widths) {
+	using fn = cpp_int (*)(const cpp_int&, const cpp_int&, std::size_t);
+
+	// Operations whose results are the same at any wider width, once truncated
+	fn unsignedOps[] = {fw::add, fw::sub, fw::mul, fw::udiv, fw::urem, fw::and_, fw::or_, fw::xor_, fw::eq, fw::ne, fw::ult, fw::ule};
+
+	for (std::size_t bits : {1, 8, 16, 32, 64}) {
+		auto mask = detail::create_mask(bits);
+		vector<cpp_int> vals = {0, 1, 3, mask, mask - 1, mask >> 1, (mask >> 1) + 1};
+		for (auto& a : vals) {
+			for (auto& b : vals) {
+				if (a > mask || b > mask) {
+					continue;
+				}
+				auto sa = detail::to_signed(a, bits);
+				auto sb = detail::to_signed(b, bits);
+
+				// Compare against the next width up, which has no native version
+				for (auto op : unsignedOps) {
+					if ((op == fw::udiv || op == fw::urem) && b == 0) {
+						continue;
+					}
+					BOOST_CHECK_EQUAL(op(a, b, bits), op(a, b, bits + 1) & mask);
+				}
+
+				// Signed operations
+				if (b != 0) {
+					BOOST_CHECK_EQUAL(fw::sdiv(a, b, bits), detail::to_unsigned(sa / sb, bits) & mask);
+					BOOST_CHECK_EQUAL(fw::srem(a, b, bits), detail::to_unsigned(sa % sb, bits));
+				}
+				BOOST_CHECK_EQUAL(fw::slt(a, b, bits), sa < sb);
+				BOOST_CHECK_EQUAL(fw::sle(a, b, bits), sa <= sb);
+
+				// Shifts
+				if (b < bits) {
+					auto n = b.convert_to<unsigned>();
+					BOOST_CHECK_EQUAL(fw::shl(a, b, bits), (a << n) & mask);
+					BOOST_CHECK_EQUAL(fw::lshr(a, b, bits), a >> n);
+					BOOST_CHECK_EQUAL(fw::ashr(a, b, bits), detail::to_unsigned(sa >> n, bits));
+				} else {
+					BOOST_CHECK_EQUAL(fw::shl(a, b, bits), 0);
+					BOOST_CHECK_EQUAL(fw::lshr(a, b, bits), 0);
+					BOOST_CHECK_EQUAL(fw::ashr(a, b, bits), sa < 0 ? mask : 0);
+				}
+			}
+		}
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
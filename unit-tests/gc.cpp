@@ -0,0 +1,56 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(CollectKeepsReachable) {
+	modules.clear();
+	context = Module{};
+
+	Type i32 = intTy(32);
+	Term x = var(i32, "x");
+	Term y = var(i32, "y");
+	context.globals.push_back(Global(i32, "g", intConst(i32, 123)));
+	context.defs.push_back(Fn(i32, "f", {x, y}, {ret(Term(Add, x, Term(Mul, y, intConst(i32, 3))))}));
+
+	// Garbage from an abandoned rewrite
+	for (int i = 0; i < 100; i++) {
+		Fn(i32, "f", {x, y}, {ret(Term(Sub, x, intConst(i32, i)))});
+	}
+
+	BOOST_CHECK_GT(collect(), 0);
+
+	// Everything reachable from context is intact
+	auto g = context.globals[0];
+	BOOST_CHECK_EQUAL(g.ref(), Ref("g"));
+	BOOST_CHECK_EQUAL(g.val().intVal(), 123);
+
+	auto f = context.defs[0];
+	BOOST_CHECK_EQUAL(f.size(), 1);
+	auto a = f[0][0];
+	BOOST_CHECK_EQUAL(a.tag(), Add);
+	BOOST_CHECK_EQUAL(a[0].ref(), Ref("x"));
+	BOOST_CHECK_EQUAL(a[1][1].intVal(), 3);
+
+	// and still interned, so rebuilding the same term finds the existing one
+	BOOST_CHECK(a == Term(Add, var(i32, "x"), Term(Mul, var(i32, "y"), intConst(i32, 3))));
+
+	// Predefined constants survive
+	BOOST_CHECK_EQUAL(trueConst.intVal(), 1);
+	BOOST_CHECK(intConst(boolTy(), 0) == falseConst);
+
+	context = Module{};
+}
+
+BOOST_AUTO_TEST_CASE(CollectReclaimsUnreachable) {
+	modules.clear();
+	context = Module{};
+	collect();
+
+	Type i32 = intTy(32);
+	for (int i = 0; i < 100; i++) {
+		Fn(i32, "f", {}, {ret(Term(Sub, var(i32, "x"), intConst(i32, i)))});
+	}
+
+	// 100 each of Fn, Inst, Sub and Int, and the one shared Var
+	BOOST_CHECK_EQUAL(collect(), 401);
+	BOOST_CHECK_EQUAL(collect(), 0);
+}
@@ -0,0 +1,42 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+
+BOOST_AUTO_TEST_SUITE(InputFileTests)
+
+static void writeFile(const string& filename, const string& text) {
+	std::ofstream os(filename, std::ios::binary);
+	os << text;
+}
+
+BOOST_AUTO_TEST_CASE(ReadsContents) {
+	string filename = "input-test.ll";
+	string text = "@g = global i32 7";
+	writeFile(filename, text);
+	{
+		InputFile input(filename);
+		BOOST_CHECK_EQUAL(input.text(), text);
+
+		// The parser works directly on the view, which need not end with a newline or null
+		auto module = parse(filename, input.text());
+		BOOST_CHECK_EQUAL(module->globals.size(), 1);
+		delete module;
+	}
+	std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(EmptyFile) {
+	string filename = "input-test-empty.ll";
+	writeFile(filename, "");
+	{
+		InputFile input(filename);
+		BOOST_CHECK(input.text().empty());
+	}
+	std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(MissingFile) {
+	BOOST_CHECK_THROW(InputFile("no-such-file.ll"), std::system_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(IntegerTests)
+
+static const cpp_int two64 = cpp_int(1) << 64;
+
+BOOST_AUTO_TEST_CASE(Representation) {
+	BOOST_CHECK(Integer(0).isSmall());
+	BOOST_CHECK(Integer(-1).isSmall());
+	BOOST_CHECK(Integer((std::numeric_limits<int64_t>::min)()).isSmall());
+	BOOST_CHECK(Integer((std::numeric_limits<int64_t>::max)()).isSmall());
+
+	// Unsigned values beyond the signed range need the fallback
+	BOOST_CHECK(!Integer((std::numeric_limits<uint64_t>::max)()).isSmall());
+	BOOST_CHECK_EQUAL(Integer((std::numeric_limits<uint64_t>::max)()), two64 - 1);
+
+	// Canonical, so large values that turn out to fit are stored inline
+	BOOST_CHECK(Integer(cpp_int(42)).isSmall());
+	BOOST_CHECK(!Integer(two64).isSmall());
+	BOOST_CHECK_EQUAL(Integer(two64) - Integer(two64), 0);
+	BOOST_CHECK((Integer(two64) - Integer(two64)).isSmall());
+}
+
+BOOST_AUTO_TEST_CASE(Overflow) {
+	Integer max = (std::numeric_limits<int64_t>::max)();
+	Integer min = (std::numeric_limits<int64_t>::min)();
+
+	BOOST_CHECK_EQUAL(max + 1, cpp_int(max) + 1);
+	BOOST_CHECK_EQUAL(min - 1, cpp_int(min) - 1);
+	BOOST_CHECK_EQUAL(max * max, cpp_int(max) * cpp_int(max));
+	BOOST_CHECK_EQUAL(min * -1, -cpp_int(min));
+	BOOST_CHECK_EQUAL(min / -1, -cpp_int(min));
+	BOOST_CHECK_EQUAL(min % -1, 0);
+	BOOST_CHECK_EQUAL(Integer(1) << 63, cpp_int(1) << 63);
+	BOOST_CHECK_EQUAL(Integer(-3) << 70, cpp_int(-3) << 70);
+}
+
+BOOST_AUTO_TEST_CASE(SameAsCppInt) {
+	vector<cpp_int> vals = {0, 1, -1, 7, -7, 255, -256, 1000000007, cpp_int(1) << 40, -(cpp_int(1) << 62), two64 + 5};
+	for (auto& a : vals) {
+		for (auto& b : vals) {
+			BOOST_CHECK_EQUAL(Integer(a) + Integer(b), a + b);
+			BOOST_CHECK_EQUAL(Integer(a) - Integer(b), a - b);
+			BOOST_CHECK_EQUAL(Integer(a) * Integer(b), a * b);
+			BOOST_CHECK_EQUAL(Integer(a) & Integer(b), a & b);
+			BOOST_CHECK_EQUAL(Integer(a) | Integer(b), a | b);
+			BOOST_CHECK_EQUAL(Integer(a) ^ Integer(b), a ^ b);
+			BOOST_CHECK_EQUAL(Integer(a) < Integer(b), a < b);
+			BOOST_CHECK_EQUAL(Integer(a) == Integer(b), a == b);
+			if (b != 0) {
+				BOOST_CHECK_EQUAL(Integer(a) / Integer(b), a / b);
+				BOOST_CHECK_EQUAL(Integer(a) % Integer(b), a % b);
+			}
+		}
+		for (unsigned n : {0, 1, 5, 63, 64, 100}) {
+			BOOST_CHECK_EQUAL(Integer(a) >> n, a >> n);
+			BOOST_CHECK_EQUAL(Integer(a) << n, a << n);
+		}
+		BOOST_CHECK_EQUAL(~Integer(a), ~a);
+		BOOST_CHECK_EQUAL(hash<Integer>()(Integer(a)), hash<Integer>()(Integer(cpp_int(a))));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(IntTerms) {
+	// Int terms built from differently typed values of the same number are the same term
+	Type i64 = intTy(64);
+	BOOST_CHECK(intConst(i64, 5) == intConst(i64, cpp_int(5)));
+	BOOST_CHECK(intConst(i64, (size_t)5) == intConst(i64, Integer(5)));
+
+	Term big = intConst(intTy(128), two64 + 1);
+	BOOST_CHECK_EQUAL(big.intVal(), two64 + 1);
+
+	std::ostringstream os;
+	os << big;
+	BOOST_CHECK_EQUAL(os.str(), "18446744073709551617");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(InternerTests)
+
+// Build the same types and terms on several threads at once
+// Each must be interned exactly once, so all threads get identical handles
+BOOST_AUTO_TEST_CASE(ConcurrentInterning) {
+	const size_t threadCount = 8;
+	const size_t n = 2000;
+	vector<vector<Type>> types(threadCount);
+	vector<vector<Term>> terms(threadCount);
+
+	vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			for (size_t i = 0; i < n; i++) {
+				auto ty = arrayTy(i, intTy(1 + i % 64));
+				types[t].push_back(ty);
+				auto x = var(intTy(32), Ref(i));
+				terms[t].push_back(Term(Add, x, intConst(intTy(32), i)));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (size_t t = 1; t < threadCount; t++) {
+		for (size_t i = 0; i < n; i++) {
+			BOOST_REQUIRE(types[t][i] == types[0][i]);
+			BOOST_REQUIRE(terms[t][i] == terms[0][i]);
+		}
+	}
+
+	// And the results are the same as building them again now
+	for (size_t i = 0; i < n; i += 97) {
+		BOOST_CHECK(types[0][i] == arrayTy(i, intTy(1 + i % 64)));
+		BOOST_CHECK(terms[0][i] == Term(Add, var(intTy(32), Ref(i)), intConst(intTy(32), i)));
+	}
+}
+
+// Names likewise, enough of them to need more than one chunk of the symbol table
+BOOST_AUTO_TEST_CASE(ConcurrentNames) {
+	const size_t threadCount = 8;
+	const size_t n = 70000;
+	vector<vector<Ref>> refs(threadCount);
+
+	vector<std::thread> threads;
+	for (size_t t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			for (size_t i = 0; i < n; i++) {
+				refs[t].push_back(Ref("concurrent" + to_string(i)));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (size_t t = 1; t < threadCount; t++) {
+		for (size_t i = 0; i < n; i++) {
+			BOOST_REQUIRE(refs[t][i] == refs[0][i]);
+		}
+	}
+	for (size_t i = 0; i < n; i++) {
+		BOOST_REQUIRE(refs[0][i].str() == "concurrent" + to_string(i));
+	}
+	BOOST_CHECK(Ref(std::string_view("concurrent123")) == refs[0][123]);
+}
+
+BOOST_AUTO_TEST_CASE(InternerGrows) {
+	// Enough distinct terms to make every shard grow several times
+	vector<Term> v;
+	for (int i = 0; i < 20000; i++) {
+		v.push_back(intConst(intTy(64), i));
+	}
+	for (int i = 0; i < 20000; i++) {
+		BOOST_REQUIRE(intConst(intTy(64), i) == v[i]);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
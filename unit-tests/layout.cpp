@@ -0,0 +1,111 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(LayoutTests)
+
+static const char* x86_64 = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-i128:128-f80:128-n8:16:32:64-S128";
+
+BOOST_AUTO_TEST_CASE(Scalars) {
+	DataLayout dl(x86_64);
+	BOOST_CHECK(!dl.isBigEndian());
+
+	BOOST_CHECK_EQUAL(dl.allocSize(boolTy()), 1);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(8)), 1);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(16)), 2);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(32)), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(64)), 8);
+	BOOST_CHECK_EQUAL(dl.align(intTy(64)), 8);
+	BOOST_CHECK_EQUAL(dl.align(intTy(128)), 16);
+
+	// Odd widths take the alignment of the next larger integer type
+	BOOST_CHECK_EQUAL(dl.storeSize(intTy(24)), 3);
+	BOOST_CHECK_EQUAL(dl.align(intTy(24)), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(24)), 4);
+
+	// or the largest, if there is no larger one
+	BOOST_CHECK_EQUAL(dl.align(intTy(256)), 16);
+	BOOST_CHECK_EQUAL(dl.allocSize(intTy(256)), 32);
+
+	BOOST_CHECK_EQUAL(dl.allocSize(floatTy()), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(doubleTy()), 8);
+	BOOST_CHECK_EQUAL(dl.allocSize(ptrTy()), 8);
+	BOOST_CHECK_EQUAL(dl.align(ptrTy()), 8);
+
+	BOOST_CHECK_THROW(dl.allocSize(voidTy()), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Defaults) {
+	// Unlike x86-64, LLVM by default gives i64 only 32-bit alignment
+	DataLayout dl;
+	BOOST_CHECK_EQUAL(dl.align(intTy(64)), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(structTy({intTy(8), intTy(64)})), 12);
+
+	DataLayout x(x86_64);
+	BOOST_CHECK_EQUAL(x.allocSize(structTy({intTy(8), intTy(64)})), 16);
+
+	// The two layouts are cached separately on the same type
+	BOOST_CHECK_EQUAL(dl.allocSize(structTy({intTy(8), intTy(64)})), 12);
+}
+
+BOOST_AUTO_TEST_CASE(Pointers) {
+	DataLayout dl("E-p:32:32-i64:64");
+	BOOST_CHECK(dl.isBigEndian());
+	BOOST_CHECK_EQUAL(dl.allocSize(ptrTy()), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(structTy({ptrTy(), intTy(64)})), 16);
+	BOOST_CHECK_EQUAL(dl.offset(structTy({ptrTy(), intTy(64)}), 1), 8);
+}
+
+BOOST_AUTO_TEST_CASE(Structs) {
+	DataLayout dl(x86_64);
+	auto s = structTy({intTy(8), intTy(32), intTy(16), doubleTy(), intTy(8)});
+	BOOST_CHECK_EQUAL(dl.offset(s, 0), 0);
+	BOOST_CHECK_EQUAL(dl.offset(s, 1), 4);
+	BOOST_CHECK_EQUAL(dl.offset(s, 2), 8);
+	BOOST_CHECK_EQUAL(dl.offset(s, 3), 16);
+	BOOST_CHECK_EQUAL(dl.offset(s, 4), 24);
+	BOOST_CHECK_EQUAL(dl.align(s), 8);
+	BOOST_CHECK_EQUAL(dl.allocSize(s), 32);
+
+	// Nested
+	auto t = structTy({intTy(8), s});
+	BOOST_CHECK_EQUAL(dl.offset(t, 1), 8);
+	BOOST_CHECK_EQUAL(dl.allocSize(t), 40);
+
+	// Empty
+	BOOST_CHECK_EQUAL(dl.allocSize(structTy({})), 0);
+	BOOST_CHECK_EQUAL(dl.align(structTy({})), 1);
+
+	// Minimum aggregate alignment
+	DataLayout a("a:32");
+	BOOST_CHECK_EQUAL(a.allocSize(structTy({intTy(8)})), 4);
+}
+
+BOOST_AUTO_TEST_CASE(Sequences) {
+	DataLayout dl(x86_64);
+	auto a = arrayTy(10, structTy({intTy(32), intTy(8)}));
+	BOOST_CHECK_EQUAL(dl.stride(a), 8);
+	BOOST_CHECK_EQUAL(dl.allocSize(a), 80);
+	BOOST_CHECK_EQUAL(dl.align(a), 4);
+
+	auto v = vecTy(4, intTy(32));
+	BOOST_CHECK_EQUAL(dl.stride(v), 4);
+	BOOST_CHECK_EQUAL(dl.allocSize(v), 16);
+	BOOST_CHECK_EQUAL(dl.align(v), 16);
+
+	// Vectors without a specified alignment are naturally aligned
+	auto w = vecTy(3, floatTy());
+	BOOST_CHECK_EQUAL(dl.storeSize(w), 12);
+	BOOST_CHECK_EQUAL(dl.align(w), 16);
+	BOOST_CHECK_EQUAL(dl.allocSize(w), 16);
+
+	BOOST_CHECK_THROW(dl.stride(intTy(32)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Malformed) {
+	BOOST_CHECK_THROW(DataLayout("i64:x"), runtime_error);
+	BOOST_CHECK_THROW(DataLayout("i64:12"), runtime_error);
+	BOOST_CHECK_THROW(DataLayout("e--i64:64"), runtime_error);
+	BOOST_CHECK_THROW(DataLayout("p:64"), runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,120 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(LinearizeTests)
+
+namespace {
+string print(const Fn& f) {
+	std::ostringstream os;
+	os << f;
+	return os.str();
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SharedSubterms) {
+	auto x = var(intTy(32), "x");
+	auto p = var(ptrTy(), "p");
+	auto square = Term(Mul, intTy(32), x, x);
+	vector<Inst> body;
+	body.push_back(store(Term(Add, intTy(32), square, square), p));
+	body.push_back(ret(Term(Add, intTy(32), Term(Load, intTy(32), p), square)));
+	Fn f(intTy(32), "f", {x, p}, body);
+
+	// The entry block is implicitly numbered 0
+	BOOST_CHECK_EQUAL(print(f),
+		"define i32 @f(i32 %x, ptr %p) {\n"
+		"  %1 = mul i32 %x, %x\n"
+		"  %2 = add i32 %1, %1\n"
+		"  store i32 %2, ptr %p\n"
+		"  %3 = load i32, ptr %p\n"
+		"  %4 = add i32 %3, %1\n"
+		"  ret i32 %4\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(StoreInvalidatesLoad) {
+	auto p = var(ptrTy(), "p");
+	auto inc = Term(Add, intTy(32), Term(Load, intTy(32), p), intConst(intTy(32), 1));
+	vector<Inst> body;
+	body.push_back(store(inc, p));
+	body.push_back(store(inc, p));
+	body.push_back(ret());
+	Fn f(voidTy(), "f", {p}, body);
+
+	BOOST_CHECK_EQUAL(print(f),
+		"define void @f(ptr %p) {\n"
+		"  %1 = load i32, ptr %p\n"
+		"  %2 = add i32 %1, 1\n"
+		"  store i32 %2, ptr %p\n"
+		"  %3 = load i32, ptr %p\n"
+		"  %4 = add i32 %3, 1\n"
+		"  store i32 %4, ptr %p\n"
+		"  ret void\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(AssignInvalidates) {
+	auto x = var(intTy(32), "x");
+	auto p = var(ptrTy(), "p");
+	auto square = Term(Mul, intTy(32), x, x);
+	vector<Inst> body;
+	body.push_back(store(Term(Add, intTy(32), square, square), p));
+	body.push_back(assign(x, intConst(intTy(32), 2)));
+	body.push_back(ret(Term(Add, intTy(32), square, square)));
+	Fn f(intTy(32), "f", {x, p}, body);
+
+	BOOST_CHECK_EQUAL(print(f),
+		"define i32 @f(i32 %x, ptr %p) {\n"
+		"  %1 = mul i32 %x, %x\n"
+		"  %2 = add i32 %1, %1\n"
+		"  store i32 %2, ptr %p\n"
+		"  %x = i32 2\n"
+		"  %3 = mul i32 %x, %x\n"
+		"  %4 = add i32 %3, %3\n"
+		"  ret i32 %4\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(CallsNotShared) {
+	auto g = call(intTy(32), globalRef(ptrTy(), "g"), {});
+	vector<Inst> body;
+	body.push_back(ret(Term(Add, intTy(32), g, g)));
+	Fn f(intTy(32), "f", {}, body);
+
+	BOOST_CHECK_EQUAL(print(f),
+		"define i32 @f() {\n"
+		"  %1 = call i32 @g()\n"
+		"  %2 = call i32 @g()\n"
+		"  %3 = add i32 %1, %2\n"
+		"  ret i32 %3\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(Renumber) {
+	// Numbered variables defined after a temporary move up to make room for it
+	auto x = var(intTy(32), Ref((size_t)0));
+	auto y = var(intTy(32), Ref(2));
+	vector<Inst> body;
+	body.push_back(assign(y, Term(Add, intTy(32), Term(Mul, intTy(32), x, x), intConst(intTy(32), 1))));
+	body.push_back(ret(y));
+	Fn f(intTy(32), "f", {x}, body);
+
+	BOOST_CHECK_EQUAL(print(f),
+		"define i32 @f(i32 %0) {\n"
+		"  %2 = mul i32 %0, %0\n"
+		"  %3 = add i32 %2, 1\n"
+		"  ret i32 %3\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(Flat) {
+	// A function that needs no temporaries is unchanged
+	auto x = var(intTy(32), "x");
+	vector<Inst> body;
+	body.push_back(ret(x));
+	Fn f(intTy(32), "f", {x}, body);
+	auto g = linearize(f);
+	BOOST_CHECK(g.size() == 1 && g[0] == f[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
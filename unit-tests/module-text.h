@@ -0,0 +1,26 @@
+// Helpers for tests that compare whole modules by their printed text
+
+inline string str(const Module& module) {
+	std::ostringstream os;
+	os << module;
+	return os.str();
+}
+
+// A module large enough to be split into several parts
+// with comments and strings containing characters that would confuse a scan that did not recognize them
+inline string bigModule(size_t n) {
+	string s = "target triple = \"x86_64-pc-linux-gnu\"\n";
+	for (size_t i = 0; i < n; i++) {
+		auto k = to_string(i);
+		s += "@s" + k + " = global [4 x i8] c\"};\\0A\\00\"\n";
+		s += "declare i32 @d" + k + "(i32)\n";
+		s += "; define void @x() {\n";
+		s += "define i32 @f" + k + "(i32 %x) {\n";
+		s += "  %y = add i32 %x, " + k + " ; }\n";
+		s += "  br label %\"}" + k + "\"\n";
+		s += "\"}" + k + "\":\n";
+		s += "  ret i32 %y\n";
+		s += "}\n";
+	}
+	return s;
+}
@@ -0,0 +1,92 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(NumberingTests)
+
+BOOST_AUTO_TEST_CASE(NumbersVarsAndLabels) {
+	Type i32 = intTy(32);
+	Term a = var(i32, "a");
+	Term b = var(i32, "b");
+	Term x = var(i32, "x");
+	Term y = var(i32, "y");
+	Fn f(i32,
+		"f",
+		{a, b},
+		{block("entry"),
+			assign(x, Term(Add, a, Term(Mul, y, b))),
+			br(Term(Eq, x, a), "yes", "no"),
+			block("yes"),
+			ret(x),
+			block("no"),
+			jmp("entry")});
+	Numbering numbering(f);
+
+	// Parameters first, then in order of first appearance
+	BOOST_CHECK_EQUAL(numbering.vars(), 4);
+	BOOST_CHECK_EQUAL(numbering.var(a), 0);
+	BOOST_CHECK_EQUAL(numbering.var(b), 1);
+	BOOST_CHECK_EQUAL(numbering.var(x), 2);
+	BOOST_CHECK_EQUAL(numbering.var(y), 3);
+	BOOST_CHECK(numbering.var(size_t(3)) == y);
+
+	BOOST_CHECK_EQUAL(numbering.labels(), 3);
+	BOOST_CHECK_EQUAL(numbering.label(Ref("entry")), 0);
+	BOOST_CHECK_EQUAL(numbering.label(label("yes")), 1);
+	BOOST_CHECK_EQUAL(numbering.label(Ref("no")), 2);
+	BOOST_CHECK(numbering.label(size_t(1)) == Ref("yes"));
+
+	BOOST_CHECK_THROW(numbering.var(Ref("z")), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(VarSetOperations) {
+	// Spans more than one word
+	VarSet s(130);
+	BOOST_CHECK(s.empty());
+	s.add(0);
+	s.add(64);
+	s.add(129);
+	BOOST_CHECK(s.has(64));
+	BOOST_CHECK(!s.has(63));
+	BOOST_CHECK_EQUAL(s.count(), 3);
+
+	vector<size_t> elements;
+	s.each([&](size_t i) { elements.push_back(i); });
+	BOOST_CHECK((elements == vector<size_t>{0, 64, 129}));
+
+	VarSet t(130);
+	t.add(64);
+	t.add(100);
+
+	auto u = s;
+	BOOST_CHECK(u.addAll(t));
+	BOOST_CHECK(!u.addAll(t));
+	BOOST_CHECK_EQUAL(u.count(), 4);
+
+	auto v = s;
+	BOOST_CHECK(v.keepOnly(t));
+	BOOST_CHECK_EQUAL(v.count(), 1);
+	BOOST_CHECK(v.has(64));
+
+	auto w = s;
+	w -= t;
+	BOOST_CHECK_EQUAL(w.count(), 2);
+	BOOST_CHECK(!w.has(64));
+	BOOST_CHECK(!w.removeAll(t));
+
+	s.remove(0);
+	s.remove(64);
+	s.remove(129);
+	BOOST_CHECK(s.empty());
+	BOOST_CHECK(s == VarSet(130));
+}
+
+BOOST_AUTO_TEST_CASE(VarMapDefaults) {
+	VarMap<Term> m(3);
+	BOOST_CHECK(m[2] == Term());
+	m[1] = intConst(intTy(32), 7);
+	BOOST_CHECK(m[1] == intConst(intTy(32), 7));
+	BOOST_CHECK_EQUAL(m.size(), 3);
+	BOOST_CHECK_THROW(m[3], runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
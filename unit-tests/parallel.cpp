@@ -0,0 +1,93 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(ParallelTests)
+
+BOOST_AUTO_TEST_CASE(EveryIndexOnce) {
+	const size_t n = 1000;
+	vector<std::atomic<int>> counts(n);
+	parallelFor(n, 8, [&](size_t i) { counts[i]++; });
+	for (size_t i = 0; i < n; i++) {
+		BOOST_CHECK_EQUAL(counts[i].load(), 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(SerialInOrder) {
+	vector<size_t> order;
+	parallelFor(5, 1, [&](size_t i) { order.push_back(i); });
+	BOOST_CHECK((order == vector<size_t>{0, 1, 2, 3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(NoIndexes) {
+	std::atomic<int> calls(0);
+	parallelFor(0, 4, [&](size_t) { calls++; });
+	BOOST_CHECK_EQUAL(calls.load(), 0);
+}
+
+// Whichever thread fails first, the error reported is the one from the lowest index
+BOOST_AUTO_TEST_CASE(LowestErrorRethrown) {
+	for (int repeat = 0; repeat < 20; repeat++) {
+		try {
+			parallelFor(100, 4, [](size_t i) {
+				if (i % 10 == 7) {
+					throw runtime_error(to_string(i));
+				}
+			});
+			BOOST_FAIL("expected exception");
+		} catch (const runtime_error& e) {
+			BOOST_CHECK_EQUAL(string(e.what()), "7");
+		}
+	}
+}
+
+// A slow low index that fails still wins over a higher one that failed first
+// and the indexes below the failure all run
+BOOST_AUTO_TEST_CASE(SlowLowErrorRethrown) {
+	const size_t n = 40;
+	vector<std::atomic<int>> counts(n);
+	try {
+		parallelFor(n, 4, [&](size_t i) {
+			counts[i]++;
+			if (i == 2) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				throw runtime_error("2");
+			}
+			if (i == 5) {
+				throw runtime_error("5");
+			}
+			if (i < 5) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		});
+		BOOST_FAIL("expected exception");
+	} catch (const runtime_error& e) {
+		BOOST_CHECK_EQUAL(string(e.what()), "2");
+	}
+	for (size_t i = 0; i <= 5; i++) {
+		BOOST_CHECK_EQUAL(counts[i].load(), 1);
+	}
+}
+
+// Parsing modules on several threads gives the same IR as parsing them one at a time
+BOOST_AUTO_TEST_CASE(ParseModules) {
+	vector<string> texts;
+	for (size_t i = 0; i < 16; i++) {
+		auto s = to_string(i);
+		texts.push_back("@g" + s + " = global i32 " + s + "\n" + "define i32 @f" + s + "(i32 %x) {\n" + "  %y = add i32 %x, " + s +
+						"\n" + "  ret i32 %y\n" + "}\n");
+	}
+	vector<Module*> serial(texts.size());
+	vector<Module*> parallel(texts.size());
+	parallelFor(texts.size(), 1, [&](size_t i) { serial[i] = parse(texts[i]); });
+	parallelFor(texts.size(), 4, [&](size_t i) { parallel[i] = parse(texts[i]); });
+	for (size_t i = 0; i < texts.size(); i++) {
+		std::ostringstream a, b;
+		a << *serial[i];
+		b << *parallel[i];
+		BOOST_CHECK_EQUAL(a.str(), b.str());
+		delete serial[i];
+		delete parallel[i];
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
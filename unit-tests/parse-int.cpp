@@ -0,0 +1,62 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(ParseIntTests)
+
+// Check the fast path against cpp_int, which handles every case
+static void check(const string& s) {
+	BOOST_CHECK_MESSAGE(parseInt(s) == Integer(cpp_int(s)), s);
+}
+
+BOOST_AUTO_TEST_CASE(Decimal) {
+	check("0");
+	check("1");
+	check("-1");
+	check("-0");
+	check("42");
+	check("007");
+	check("9223372036854775807");
+	check("9223372036854775808");
+	check("-9223372036854775808");
+	check("-9223372036854775809");
+	check("18446744073709551615");
+	check("18446744073709551616");
+	check("-18446744073709551615");
+	check("340282366920938463463374607431768211456");
+	check("-340282366920938463463374607431768211456");
+}
+
+BOOST_AUTO_TEST_CASE(Hex) {
+	check("0x0");
+	check("0xff");
+	check("0XFF");
+	check("0xDeadBeef");
+	check("-0x10");
+	check("0x7fffffffffffffff");
+	check("0x8000000000000000");
+	check("0xffffffffffffffff");
+	check("0x10000000000000000");
+	check("-0x8000000000000000");
+}
+
+BOOST_AUTO_TEST_CASE(Small) {
+	BOOST_CHECK(parseInt("123").isSmall());
+	BOOST_CHECK_EQUAL(parseInt("-9223372036854775808").toSmall(), (std::numeric_limits<int64_t>::min)());
+	BOOST_CHECK(!parseInt("9223372036854775808").isSmall());
+}
+
+BOOST_AUTO_TEST_CASE(Invalid) {
+	BOOST_CHECK_THROW(parseInt("12z"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Constants) {
+	auto module = parse("@a = global i64 -9223372036854775808\n"
+						"@b = global i64 18446744073709551615\n"
+						"@c = global i128 340282366920938463463374607431768211455\n");
+	BOOST_CHECK(module->globals[0].val() == intConst(intTy(64), (std::numeric_limits<int64_t>::min)()));
+	BOOST_CHECK(module->globals[1].val() == intConst(intTy(64), cpp_int("18446744073709551615")));
+	BOOST_CHECK(module->globals[2].val() == intConst(intTy(128), cpp_int("340282366920938463463374607431768211455")));
+	delete module;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
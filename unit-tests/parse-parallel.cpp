@@ -0,0 +1,59 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include "module-text.h"
+
+BOOST_AUTO_TEST_SUITE(ParseParallelTests)
+
+namespace {
+string error(const string& text, size_t threads) {
+	try {
+		std::unique_ptr<Module> module(parse("test.ll", text, threads));
+	} catch (const runtime_error& e) {
+		return e.what();
+	}
+	return "";
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SameModule) {
+	auto text = bigModule(2000);
+	std::unique_ptr<Module> serial(parse("test.ll", text));
+	std::unique_ptr<Module> parallel(parse("test.ll", text, 4));
+	BOOST_CHECK_EQUAL(parallel->triple, serial->triple);
+	BOOST_CHECK_EQUAL(parallel->globals.size(), 2000);
+	BOOST_CHECK_EQUAL(parallel->decls.size(), 2000);
+	BOOST_CHECK_EQUAL(parallel->defs.size(), 2000);
+	BOOST_CHECK_EQUAL(parallel->defs[1234].ref(), Ref("f1234"));
+	BOOST_CHECK(str(*parallel) == str(*serial));
+}
+
+BOOST_AUTO_TEST_CASE(SmallModule) {
+	auto text = bigModule(3);
+	std::unique_ptr<Module> serial(parse("test.ll", text));
+	std::unique_ptr<Module> parallel(parse("test.ll", text, 8));
+	BOOST_CHECK(str(*parallel) == str(*serial));
+}
+
+// Errors are reported with the line number in the whole file, not the part
+// and the error is the first in the file, as it would be when parsing on one thread
+BOOST_AUTO_TEST_CASE(SameError) {
+	auto text = bigModule(2000);
+	for (auto k : {"1500", "700"}) {
+		auto i = text.find(string("%y = add i32 %x, ") + k + " ");
+		BOOST_REQUIRE(i != string::npos);
+		text.replace(i + 5, 3, "frobnicate");
+	}
+	auto e = error(text, 1);
+	BOOST_CHECK_EQUAL(error(text, 4), e);
+	auto line = 1 + std::count(text.begin(), text.begin() + text.find("frobnicate"), '\n');
+	BOOST_CHECK(e.find("test.ll:" + to_string(line) + ":") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(UnterminatedBody) {
+	auto text = bigModule(1000) + "define void @g() {\n  ret void\n";
+	auto e = error(text, 4);
+	BOOST_CHECK_EQUAL(e, error(text, 1));
+	BOOST_CHECK(e.find("EOF") != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -140,3 +140,28 @@ BOOST_AUTO_TEST_CASE(test_complex_function_with_error) {
 
 	BOOST_CHECK_MESSAGE(error_contains_line_number(ir_code, 12), "Parser should report error at line 12 in complex function");
 }
+
+BOOST_AUTO_TEST_CASE(test_error_on_unterminated_last_line) {
+	std::string ir_code = "; comment\n"						 // Line 1
+						  "define i32 @test() {\n"			 // Line 2
+						  "    ret i32 0\n"					 // Line 3
+						  "}\n"								 // Line 4
+						  "@g = global i32 invalid_value"; // Line 5 - error here, no newline
+
+	BOOST_CHECK_MESSAGE(
+		error_contains_line_number(ir_code, 5), "Parser should report error at line 5 when the file does not end with a newline");
+
+	// Without the error, the unterminated line parses
+	auto module = parse("test.ll", "@g = global i32 7");
+	BOOST_CHECK_EQUAL(module->globals.size(), 1);
+	delete module;
+}
+
+BOOST_AUTO_TEST_CASE(test_lexer_error_line) {
+	// Tokens are lexed as the parser reaches them, so lexical errors are reported from the right line
+	std::string ir_code = "@a = global i32 1\n" // Line 1
+						  "@b = global i32 2\n" // Line 2
+						  "@\"c = global i32 3\n"; // Line 3 - unclosed quote
+
+	BOOST_CHECK_MESSAGE(error_contains_line_number(ir_code, 3), "Lexer should report error at line 3 for unclosed quote");
+}
@@ -0,0 +1,35 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include "module-text.h"
+
+BOOST_AUTO_TEST_SUITE(PrintParallelTests)
+
+namespace {
+string print(const Module& module, size_t threads) {
+	std::ostringstream os;
+	Writer(os).write(module, threads);
+	return os.str();
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SameOutput) {
+	std::unique_ptr<Module> module(parse(bigModule(1000)));
+	auto serial = print(*module, 1);
+	BOOST_CHECK(serial.find("define i32 @f999") != string::npos);
+	for (size_t threads : {2, 3, 8, 64}) {
+		BOOST_CHECK(print(*module, threads) == serial);
+	}
+
+	// Definitions are few compared to threads
+	std::unique_ptr<Module> small(parse(bigModule(3)));
+	BOOST_CHECK(print(*small, 8) == print(*small, 1));
+}
+
+BOOST_AUTO_TEST_CASE(Buffer) {
+	std::unique_ptr<Module> module(parse(bigModule(100)));
+	Writer writer;
+	writer.write(*module, 4);
+	BOOST_CHECK(writer.str() == print(*module, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
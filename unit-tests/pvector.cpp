@@ -0,0 +1,99 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(PVectorTests)
+
+static vector<int> range(int n) {
+	vector<int> v;
+	for (int i = 0; i < n; i++) {
+		v.push_back(i);
+	}
+	return v;
+}
+
+BOOST_AUTO_TEST_CASE(Empty) {
+	PVector<int> a;
+	BOOST_CHECK_EQUAL(a.size(), 0);
+	BOOST_CHECK(a.begin() == a.end());
+	BOOST_CHECK(a.map([](int x) { return x + 1; }).identical(a));
+}
+
+BOOST_AUTO_TEST_CASE(Construct) {
+	// Sizes either side of the boundaries between one, two and three levels
+	for (int n : {1, 2, 31, 32, 33, 100, 1023, 1024, 1025, 5000}) {
+		auto v = range(n);
+		PVector<int> a(v);
+		BOOST_CHECK_EQUAL(a.size(), n);
+		for (int i = 0; i < n; i++) {
+			BOOST_CHECK_EQUAL(a[i], i);
+		}
+		BOOST_CHECK(vector<int>(a.begin(), a.end()) == v);
+		BOOST_CHECK_EQUAL(a.end() - a.begin(), n);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(InitializerList) {
+	PVector<int> a = {3, 1, 4};
+	BOOST_CHECK_EQUAL(a.size(), 3);
+	BOOST_CHECK_EQUAL(a[0], 3);
+	BOOST_CHECK_EQUAL(a[2], 4);
+}
+
+BOOST_AUTO_TEST_CASE(Set) {
+	auto v = range(2000);
+	PVector<int> a(v);
+	auto b = a.set(1500, -1);
+
+	// The original is unchanged
+	BOOST_CHECK(vector<int>(a.begin(), a.end()) == v);
+
+	v[1500] = -1;
+	BOOST_CHECK(vector<int>(b.begin(), b.end()) == v);
+	BOOST_CHECK(!b.identical(a));
+}
+
+BOOST_AUTO_TEST_CASE(Map) {
+	auto v = range(1000);
+	PVector<int> a(v);
+
+	// Unchanged
+	BOOST_CHECK(a.map([](int x) { return x; }).identical(a));
+
+	// One element changed
+	auto b = a.map([](int x) { return x == 700 ? 0 : x; });
+	BOOST_CHECK(!b.identical(a));
+	BOOST_CHECK_EQUAL(b[700], 0);
+	BOOST_CHECK_EQUAL(b[699], 699);
+	BOOST_CHECK_EQUAL(a[700], 700);
+
+	// Every element changed
+	auto c = a.map([](int x) { return x * 2; });
+	for (int i = 0; i < 1000; i++) {
+		BOOST_CHECK_EQUAL(c[i], i * 2);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Iterator) {
+	PVector<int> a(range(100));
+	auto i = a.begin();
+	i += 40;
+	BOOST_CHECK_EQUAL(*i, 40);
+	i -= 35;
+	BOOST_CHECK_EQUAL(*i, 5);
+	--i;
+	BOOST_CHECK_EQUAL(*i, 4);
+	BOOST_CHECK_EQUAL(i[60], 64);
+	BOOST_CHECK_EQUAL(*(a.end() - 1), 99);
+	BOOST_CHECK(a.begin() < a.end());
+}
+
+BOOST_AUTO_TEST_CASE(FnSet) {
+	auto i32 = intTy(32);
+	auto f = Fn(i32, "f", {}, {ret(intConst(i32, 1)), ret(intConst(i32, 2))});
+	auto g = f.set(1, ret(intConst(i32, 3)));
+	BOOST_CHECK(f[1] == ret(intConst(i32, 2)));
+	BOOST_CHECK(g[0] == ret(intConst(i32, 1)));
+	BOOST_CHECK(g[1] == ret(intConst(i32, 3)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
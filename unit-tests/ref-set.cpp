@@ -71,4 +71,22 @@ BOOST_AUTO_TEST_CASE(test_ref_set_duplicate_handling) {
 	BOOST_CHECK_EQUAL(refSet.size(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_ref_interning) {
+	// Names are interned, so the same name built separately is the same ref
+	string name = "_ZN4core3fmt9Formatter9write_str17h0123456789abcdefE";
+	Ref a(name);
+	Ref b(name.c_str());
+	BOOST_CHECK_EQUAL(a, b);
+	BOOST_CHECK_EQUAL(hash<Ref>()(a), hash<Ref>()(b));
+	BOOST_CHECK_EQUAL(a.str(), name);
+
+	// A name is never equal to a number, whatever the index of the name in the symbol table
+	for (size_t i = 0; i < 1000; i++) {
+		BOOST_CHECK(Ref(i) != a);
+	}
+
+	BOOST_CHECK(Ref("x") != Ref("y"));
+	BOOST_CHECK_EQUAL(Ref(""), Ref(string()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
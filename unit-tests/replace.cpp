@@ -458,4 +458,72 @@ BOOST_AUTO_TEST_CASE(replace_preserves_unchanged_elements_test) {
 	}
 }
 
+BOOST_AUTO_TEST_CASE(ReplaceSkipsUnaffectedSubterms) {
+	Type i32 = intTy(32);
+	Term x = var(i32, "x");
+	Term g = globalRef(ptrTy(), "g");
+
+	// A term with no variables is returned as is by a variable substitution
+	Term load = Term(Load, i32, g);
+	unordered_map<Term, Term> vars = {{x, intConst(i32, 5)}};
+	BOOST_CHECK(replace(load, vars) == load);
+
+	// but is still updated by a global substitution
+	unordered_map<Term, Term> globals = {{g, globalRef(ptrTy(), "h")}};
+	BOOST_CHECK(replace(Term(Add, load, x), globals) == Term(Add, Term(Load, i32, globalRef(ptrTy(), "h")), x));
+
+	// Maps with both kinds of key
+	unordered_map<Term, Term> both = {{x, intConst(i32, 5)}, {g, globalRef(ptrTy(), "h")}};
+	BOOST_CHECK(
+		replace(Term(Add, load, x), both) == Term(Add, Term(Load, i32, globalRef(ptrTy(), "h")), intConst(i32, 5)));
+
+	// Maps keyed by other kinds of atom are still honored
+	unordered_map<Term, Term> labels = {{label("a"), label("b")}};
+	Inst inst = jmp(Ref("a"));
+	BOOST_CHECK(replace(inst, labels) == jmp(Ref("b")));
+
+	// The flags can be computed once for a map and reused
+	BOOST_CHECK_EQUAL(keyFlags(vars), HasVar);
+	BOOST_CHECK_EQUAL(keyFlags(both), HasVar | HasGlobalRef);
+	BOOST_CHECK_EQUAL(keyFlags(labels), 0);
+	BOOST_CHECK(replace(Term(Add, load, x), globals, keyFlags(globals)) == replace(Term(Add, load, x), globals));
+
+	// An empty map changes nothing
+	unordered_map<Term, Term> empty;
+	Fn f(i32, "f", {x}, {ret(x)});
+	BOOST_CHECK(replace(f, empty).identical(f));
+}
+
+BOOST_AUTO_TEST_CASE(ReplaceSharesUnchangedBody) {
+	Type i32 = intTy(32);
+	Term x = var(i32, "x");
+	Term y = var(i32, "y");
+	vector<Inst> body;
+	for (int i = 0; i < 100; i++) {
+		body.push_back(assign(x, Term(Add, x, intConst(i32, i))));
+	}
+	body.push_back(ret(y));
+	Fn f(i32, "f", {x, y}, body);
+
+	// Nothing to replace, so the function comes back as is
+	unordered_map<Term, Term> none = {{var(i32, "z"), intConst(i32, 0)}};
+	BOOST_CHECK(replace(f, none).identical(f));
+
+	// Only the last instruction mentions y
+	unordered_map<Term, Term> m = {{y, intConst(i32, 7)}};
+	auto g = replace(f, m);
+	BOOST_CHECK(!g.body().identical(f.body()));
+	BOOST_CHECK(g[100] == ret(intConst(i32, 7)));
+	BOOST_CHECK(f[100] == ret(y));
+	for (size_t i = 0; i < 100; i++) {
+		BOOST_CHECK(g[i] == f[i]);
+	}
+
+	// Parameters are copied when one of them changes
+	Term z = var(i32, "z");
+	unordered_map<Term, Term> params = {{y, z}};
+	auto h = replace(f, params);
+	BOOST_CHECK(h.params() == vector<Term>({x, z}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
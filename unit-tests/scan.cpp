@@ -0,0 +1,64 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+#include <random>
+
+BOOST_AUTO_TEST_SUITE(ScanTests)
+
+namespace {
+// Simple versions to compare against
+template <class F> size_t scanRef(std::string_view text, size_t i, F end) {
+	while (i < text.size() && !end((unsigned char)text[i])) {
+		i++;
+	}
+	return i;
+}
+
+bool isHorizontalSpace(int c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\f';
+}
+
+// Runs of various lengths, so that the ends fall at every position in vector blocks, and in the scalar tail
+// including bytes outside ASCII, which must not be taken for identifier characters
+string randomText(std::mt19937& rng, size_t n) {
+	const string alphabet = " \t\r\f\n\";.$-_@%{}azAZ09\x80\xff";
+	string s;
+	while (s.size() < n) {
+		auto c = alphabet[rng() % alphabet.size()];
+		s.append(rng() % 40, c);
+		s += alphabet[rng() % alphabet.size()];
+	}
+	s.resize(n);
+	return s;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MatchesScalar) {
+	std::mt19937 rng(1);
+	for (size_t n = 0; n < 200; n++) {
+		auto s = randomText(rng, n);
+		for (size_t i = 0; i <= n; i++) {
+			BOOST_REQUIRE_EQUAL(findByte(s, i, '"'), scanRef(s, i, [](int c) { return c == '"'; }));
+			BOOST_REQUIRE_EQUAL(
+				findByte(s, i, '\n', '"', ';'), scanRef(s, i, [](int c) { return c == '\n' || c == '"' || c == ';'; }));
+			BOOST_REQUIRE_EQUAL(skipSpace(s, i), scanRef(s, i, [](int c) { return !isHorizontalSpace(c); }));
+			BOOST_REQUIRE_EQUAL(skipIdPart(s, i), scanRef(s, i, [](int c) { return !isIdPart(c); }));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(LongRuns) {
+	string id(1000, 'x');
+	id[777] = '$';
+	BOOST_CHECK_EQUAL(skipIdPart(id + "(", 0), 1000);
+	BOOST_CHECK_EQUAL(skipIdPart(id, 3), 1000);
+	BOOST_CHECK_EQUAL(findByte("; " + id + "\n", 0, '\n'), 1002);
+	BOOST_CHECK_EQUAL(skipSpace(string(100, ' ') + "x", 0), 100);
+	BOOST_CHECK_EQUAL(skipSpace(string(100, ' '), 0), 100);
+}
+
+BOOST_AUTO_TEST_CASE(PastEnd) {
+	BOOST_CHECK_EQUAL(findByte("abc", 3, 'a'), 3);
+	BOOST_CHECK_EQUAL(skipSpace("", 0), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,40 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(SmallVecInlineAndSpilled) {
+	for (size_t n = 0; n <= 10; n++) {
+		vector<string> v;
+		for (size_t i = 0; i < n; i++) {
+			v.push_back("element " + to_string(i));
+		}
+		SmallVec<string, 3> a(v);
+		BOOST_CHECK_EQUAL(a.size(), n);
+		BOOST_CHECK(std::equal(a.begin(), a.end(), v.begin(), v.end()));
+
+		SmallVec<string, 3> b(a);
+		BOOST_CHECK(a == b);
+		for (size_t i = 0; i < n; i++) {
+			BOOST_CHECK_EQUAL(b[i], v[i]);
+		}
+	}
+	BOOST_CHECK((SmallVec<int, 3>({1, 2}) != SmallVec<int, 3>({1, 2, 3})));
+	BOOST_CHECK((SmallVec<int, 3>({1, 2, 3, 4}) != SmallVec<int, 3>({1, 2, 3, 5})));
+}
+
+BOOST_AUTO_TEST_CASE(OperandIteration) {
+	Type i32 = intTy(32);
+	vector<Term> args;
+	for (int i = 0; i < 6; i++) {
+		args.push_back(intConst(i32, i));
+	}
+	Term f = globalRef(fnTy(i32, vector<Type>(6, i32)), "f");
+
+	// A call has more operands than fit inline
+	Term c = call(i32, f, args);
+	BOOST_CHECK_EQUAL(c.size(), 7);
+	BOOST_CHECK(vector<Term>(c.begin() + 1, c.end()) == args);
+
+	Inst inst = Inst(Switch, args);
+	BOOST_CHECK_EQUAL(inst.size(), 6);
+	BOOST_CHECK(vector<Term>(inst.begin(), inst.end()) == args);
+}
@@ -0,0 +1,57 @@
+#include "all.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(AtomFlags) {
+	Type i32 = intTy(32);
+
+	BOOST_CHECK(intConst(i32, 7).constant());
+	BOOST_CHECK(floatConst(doubleTy(), "1.5").constant());
+	BOOST_CHECK(nullPtrConst.constant());
+	BOOST_CHECK(trueConst.constant());
+
+	Term x = var(i32, "x");
+	BOOST_CHECK(x.hasVar());
+	BOOST_CHECK(!x.constant());
+	BOOST_CHECK(!x.hasGlobalRef());
+
+	Term g = globalRef(ptrTy(), "g");
+	BOOST_CHECK(g.hasGlobalRef());
+	BOOST_CHECK(!g.hasVar());
+	BOOST_CHECK(!g.constant());
+}
+
+BOOST_AUTO_TEST_CASE(CompoundFlags) {
+	Type i32 = intTy(32);
+	Term x = var(i32, "x");
+	Term p = var(ptrTy(), "p");
+
+	// Properties propagate up from operands
+	Term a = Term(Add, Term(Load, i32, p), x);
+	BOOST_CHECK(a.hasLoad());
+	BOOST_CHECK(a.hasVar());
+	BOOST_CHECK(!a.hasCall());
+	BOOST_CHECK(!a.constant());
+
+	Term f = globalRef(fnTy(i32, {i32}), "f");
+	Term c = Term(Mul, call(i32, f, {intConst(i32, 1)}), intConst(i32, 2));
+	BOOST_CHECK(c.hasCall());
+	BOOST_CHECK(c.hasGlobalRef());
+	BOOST_CHECK(!c.hasVar());
+	BOOST_CHECK(!c.hasLoad());
+
+	// Arithmetic on constants is not itself a constant until it has been folded
+	BOOST_CHECK(!Term(Add, intConst(i32, 1), intConst(i32, 2)).constant());
+}
+
+BOOST_AUTO_TEST_CASE(ConstantAggregates) {
+	Type i8 = intTy(8);
+
+	unsigned char bytes[] = {'h', 'i', 0};
+	BOOST_CHECK(arrayBytes(bytes, sizeof bytes).constant());
+	BOOST_CHECK(zeroVal(structTy({intTy(32), ptrTy(), arrayTy(4, doubleTy())})).constant());
+	BOOST_CHECK(array(i8, {}).constant());
+
+	Term mixed = array(i8, {intConst(i8, 1), var(i8, "x")});
+	BOOST_CHECK(!mixed.constant());
+	BOOST_CHECK(mixed.hasVar());
+}
@@ -99,3 +99,26 @@ BOOST_AUTO_TEST_CASE(TermEquality) {
 	BOOST_CHECK(var1 == var2);
 	BOOST_CHECK(var1 != var3);
 }
+
+// Test that structurally equal terms built separately are interned to the same term
+BOOST_AUTO_TEST_CASE(TermInterning) {
+	Type int32Type = intTy(32);
+	Term a = var(int32Type, "a");
+	Term b = var(int32Type, "b");
+
+	Term x = Term(Add, Term(Mul, a, b), intConst(int32Type, 1));
+	Term y = Term(Add, Term(Mul, var(int32Type, "a"), var(int32Type, "b")), intConst(int32Type, 1));
+	BOOST_CHECK(x == y);
+	BOOST_CHECK_EQUAL(hash<Term>()(x), hash<Term>()(y));
+
+	// Differing only in a deeply nested operand
+	Term z = Term(Add, Term(Mul, a, b), intConst(int32Type, 2));
+	BOOST_CHECK(x != z);
+
+	// Default terms are all the same None
+	BOOST_CHECK(Term() == Term());
+
+	// Constants built from scratch are the same as the predefined ones
+	BOOST_CHECK(intConst(boolTy(), 1) == trueConst);
+	BOOST_CHECK(intConst(boolTy(), 0) == falseConst);
+}